@@ -0,0 +1,70 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+/* Axis aligned bounding box */
+struct AABB
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	AABB() = default;
+	AABB(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+	glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+	// half the surface area, enough to compare tree insertion costs
+	float getPerimeter() const
+	{
+		glm::vec3 size = max - min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	bool contains(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+	}
+
+	bool overlaps(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+	}
+
+	AABB expanded(float margin) const
+	{
+		return AABB(min - glm::vec3(margin), max + glm::vec3(margin));
+	}
+
+	static AABB combine(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+	}
+
+	// bounds of this box after transforming it, without transforming all eight corners
+	AABB transformed(const glm::mat4& matrix) const
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+		glm::mat3 absolute(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+		glm::vec3 extents = absolute * getExtents();
+		return AABB(center - extents, center + extents);
+	}
+
+	// slab test, inverseDirection is 1 / ray direction. returns the entry distance or -1 on a miss
+	float intersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) const
+	{
+		glm::vec3 t1 = (min - origin) * inverseDirection;
+		glm::vec3 t2 = (max - origin) * inverseDirection;
+		glm::vec3 tMin = glm::min(t1, t2);
+		glm::vec3 tMax = glm::max(t1, t2);
+		float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+		float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+		return enter <= exit ? enter : -1.0f;
+	}
+};
+
+#endif
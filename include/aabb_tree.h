@@ -0,0 +1,538 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include <aabb.h>
+#include <frustum.h>
+#include <worker_pool.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+/* Dynamic bounding volume hierarchy over scene objects, in the style of Box2D's b2DynamicTree.
+   Leaves store "fat" boxes enlarged by a margin, so objects that move a little do not touch
+   the tree at all. Insertion picks the sibling with the lowest surface area cost and every
+   insertion/removal rebalances the path to the root with AVL style rotations, keeping the
+   height logarithmic. Queries walk the tree, so their cost grows with the number of hits
+   and the tree height instead of the object count. */
+class AABBTree
+{
+public:
+	static constexpr int NULL_NODE = -1;
+
+	explicit AABBTree(float fatMargin = 0.1f)
+		: fatMargin(fatMargin)
+	{
+	}
+
+	// returns a proxy id that stays valid until destroyProxy
+	int createProxy(const AABB& aabb, int userData)
+	{
+		int proxyId = allocateNode();
+		nodes[proxyId].box = aabb.expanded(fatMargin);
+		nodes[proxyId].userData = userData;
+		nodes[proxyId].height = 0;
+		insertLeaf(proxyId);
+		proxyCount++;
+		return proxyId;
+	}
+
+	void destroyProxy(int proxyId)
+	{
+		removeLeaf(proxyId);
+		freeNode(proxyId);
+		proxyCount--;
+	}
+
+	// removes every proxy but keeps the node storage and refit scratch space, so filling
+	// the tree again does not allocate
+	void clear()
+	{
+		nodes.clear();
+		root = NULL_NODE;
+		freeList = NULL_NODE;
+		proxyCount = 0;
+	}
+
+	// returns true if the proxy had to be reinserted. the displacement of the last step
+	// stretches the fat box in the direction of motion to predict the next one
+	bool moveProxy(int proxyId, const AABB& aabb, const glm::vec3& displacement = glm::vec3(0.0f))
+	{
+		if (nodes[proxyId].box.contains(aabb))
+			return false;
+
+		removeLeaf(proxyId);
+		AABB fat = aabb.expanded(fatMargin);
+		glm::vec3 predicted = DISPLACEMENT_MULTIPLIER * displacement;
+		fat.min = glm::min(fat.min, fat.min + predicted);
+		fat.max = glm::max(fat.max, fat.max + predicted);
+		nodes[proxyId].box = fat;
+		insertLeaf(proxyId);
+		return true;
+	}
+
+	/* Updates many moving proxies at once. Classifying the new boxes runs in parallel:
+	   proxies still inside their fat box are skipped, proxies that only slightly outgrew
+	   it are refit in place, and the rest are reinserted. In-place refits then update the
+	   affected ancestors bottom-up, one tree level at a time with the nodes of the wide
+	   levels processed in parallel, which is much cheaper than reinserting each proxy */
+	void refitProxies(const std::vector<int>& proxyIds, const std::vector<AABB>& aabbs)
+	{
+		size_t count = std::min(proxyIds.size(), aabbs.size());
+		refitActions.resize(count);
+		WorkerPool::shared().parallelFor(count, PARALLEL_BATCH_SIZE, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				const AABB& fat = nodes[proxyIds[i]].box;
+				if (fat.contains(aabbs[i]))
+					refitActions[i] = ACTION_KEEP;
+				else if (fat.expanded(fatMargin * REFIT_SLACK).contains(aabbs[i]))
+					refitActions[i] = ACTION_REFIT;
+				else
+					refitActions[i] = ACTION_REINSERT;
+			}
+		});
+
+		// reinsertions change the structure, so they run before any ancestor is refit
+		for (size_t i = 0; i < count; i++)
+		{
+			if (refitActions[i] != ACTION_REINSERT)
+				continue;
+			removeLeaf(proxyIds[i]);
+			nodes[proxyIds[i]].box = aabbs[i].expanded(fatMargin);
+			insertLeaf(proxyIds[i]);
+		}
+
+		// mark every ancestor of a refit leaf once, grouped by height
+		refitEpoch++;
+		for (std::vector<int>& level : refitLevels)
+			level.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (refitActions[i] != ACTION_REFIT)
+				continue;
+			nodes[proxyIds[i]].box = aabbs[i].expanded(fatMargin);
+			for (int index = nodes[proxyIds[i]].parent; index != NULL_NODE && nodes[index].refitEpoch != refitEpoch; index = nodes[index].parent)
+			{
+				nodes[index].refitEpoch = refitEpoch;
+				if ((size_t)nodes[index].height >= refitLevels.size())
+					refitLevels.resize(nodes[index].height + 1);
+				refitLevels[nodes[index].height].push_back(index);
+			}
+		}
+
+		// children always have a lower height than their parent, so a level only reads
+		// boxes that earlier levels already finished. the wide levels near the leaves are
+		// split between the same pool threads, which wait for each other before moving up
+		// a level; the narrow ones above them are refit on this thread
+		size_t parallelLevels = 0;
+		size_t widestLevel = 0;
+		for (size_t height = 0; height < refitLevels.size(); height++)
+			if (refitLevels[height].size() >= PARALLEL_BATCH_SIZE)
+			{
+				parallelLevels = height + 1;
+				widestLevel = std::max(widestLevel, refitLevels[height].size());
+			}
+		WorkerPool& pool = WorkerPool::shared();
+		size_t threadCount = pool.threadsFor(widestLevel, PARALLEL_BATCH_SIZE);
+		if (threadCount > 1)
+		{
+			WorkerBarrier levelDone(threadCount);
+			pool.run(threadCount, [&](size_t thread) {
+				for (size_t height = 0; height < parallelLevels; height++)
+				{
+					const std::vector<int>& level = refitLevels[height];
+					refitNodes(level, level.size() * thread / threadCount, level.size() * (thread + 1) / threadCount);
+					if (height + 1 < parallelLevels)
+						levelDone.wait();
+				}
+			});
+		}
+		else
+			parallelLevels = 0;
+		for (size_t height = parallelLevels; height < refitLevels.size(); height++)
+			refitNodes(refitLevels[height], 0, refitLevels[height].size());
+	}
+
+	int getUserData(int proxyId) const { return nodes[proxyId].userData; }
+	const AABB& getFatAABB(int proxyId) const { return nodes[proxyId].box; }
+	int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+	size_t getProxyCount() const { return proxyCount; }
+
+	// calls callback(proxyId) for every proxy whose fat box touches the frustum.
+	// subtrees completely inside the frustum are accepted without further plane tests
+	template <typename Callback>
+	void queryFrustum(const Frustum& frustum, Callback callback) const
+	{
+		int stack[STACK_SIZE];
+		int stackSize = 0;
+		if (root != NULL_NODE)
+			stack[stackSize++] = root;
+		while (stackSize > 0)
+		{
+			int index = stack[--stackSize];
+			const Node& node = nodes[index];
+			Frustum::Containment containment = frustum.classifyAABB(node.box.min, node.box.max);
+			if (containment == Frustum::OUTSIDE)
+				continue;
+			if (containment == Frustum::INSIDE)
+				visitLeaves(index, callback);
+			else if (node.isLeaf())
+				callback(index);
+			else
+			{
+				stack[stackSize++] = node.child1;
+				stack[stackSize++] = node.child2;
+			}
+		}
+	}
+
+	// calls callback(proxyId) for every proxy whose fat box overlaps aabb, until it returns false
+	template <typename Callback>
+	void queryAABB(const AABB& aabb, Callback callback) const
+	{
+		int stack[STACK_SIZE];
+		int stackSize = 0;
+		if (root != NULL_NODE)
+			stack[stackSize++] = root;
+		while (stackSize > 0)
+		{
+			int index = stack[--stackSize];
+			const Node& node = nodes[index];
+			if (!node.box.overlaps(aabb))
+				continue;
+			if (node.isLeaf())
+			{
+				if (!callback(index))
+					return;
+			}
+			else
+			{
+				stack[stackSize++] = node.child1;
+				stack[stackSize++] = node.child2;
+			}
+		}
+	}
+
+	/* Calls callback(proxyId, maxDistance) for proxies whose fat box the ray hits, roughly
+	   nearest first. The callback returns the new maximum distance: the hit distance to
+	   clip the ray, maxDistance to ignore the proxy, or 0 to stop */
+	template <typename Callback>
+	void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback callback) const
+	{
+		glm::vec3 inverseDirection = 1.0f / direction;
+		int stack[STACK_SIZE];
+		int stackSize = 0;
+		if (root != NULL_NODE)
+			stack[stackSize++] = root;
+		while (stackSize > 0)
+		{
+			int index = stack[--stackSize];
+			const Node& node = nodes[index];
+			if (node.box.intersectRay(origin, inverseDirection, maxDistance) < 0.0f)
+				continue;
+			if (node.isLeaf())
+			{
+				maxDistance = callback(index, maxDistance);
+				if (maxDistance <= 0.0f)
+					return;
+				continue;
+			}
+			// push the farther child first so the nearer one is visited first
+			float distance1 = nodes[node.child1].box.intersectRay(origin, inverseDirection, maxDistance);
+			float distance2 = nodes[node.child2].box.intersectRay(origin, inverseDirection, maxDistance);
+			bool firstIsNearer = distance1 >= 0.0f && (distance2 < 0.0f || distance1 <= distance2);
+			stack[stackSize++] = firstIsNearer ? node.child2 : node.child1;
+			stack[stackSize++] = firstIsNearer ? node.child1 : node.child2;
+		}
+	}
+
+private:
+	struct Node
+	{
+		AABB box;
+		int parent = NULL_NODE; // next free node while on the free list
+		int child1 = NULL_NODE;
+		int child2 = NULL_NODE;
+		int height = -1; // leaves are 0, free nodes -1
+		int userData = 0;
+		unsigned int refitEpoch = 0;
+
+		bool isLeaf() const { return child1 == NULL_NODE; }
+	};
+
+	enum RefitAction : unsigned char { ACTION_KEEP, ACTION_REFIT, ACTION_REINSERT };
+
+	// the tree is kept balanced, so its height stays far below this for any realistic scene
+	static constexpr int STACK_SIZE = 256;
+	static constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+	// how far past the fat margin a box may grow before it is reinserted instead of refit
+	static constexpr float REFIT_SLACK = 2.0f;
+	static constexpr size_t PARALLEL_BATCH_SIZE = 2048;
+
+	std::vector<Node> nodes;
+	int root = NULL_NODE;
+	int freeList = NULL_NODE;
+	size_t proxyCount = 0;
+	float fatMargin;
+
+	// scratch space reused by refitProxies
+	std::vector<RefitAction> refitActions;
+	std::vector<std::vector<int>> refitLevels;
+	unsigned int refitEpoch = 0;
+
+	int allocateNode()
+	{
+		if (freeList == NULL_NODE)
+		{
+			nodes.emplace_back();
+			return (int)nodes.size() - 1;
+		}
+		int index = freeList;
+		freeList = nodes[index].parent;
+		nodes[index] = Node();
+		return index;
+	}
+
+	void freeNode(int index)
+	{
+		nodes[index].parent = freeList;
+		nodes[index].height = -1;
+		freeList = index;
+	}
+
+	template <typename Callback>
+	void visitLeaves(int subtree, Callback& callback) const
+	{
+		int stack[STACK_SIZE];
+		int stackSize = 0;
+		stack[stackSize++] = subtree;
+		while (stackSize > 0)
+		{
+			int index = stack[--stackSize];
+			const Node& node = nodes[index];
+			if (node.isLeaf())
+			{
+				callback(index);
+				continue;
+			}
+			stack[stackSize++] = node.child1;
+			stack[stackSize++] = node.child2;
+		}
+	}
+
+	// recomputes the boxes of nodes[level[begin..end)] from their children
+	void refitNodes(const std::vector<int>& level, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Node& node = nodes[level[i]];
+			node.box = AABB::combine(nodes[node.child1].box, nodes[node.child2].box);
+		}
+	}
+
+	void insertLeaf(int leaf)
+	{
+		if (root == NULL_NODE)
+		{
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		// find the best sibling by descending towards the cheapest surface area increase
+		AABB leafBox = nodes[leaf].box;
+		int index = root;
+		while (!nodes[index].isLeaf())
+		{
+			int child1 = nodes[index].child1;
+			int child2 = nodes[index].child2;
+			float area = nodes[index].box.getPerimeter();
+			float combinedArea = AABB::combine(nodes[index].box, leafBox).getPerimeter();
+
+			// cost of creating a new parent for this node and the new leaf
+			float cost = 2.0f * combinedArea;
+			// minimum cost of pushing the leaf further down the tree
+			float inheritanceCost = 2.0f * (combinedArea - area);
+			float cost1 = descendCost(child1, leafBox) + inheritanceCost;
+			float cost2 = descendCost(child2, leafBox) + inheritanceCost;
+
+			if (cost < cost1 && cost < cost2)
+				break;
+			index = cost1 < cost2 ? child1 : child2;
+		}
+		int sibling = index;
+
+		// create a new parent holding the sibling and the leaf
+		int oldParent = nodes[sibling].parent;
+		int newParent = allocateNode();
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].box = AABB::combine(leafBox, nodes[sibling].box);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+		if (oldParent == NULL_NODE)
+			root = newParent;
+		else if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+
+		fixUpwards(nodes[leaf].parent);
+	}
+
+	void removeLeaf(int leaf)
+	{
+		if (leaf == root)
+		{
+			root = NULL_NODE;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grandParent = nodes[parent].parent;
+		int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		// the sibling takes the place of the parent
+		if (grandParent == NULL_NODE)
+		{
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			freeNode(parent);
+			return;
+		}
+		if (nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+		nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		fixUpwards(grandParent);
+	}
+
+	float descendCost(int child, const AABB& leafBox) const
+	{
+		float combinedArea = AABB::combine(leafBox, nodes[child].box).getPerimeter();
+		if (nodes[child].isLeaf())
+			return combinedArea;
+		return combinedArea - nodes[child].box.getPerimeter();
+	}
+
+	// rebalances and refits every node from index up to the root
+	void fixUpwards(int index)
+	{
+		while (index != NULL_NODE)
+		{
+			index = balance(index);
+			Node& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+			node.box = AABB::combine(nodes[node.child1].box, nodes[node.child2].box);
+			index = node.parent;
+		}
+	}
+
+	// rotates the taller grandchild of A up if its children differ in height by more
+	// than one, returns the index of the node that now sits where A was
+	int balance(int iA)
+	{
+		Node& A = nodes[iA];
+		if (A.isLeaf() || A.height < 2)
+			return iA;
+
+		int iB = A.child1;
+		int iC = A.child2;
+		Node& B = nodes[iB];
+		Node& C = nodes[iC];
+		int heightDifference = C.height - B.height;
+
+		if (heightDifference > 1)
+		{
+			// rotate C up
+			int iF = C.child1;
+			int iG = C.child2;
+			Node& F = nodes[iF];
+			Node& G = nodes[iG];
+
+			C.child1 = iA;
+			C.parent = A.parent;
+			A.parent = iC;
+			replaceChild(C.parent, iA, iC);
+
+			if (F.height > G.height)
+			{
+				C.child2 = iF;
+				A.child2 = iG;
+				G.parent = iA;
+				A.box = AABB::combine(B.box, G.box);
+				C.box = AABB::combine(A.box, F.box);
+				A.height = 1 + std::max(B.height, G.height);
+				C.height = 1 + std::max(A.height, F.height);
+			}
+			else
+			{
+				C.child2 = iG;
+				A.child2 = iF;
+				F.parent = iA;
+				A.box = AABB::combine(B.box, F.box);
+				C.box = AABB::combine(A.box, G.box);
+				A.height = 1 + std::max(B.height, F.height);
+				C.height = 1 + std::max(A.height, G.height);
+			}
+			return iC;
+		}
+
+		if (heightDifference < -1)
+		{
+			// rotate B up
+			int iD = B.child1;
+			int iE = B.child2;
+			Node& D = nodes[iD];
+			Node& E = nodes[iE];
+
+			B.child1 = iA;
+			B.parent = A.parent;
+			A.parent = iB;
+			replaceChild(B.parent, iA, iB);
+
+			if (D.height > E.height)
+			{
+				B.child2 = iD;
+				A.child1 = iE;
+				E.parent = iA;
+				A.box = AABB::combine(C.box, E.box);
+				B.box = AABB::combine(A.box, D.box);
+				A.height = 1 + std::max(C.height, E.height);
+				B.height = 1 + std::max(A.height, D.height);
+			}
+			else
+			{
+				B.child2 = iE;
+				A.child1 = iD;
+				D.parent = iA;
+				A.box = AABB::combine(C.box, D.box);
+				B.box = AABB::combine(A.box, E.box);
+				A.height = 1 + std::max(C.height, D.height);
+				B.height = 1 + std::max(A.height, E.height);
+			}
+			return iB;
+		}
+
+		return iA;
+	}
+
+	void replaceChild(int parent, int oldChild, int newChild)
+	{
+		if (parent == NULL_NODE)
+			root = newChild;
+		else if (nodes[parent].child1 == oldChild)
+			nodes[parent].child1 = newChild;
+		else
+			nodes[parent].child2 = newChild;
+	}
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef BENCHMARK_BASELINE_H
+#define BENCHMARK_BASELINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* One measured quantity of a benchmark scene. Timings are the median over several runs with
+   noise a robust estimate of their run to run standard deviation. Counters are exact for a
+   fixed camera path, their noise is 0 */
+struct BenchmarkMetric
+{
+	enum Kind { KIND_TIME, KIND_COUNT };
+
+	std::string scene;
+	std::string name;
+	Kind kind;
+	double value;
+	double noise;
+};
+
+/* Stored results of a known good build and the comparison of a new run against them.
+   File layout, one metric per line: "scene name time|count value noise", '#' starts a comment.
+   A timing regresses when it grew by more than the largest of
+    - relativeTolerance of the baseline, for the drift between processes (clocks, caches,
+      driver threads) that the run to run noise of a single process does not show
+    - noiseSigmas standard deviations of the combined baseline and current noise
+    - absoluteTolerance milliseconds, below which timer resolution dominates
+   a counter regresses when it grew at all. Metrics of the baseline that were not measured
+   count as regressions too, so a scene that fails to run fails the comparison. Timings only
+   compare on the machine that recorded the baseline. */
+class BenchmarkBaseline
+{
+public:
+	std::vector<BenchmarkMetric> metrics;
+	double relativeTolerance = 0.1;
+	double noiseSigmas = 3.0;
+	double absoluteTolerance = 0.05;
+
+	bool load(const char* path)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK_BASELINE::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return false;
+		}
+		metrics.clear();
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+			std::istringstream fields(line);
+			BenchmarkMetric metric;
+			std::string kind;
+			if (!(fields >> metric.scene >> metric.name >> kind >> metric.value >> metric.noise))
+			{
+				std::cout << "ERROR::BENCHMARK_BASELINE::INVALID_LINE " << line << std::endl;
+				return false;
+			}
+			metric.kind = kind == "count" ? BenchmarkMetric::KIND_COUNT : BenchmarkMetric::KIND_TIME;
+			metrics.push_back(metric);
+		}
+		return true;
+	}
+
+	static bool save(const char* path, const std::vector<BenchmarkMetric>& metrics)
+	{
+		std::ofstream file(path);
+		file << "# scene metric kind value noise\n";
+		char line[256];
+		for (const BenchmarkMetric& metric : metrics)
+		{
+			// counters keep every digit, a rounded value would count as a change
+			bool counter = metric.kind == BenchmarkMetric::KIND_COUNT;
+			std::snprintf(line, sizeof(line), counter ? "%s %s %s %.17g %.6g\n" : "%s %s %s %.6g %.6g\n",
+				metric.scene.c_str(), metric.name.c_str(), counter ? "count" : "time", metric.value, metric.noise);
+			file << line;
+		}
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK_BASELINE::FILE_NOT_SUCCESFULLY_WRITTEN " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	const BenchmarkMetric* find(const std::string& scene, const std::string& name) const
+	{
+		for (const BenchmarkMetric& metric : metrics)
+			if (metric.scene == scene && metric.name == name)
+				return &metric;
+		return NULL;
+	}
+
+	// prints a line per metric, returns the number of regressions
+	unsigned int compare(const std::vector<BenchmarkMetric>& current) const
+	{
+		unsigned int regressions = 0;
+		char line[256];
+		for (const BenchmarkMetric& metric : current)
+		{
+			const BenchmarkMetric* baseline = find(metric.scene, metric.name);
+			if (baseline == NULL)
+			{
+				std::snprintf(line, sizeof(line), "  %-16s %-16s %12.4f  (no baseline)", metric.scene.c_str(), metric.name.c_str(), metric.value);
+				std::cout << line << std::endl;
+				continue;
+			}
+			double allowed = 0.0;
+			if (metric.kind == BenchmarkMetric::KIND_TIME)
+			{
+				double noise = std::sqrt(baseline->noise * baseline->noise + metric.noise * metric.noise);
+				allowed = std::max(std::max(relativeTolerance * baseline->value, noiseSigmas * noise), absoluteTolerance);
+			}
+			double change = metric.value - baseline->value;
+			const char* verdict = "ok";
+			if (change > allowed)
+			{
+				verdict = "REGRESSION";
+				regressions++;
+			}
+			else if (-change > allowed && change != 0.0)
+				verdict = "improved";
+			double percent = baseline->value != 0.0 ? 100.0 * change / baseline->value : 0.0;
+			std::snprintf(line, sizeof(line), "  %-16s %-16s %12.4f -> %12.4f  %+7.1f%%  (allowed +%.4f)  %s",
+				metric.scene.c_str(), metric.name.c_str(), baseline->value, metric.value, percent, allowed, verdict);
+			std::cout << line << std::endl;
+		}
+		for (const BenchmarkMetric& metric : metrics)
+		{
+			bool measured = std::any_of(current.begin(), current.end(), [&](const BenchmarkMetric& other) {
+				return other.scene == metric.scene && other.name == metric.name;
+			});
+			if (!measured)
+			{
+				std::cout << "  " << metric.scene << " " << metric.name << " not measured  REGRESSION" << std::endl;
+				regressions++;
+			}
+		}
+		return regressions;
+	}
+
+	static double median(std::vector<double> values)
+	{
+		if (values.empty())
+			return 0.0;
+		size_t middle = values.size() / 2;
+		std::nth_element(values.begin(), values.begin() + middle, values.end());
+		double upper = values[middle];
+		if (values.size() % 2 == 1)
+			return upper;
+		double lower = *std::max_element(values.begin(), values.begin() + middle);
+		return 0.5 * (lower + upper);
+	}
+
+	// standard deviation estimated from the median absolute deviation, a single outlier run
+	// barely moves it
+	static double robustDeviation(const std::vector<double>& values)
+	{
+		double center = median(values);
+		std::vector<double> deviations(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+			deviations[i] = std::abs(values[i] - center);
+		return 1.4826 * median(deviations);
+	}
+};
+
+#endif
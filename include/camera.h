@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <frustum.h>
 
 #include <vector>
 
@@ -20,25 +22,26 @@ const float PITCH = 0.0f;   // rotation around x axis (horizontal)
 const float SPEED = 2.5f;
 const float SENSITIVITY = 0.1f; // mouse movement diff multiplier
 const float ZOOM = 45.0f;
+const float ASPECT_RATIO = 800.0f / 600.0f;
+const float NEAR_PLANE = 0.1f; // view area starting z coord
+const float FAR_PLANE = 100.0f; // view area ending z coord
 
+enum class Projection_Mode {
+	STANDARD,          // OpenGL [-1, 1] depth between the near and far planes
+	REVERSE_Z_INFINITE // [0, 1] depth with 1 at the near plane and 0 at infinity
+};
+
+/* Orientation is stored as a quaternion built from the yaw/pitch angles. Derived data
+   (direction vectors, view, projection, view-projection and frustum) is only recomputed
+   when queried after something changed, so input events just accumulate angles.
+   GetVersion() changes whenever any derived matrix would, so callers can skip
+   uploading or culling against an unchanged camera. */
 class Camera
 {
 public:
-	// camera Attributes
-	glm::vec3 Position;
-	glm::vec3 Front;
-	glm::vec3 Up;
-	glm::vec3 Right;
-	glm::vec3 WorldUp;
-
-	// euler angles
-	float Yaw;
-	float Pitch;
-
 	// camera options
 	float MovementSpeed;
 	float MouseSensitivity;
-	float Zoom;
 
 	// constructor with vectors
 	Camera(
@@ -47,16 +50,13 @@ public:
 		float yaw = YAW,
 		float pitch = PITCH
 	)
-		: Front(glm::vec3(0.0f, 0.0f, -1.0f)),
-		MovementSpeed(SPEED),
+		: MovementSpeed(SPEED),
 		MouseSensitivity(SENSITIVITY),
-		Zoom(ZOOM)
+		Position(position),
+		WorldUp(up),
+		Yaw(yaw),
+		Pitch(pitch)
 	{
-		Position = position;
-		WorldUp = up;
-		Yaw = yaw;
-		Pitch = pitch;
-		updateCameraVectors();
 	}
 
 	// constructor with scalar values
@@ -70,27 +70,116 @@ public:
 		float yaw,
 		float pitch
 	)
-		: Front(glm::vec3(0.0f, 0.0f, -1.0f)),
-		MovementSpeed(SPEED),
-		MouseSensitivity(SENSITIVITY),
-		Zoom(ZOOM)
+		: Camera(glm::vec3(posX, posY, posZ), glm::vec3(upX, upY, upZ), yaw, pitch)
+	{
+	}
+
+	// returns the view matrix calculated from the orientation quaternion
+	const glm::mat4& GetViewMatrix()
+	{
+		if (viewDirty)
+		{
+			updateOrientation();
+			// inverse of the camera transform: rotate by the conjugate, then undo the translation
+			View = glm::mat4_cast(glm::conjugate(Orientation)) * glm::translate(glm::mat4(1.0f), -Position);
+			viewDirty = false;
+		}
+		return View;
+	}
+
+	const glm::mat4& GetProjectionMatrix()
+	{
+		if (projectionDirty)
+		{
+			if (Mode == Projection_Mode::REVERSE_Z_INFINITE)
+				Projection = reverseZInfinitePerspective(glm::radians(Zoom), AspectRatio, NearPlane);
+			else
+				Projection = glm::perspective(glm::radians(Zoom), AspectRatio, NearPlane, FarPlane);
+			projectionDirty = false;
+		}
+		return Projection;
+	}
+
+	const glm::mat4& GetViewProjectionMatrix()
+	{
+		if (viewProjectionDirty)
+		{
+			ViewProjection = GetProjectionMatrix() * GetViewMatrix();
+			CameraFrustum = Frustum(ViewProjection, Mode == Projection_Mode::REVERSE_Z_INFINITE);
+			viewProjectionDirty = false;
+		}
+		return ViewProjection;
+	}
+
+	const Frustum& GetFrustum()
+	{
+		GetViewProjectionMatrix();
+		return CameraFrustum;
+	}
+
+	// incremented on every change that affects the view or projection
+	unsigned int GetVersion() const
+	{
+		return Version;
+	}
+
+	const glm::vec3& GetPosition() const { return Position; }
+	const glm::quat& GetOrientation() { updateOrientation(); return Orientation; }
+	const glm::vec3& GetFront() { updateOrientation(); return Front; }
+	const glm::vec3& GetRight() { updateOrientation(); return Right; }
+	const glm::vec3& GetUp() { updateOrientation(); return Up; }
+	float GetYaw() const { return Yaw; }
+	float GetPitch() const { return Pitch; }
+	float GetZoom() const { return Zoom; }
+	float GetNearPlane() const { return NearPlane; }
+	float GetFarPlane() const { return FarPlane; }
+	Projection_Mode GetProjectionMode() const { return Mode; }
+
+	void SetPosition(const glm::vec3& position)
+	{
+		Position = position;
+		markViewDirty();
+	}
+
+	void SetOrientation(float yaw, float pitch)
 	{
-		Position = glm::vec3(posX, posY, posZ);
-		WorldUp = glm::vec3(upX, upY, upZ);
 		Yaw = yaw;
 		Pitch = pitch;
-		updateCameraVectors();
+		orientationDirty = true;
+		markViewDirty();
 	}
 
-	// returns the view matrix calculated using Euler Angles and the LookAt Matrix
-	glm::mat4 GetViewMatrix()
+	void SetZoom(float zoom)
 	{
-		return glm::lookAt(Position, Position + Front, Up);
+		Zoom = zoom;
+		markProjectionDirty();
+	}
+
+	// must be called when the framebuffer is resized
+	void SetAspectRatio(float aspectRatio)
+	{
+		AspectRatio = aspectRatio;
+		markProjectionDirty();
+	}
+
+	void SetClipPlanes(float nearPlane, float farPlane)
+	{
+		NearPlane = nearPlane;
+		FarPlane = farPlane;
+		markProjectionDirty();
+	}
+
+	// reverse-Z needs glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE), a depth clear of 0 and GL_GREATER
+	void SetProjectionMode(Projection_Mode mode)
+	{
+		Mode = mode;
+		markProjectionDirty();
 	}
 
 	// processes input recieved from keyboard
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
+		updateOrientation();
 		float velocity = MovementSpeed * deltaTime;
 		if (direction == Camera_Movement::FORWARD)
 			Position += Front * velocity;
@@ -100,6 +189,7 @@ public:
 			Position -= Right * velocity;
 		if (direction == Camera_Movement::RIGHT)
 			Position += Right * velocity;
+		markViewDirty();
 	}
 
 	// processes input received from a mouse input system
@@ -119,7 +209,9 @@ public:
 				Pitch = -89.0f;
 		}
 
-		updateCameraVectors();
+		// the orientation is rebuilt once when next queried instead of on every event
+		orientationDirty = true;
+		markViewDirty();
 	}
 
 	// processes input received from a mouse scroll-wheel event
@@ -130,19 +222,81 @@ public:
 			Zoom = 1.0f;
 		if (Zoom > 45.0f)
 			Zoom = 45.0f;
+		markProjectionDirty();
 	}
 
 private:
-	void updateCameraVectors() {
-		// calculate the new Front vector
-		glm::vec3 front;
-		front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-		front.y = sin(glm::radians(Pitch));
-		front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-		Front = glm::normalize(front);
-		// recalculate Right and Up vectors
-		Right = glm::normalize(glm::cross(Front, WorldUp));
-		Up = glm::normalize(glm::cross(Right, Front));
+	// camera Attributes
+	glm::vec3 Position;
+	glm::quat Orientation;
+	glm::vec3 Front;
+	glm::vec3 Up;
+	glm::vec3 Right;
+	glm::vec3 WorldUp;
+
+	// euler angles, kept to clamp the pitch
+	float Yaw;
+	float Pitch;
+
+	// projection options
+	float Zoom = ZOOM;
+	float AspectRatio = ASPECT_RATIO;
+	float NearPlane = NEAR_PLANE;
+	float FarPlane = FAR_PLANE; // ignored by the infinite projection
+	Projection_Mode Mode = Projection_Mode::STANDARD;
+
+	// cached matrices
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::mat4 ViewProjection;
+	Frustum CameraFrustum;
+
+	bool orientationDirty = true;
+	bool viewDirty = true;
+	bool projectionDirty = true;
+	bool viewProjectionDirty = true;
+	unsigned int Version = 1;
+
+	void markViewDirty()
+	{
+		viewDirty = true;
+		viewProjectionDirty = true;
+		Version++;
+	}
+
+	void markProjectionDirty()
+	{
+		projectionDirty = true;
+		viewProjectionDirty = true;
+		Version++;
+	}
+
+	// float depth precision is densest near 0, which reverse-Z maps to far away geometry,
+	// so depth stays precise across the whole range and no far plane is needed
+	static glm::mat4 reverseZInfinitePerspective(float fovy, float aspect, float zNear)
+	{
+		float f = 1.0f / tan(fovy / 2.0f);
+		glm::mat4 result(0.0f);
+		result[0][0] = f / aspect;
+		result[1][1] = f;
+		result[2][3] = -1.0f; // w = -z
+		result[3][2] = zNear; // depth = near / -z
+		return result;
+	}
+
+	void updateOrientation()
+	{
+		if (!orientationDirty)
+			return;
+		// yaw turns around the world up axis and pitch around the camera's local x axis.
+		// the identity orientation looks down -z, which matches a yaw of -90 degrees
+		glm::quat yawRotation = glm::angleAxis(glm::radians(-(Yaw - YAW)), WorldUp);
+		glm::quat pitchRotation = glm::angleAxis(glm::radians(Pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+		Orientation = glm::normalize(yawRotation * pitchRotation);
+		Front = Orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+		Right = Orientation * glm::vec3(1.0f, 0.0f, 0.0f);
+		Up = Orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+		orientationDirty = false;
 	}
 };
 #endif
@@ -0,0 +1,150 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <camera.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+/* A recorded camera flight for benchmarks and regression captures. Keyframes hold the camera
+   state rather than the input that produced it, so a played path gives the same views no
+   matter the frame rate, mouse sensitivity or window size of the run that recorded it.
+   File layout, little endian: a CameraPathHeader, then keyframeCount CameraKeyframe records
+   of 28 bytes, about 100 KB per minute recorded at 60 Hz. */
+const uint32_t CAMERA_PATH_MAGIC = 0x48544150; // "PATH"
+const uint32_t CAMERA_PATH_VERSION = 1;
+
+struct CameraPathHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t keyframeCount;
+};
+
+struct CameraKeyframe
+{
+	float time; // seconds since the recording started, increasing
+	float position[3];
+	float yaw;
+	float pitch;
+	float zoom;
+};
+
+class CameraPath
+{
+public:
+	void clear()
+	{
+		keyframes.clear();
+	}
+
+	bool empty() const
+	{
+		return keyframes.empty();
+	}
+
+	float getDuration() const
+	{
+		return keyframes.empty() ? 0.0f : keyframes.back().time;
+	}
+
+	// keyframes older than the last one are dropped, a recording never goes back in time
+	void record(float time, const Camera& camera)
+	{
+		if (!keyframes.empty() && time <= keyframes.back().time)
+			return;
+		const glm::vec3& position = camera.GetPosition();
+		keyframes.push_back({ time, { position.x, position.y, position.z }, camera.GetYaw(), camera.GetPitch(), camera.GetZoom() });
+	}
+
+	/* Moves the camera to the state at time, interpolated linearly between the keyframes
+	   around it. Returns false once time is past the end, the camera then stays at the
+	   last keyframe */
+	bool apply(float time, Camera& camera) const
+	{
+		if (keyframes.empty())
+			return false;
+		// the first keyframe after time
+		auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+			[](float t, const CameraKeyframe& keyframe) { return t < keyframe.time; });
+		const CameraKeyframe& b = next == keyframes.end() ? keyframes.back() : *next;
+		const CameraKeyframe& a = next == keyframes.begin() ? b : *(next - 1);
+		float t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 0.0f;
+		t = std::min(std::max(t, 0.0f), 1.0f);
+
+		// yaw is not wrapped by Camera, so plain interpolation never takes the long way round
+		camera.SetPosition(glm::mix(glm::vec3(a.position[0], a.position[1], a.position[2]),
+			glm::vec3(b.position[0], b.position[1], b.position[2]), t));
+		camera.SetOrientation(glm::mix(a.yaw, b.yaw, t), glm::mix(a.pitch, b.pitch, t));
+		camera.SetZoom(glm::mix(a.zoom, b.zoom, t));
+		return time <= keyframes.back().time;
+	}
+
+	/* A path circling center at radius and height, always looking at center, sweeping
+	   degrees around it in duration seconds. Recorded at 60 Hz, for benchmarks without a
+	   recorded path */
+	static CameraPath orbit(const glm::vec3& center, float radius, float height, float degrees, float duration)
+	{
+		CameraPath path;
+		Camera camera;
+		unsigned int steps = std::max((unsigned int)(duration * 60.0f), 1u);
+		for (unsigned int i = 0; i <= steps; i++)
+		{
+			float t = (float)i / (float)steps;
+			float angle = glm::radians(degrees * t);
+			glm::vec3 position = center + glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+			glm::vec3 front = glm::normalize(center - position);
+			// the inverse of the yaw/pitch to front conversion in Camera, unwrapped so yaw
+			// never jumps by 360 degrees between two keyframes
+			float yaw = glm::degrees(std::atan2(front.z, front.x));
+			if (i > 0)
+				yaw += 360.0f * std::round((camera.GetYaw() - yaw) / 360.0f);
+			camera.SetPosition(position);
+			camera.SetOrientation(yaw, glm::degrees(std::asin(front.y)));
+			path.record(t * duration, camera);
+		}
+		return path;
+	}
+
+	bool save(const char* path) const
+	{
+		std::ofstream file(path, std::ios::binary);
+		CameraPathHeader header = { CAMERA_PATH_MAGIC, CAMERA_PATH_VERSION, (uint32_t)keyframes.size() };
+		if (!file.write((const char*)&header, sizeof(header))
+			|| !file.write((const char*)keyframes.data(), keyframes.size() * sizeof(CameraKeyframe)))
+		{
+			std::cout << "ERROR::CAMERA_PATH::FILE_NOT_SUCCESFULLY_WRITTEN " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool load(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		CameraPathHeader header;
+		if (!file.read((char*)&header, sizeof(header)) || header.magic != CAMERA_PATH_MAGIC || header.version != CAMERA_PATH_VERSION)
+		{
+			std::cout << "ERROR::CAMERA_PATH::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return false;
+		}
+		keyframes.resize(header.keyframeCount);
+		if (!file.read((char*)keyframes.data(), keyframes.size() * sizeof(CameraKeyframe)))
+		{
+			std::cout << "ERROR::CAMERA_PATH::FILE_TRUNCATED " << path << std::endl;
+			keyframes.clear();
+			return false;
+		}
+		return true;
+	}
+
+private:
+	std::vector<CameraKeyframe> keyframes;
+};
+
+#endif
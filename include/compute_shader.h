@@ -0,0 +1,100 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include "glad/glad.h"
+#include "shader_preprocessor.h"
+
+#include <string>
+#include <iostream>
+
+/* Program with a single compute stage. Needs OpenGL 4.3 */
+class ComputeShader
+{
+public:
+	// program ID, 0 if the shader failed to build
+	unsigned int ID = 0;
+
+	ComputeShader() = default;
+
+	// builds the program from a file, returns false if it failed to compile or link
+	bool load(const char* computePath)
+	{
+		ShaderPreprocessor preprocessor;
+		destroy();
+		ID = createProgram(preprocessor.process(computePath));
+		return ID != 0;
+	}
+
+	ComputeShader(const ComputeShader&) = delete;
+	ComputeShader& operator=(const ComputeShader&) = delete;
+
+	// must run on the thread owning the context, so it is not left to a destructor
+	void destroy()
+	{
+		if (ID != 0)
+			glDeleteProgram(ID);
+		ID = 0;
+	}
+
+	void use()
+	{
+		glUseProgram(ID);
+	}
+
+	void setInt(const char* name, int value) const
+	{
+		glUniform1i(glGetUniformLocation(ID, name), value);
+	}
+
+	void setUint(const char* name, unsigned int value) const
+	{
+		glUniform1ui(glGetUniformLocation(ID, name), value);
+	}
+
+	void setVec2(const char* name, float x, float y) const
+	{
+		glUniform2f(glGetUniformLocation(ID, name), x, y);
+	}
+
+	// dispatches enough groups of the given size to cover width x height invocations
+	static void dispatchCovering(unsigned int width, unsigned int height, unsigned int groupWidth, unsigned int groupHeight)
+	{
+		glDispatchCompute((width + groupWidth - 1) / groupWidth, (height + groupHeight - 1) / groupHeight, 1);
+	}
+
+private:
+	unsigned int createProgram(const std::string& computeCode)
+	{
+		const char* source = computeCode.c_str();
+		unsigned int shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		int success;
+		char infoLog[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		unsigned int program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glDeleteShader(shader);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::SHADER::PROGRAM::LINK_FAILED\n" << infoLog << std::endl;
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+};
+
+#endif
@@ -0,0 +1,370 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <aabb.h>
+#include <shader.h>
+#include <stream_buffer.h>
+#include <timing.h>
+#include <vertex_layout.h>
+#include <vertex_quantizer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct DebugVertex
+{
+	glm::vec3 position;
+	Unorm8x4 color;
+};
+
+using DebugVertexLayout = VertexLayout<DebugVertex,
+	VERTEX_ATTRIBUTE(DebugVertex, position),
+	VERTEX_ATTRIBUTE(DebugVertex, color)>;
+
+/* Immediate mode lines and wire shapes for debugging, callable from any thread.
+   - every thread appends to its own stream, guarded by a spin lock that only the flush ever
+     contends, so adding a shape costs little more than writing its vertices
+   - flush() runs on the render thread: it moves all streams into one buffer and draws them
+     with a single glDrawArrays(GL_LINES). Depth tested lines come first, the rest have their
+     depth forced to the near plane by the vertex shader so they are drawn on top
+   - the lines are written straight into a StreamBuffer, persistently mapped with OpenGL 4.4
+   - shapes without a duration are drawn by the next flush only, others stay on screen for
+     that many seconds */
+class DebugDraw
+{
+private:
+	struct ThreadStream;
+
+public:
+	static const size_t MAX_VERTICES = 1 << 20; // per frame, 512k lines
+
+	DebugDraw() : id(nextId()) {}
+
+	DebugDraw(const DebugDraw&) = delete;
+	DebugDraw& operator=(const DebugDraw&) = delete;
+
+	void line(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color, float duration = 0.0f, bool depthTest = true)
+	{
+		Unorm8x4 packed = packUnorm8x4(color);
+		LineBatch batch(*this, duration, depthTest);
+		batch.add(from, to, packed);
+	}
+
+	void box(const AABB& bounds, const glm::vec4& color, float duration = 0.0f, bool depthTest = true)
+	{
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; i++)
+			corners[i] = glm::vec3((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z);
+		boxEdges(corners, color, duration, depthTest);
+	}
+
+	// unit cube centered on the origin, placed by transform
+	void box(const glm::mat4& transform, const glm::vec4& color, float duration = 0.0f, bool depthTest = true)
+	{
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; i++)
+			corners[i] = glm::vec3(transform * glm::vec4((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f, 1.0f));
+		boxEdges(corners, color, duration, depthTest);
+	}
+
+	// three great circles
+	void sphere(const glm::vec3& center, float radius, const glm::vec4& color, float duration = 0.0f, bool depthTest = true)
+	{
+		const float step = 6.2831853f / (float)SPHERE_SEGMENTS;
+		Unorm8x4 packed = packUnorm8x4(color);
+		LineBatch batch(*this, duration, depthTest);
+		for (int i = 0; i < SPHERE_SEGMENTS; i++)
+		{
+			float c0 = radius * std::cos(step * i), s0 = radius * std::sin(step * i);
+			float c1 = radius * std::cos(step * (i + 1)), s1 = radius * std::sin(step * (i + 1));
+			batch.add(center + glm::vec3(c0, s0, 0.0f), center + glm::vec3(c1, s1, 0.0f), packed);
+			batch.add(center + glm::vec3(c0, 0.0f, s0), center + glm::vec3(c1, 0.0f, s1), packed);
+			batch.add(center + glm::vec3(0.0f, c0, s0), center + glm::vec3(0.0f, c1, s1), packed);
+		}
+	}
+
+	/* The frustum of a view-projection matrix. An infinite reverse-Z far plane is drawn at a
+	   depth of 0.001, a thousand times the near distance */
+	void frustum(const glm::mat4& viewProjection, bool reverseZ, const glm::vec4& color, float duration = 0.0f, bool depthTest = true)
+	{
+		glm::mat4 inverse = glm::inverse(viewProjection);
+		float nearDepth = reverseZ ? 1.0f : -1.0f;
+		float farDepth = reverseZ ? 0.001f : 1.0f;
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; i++)
+		{
+			glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? farDepth : nearDepth, 1.0f);
+			corners[i] = glm::vec3(corner) / corner.w;
+		}
+		boxEdges(corners, color, duration, depthTest);
+	}
+
+	// red, green and blue lines along the x, y and z axes of transform
+	void axes(const glm::mat4& transform, float length, float duration = 0.0f, bool depthTest = true)
+	{
+		glm::vec3 origin(transform[3]);
+		line(origin, origin + glm::vec3(transform[0]) * length, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), duration, depthTest);
+		line(origin, origin + glm::vec3(transform[1]) * length, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), duration, depthTest);
+		line(origin, origin + glm::vec3(transform[2]) * length, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), duration, depthTest);
+	}
+
+	/* GL side, render thread only */
+
+	void create(const char* vertexPath, const char* fragmentPath)
+	{
+		shader.reset(new Shader(vertexPath, fragmentPath));
+		buffer.create(MAX_VERTICES * sizeof(DebugVertex));
+
+		glGenVertexArrays(1, &VAO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.ID);
+		DebugVertexLayout::apply();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	void destroy()
+	{
+		if (VAO == 0)
+			return;
+		buffer.destroy();
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteProgram(shader->ID);
+		VAO = 0;
+	}
+
+	/* Keeps the calling thread's stream locked while lines are added, cheaper than calling
+	   line() once per line for large amounts. Do not call the other functions meanwhile */
+	class LineBatch
+	{
+	public:
+		LineBatch(DebugDraw& owner, float duration = 0.0f, bool depthTest = true)
+			: stream(owner.threadStream()), duration(duration), depth(depthTest ? 1 : 0)
+		{
+			stream.lock();
+		}
+
+		~LineBatch()
+		{
+			stream.unlock();
+		}
+
+		LineBatch(const LineBatch&) = delete;
+		LineBatch& operator=(const LineBatch&) = delete;
+
+		void add(const glm::vec3& from, const glm::vec3& to, Unorm8x4 color)
+		{
+			if (duration <= 0.0f)
+			{
+				DebugVertex* line = stream.appendLine(depth);
+				line[0] = { from, color };
+				line[1] = { to, color };
+				return;
+			}
+			stream.timed[depth].push_back({ { from, color }, duration });
+			stream.timed[depth].push_back({ { to, color }, duration });
+		}
+
+		void add(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color)
+		{
+			add(from, to, packUnorm8x4(color));
+		}
+
+	private:
+		ThreadStream& stream;
+		float duration;
+		int depth;
+	};
+
+	/* Draws everything added since the last flush plus the shapes that have not expired.
+	   Expects the target framebuffer bound, with the scene's depth for depth tested lines */
+	void flush(const glm::mat4& viewProjection, bool reverseZ)
+	{
+		// the streams are copied straight into the mapped buffer
+		DebugVertex* destination = (DebugVertex*)buffer.begin();
+		size_t dropped = 0;
+		double now = getSteadyTime();
+		size_t depthTestedCount, vertexCount;
+		{
+			std::lock_guard<std::mutex> guard(streamsMutex);
+			depthTestedCount = gatherVertices(1, now, destination, MAX_VERTICES, dropped);
+			vertexCount = depthTestedCount + gatherVertices(0, now, destination + depthTestedCount, MAX_VERTICES - depthTestedCount, dropped);
+		}
+		if (dropped > 0)
+			std::cout << "ERROR::DEBUG_DRAW::BUFFER_FULL dropped " << dropped << " vertices" << std::endl;
+		if (vertexCount == 0)
+			return;
+		GLint first = (GLint)(buffer.end(vertexCount * sizeof(DebugVertex)) / sizeof(DebugVertex));
+
+		shader->use();
+		glUniformMatrix4fv(glGetUniformLocation(shader->ID, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+		glUniform1i(glGetUniformLocation(shader->ID, "overlayStart"), first + (GLint)depthTestedCount);
+		glUniform1i(glGetUniformLocation(shader->ID, "reverseZ"), reverseZ);
+		glBindVertexArray(VAO);
+		glDrawArrays(GL_LINES, first, (GLsizei)vertexCount);
+		glBindVertexArray(0);
+		buffer.fence();
+	}
+
+private:
+	static const int SPHERE_SEGMENTS = 24;
+	static const size_t INITIAL_STREAM_VERTICES = 4096;
+	static const int STREAM_CACHE_SIZE = 4; // instances a thread finds its stream in without the lock
+
+	struct TimedVertex
+	{
+		DebugVertex vertex;
+		double expiry; // the duration until a flush picks it up, then seconds on the steady clock
+	};
+
+	/* Vertices added by one thread since the last flush */
+	struct ThreadStream
+	{
+		std::thread::id thread; // the one adding to it
+		std::atomic_flag busy = ATOMIC_FLAG_INIT;
+		// indexed by depth test. only the first counts[depth] vertices are in use, so the
+		// storage never shrinks and appending is a bounds check and two stores
+		std::vector<DebugVertex> vertices[2];
+		size_t counts[2] = { 0, 0 };
+		std::vector<TimedVertex> timed[2];
+
+		void lock()
+		{
+			while (busy.test_and_set(std::memory_order_acquire))
+				;
+		}
+
+		void unlock()
+		{
+			busy.clear(std::memory_order_release);
+		}
+
+		// room for the two vertices of a line
+		DebugVertex* appendLine(int depth)
+		{
+			std::vector<DebugVertex>& storage = vertices[depth];
+			if (counts[depth] + 2 > storage.size())
+				storage.resize(std::max(INITIAL_STREAM_VERTICES, storage.size() * 2));
+			DebugVertex* line = storage.data() + counts[depth];
+			counts[depth] += 2;
+			return line;
+		}
+	};
+
+	const unsigned int id; // tells instances apart in the thread local stream cache, never reused
+	std::mutex streamsMutex; // taken by flush and when a thread misses its stream cache
+	std::vector<std::unique_ptr<ThreadStream>> streams; // one per thread that added a shape
+
+	// render thread state
+	std::vector<TimedVertex> persistentLines[2]; // shapes with a duration, pairs of vertices
+	std::unique_ptr<Shader> shader;
+	StreamBuffer buffer;
+	unsigned int VAO = 0;
+
+	static unsigned int nextId()
+	{
+		static std::atomic<unsigned int> counter(0);
+		return ++counter;
+	}
+
+	ThreadStream& threadStream()
+	{
+		struct CachedStream
+		{
+			unsigned int owner;
+			ThreadStream* stream;
+		};
+		thread_local CachedStream cache[STREAM_CACHE_SIZE] = {};
+		thread_local int nextEntry = 0;
+		for (const CachedStream& entry : cache)
+			if (entry.owner == id)
+				return *entry.stream;
+
+		// a thread drawing into more instances than the cache holds finds its stream again
+		// here, so every thread has one stream per instance however often it switches
+		std::thread::id thread = std::this_thread::get_id();
+		ThreadStream* stream = NULL;
+		{
+			std::lock_guard<std::mutex> guard(streamsMutex);
+			for (std::unique_ptr<ThreadStream>& existing : streams)
+				if (existing->thread == thread)
+					stream = existing.get();
+			if (stream == NULL)
+			{
+				streams.emplace_back(new ThreadStream());
+				stream = streams.back().get();
+				stream->thread = thread;
+			}
+		}
+		cache[nextEntry] = { id, stream };
+		nextEntry = (nextEntry + 1) % STREAM_CACHE_SIZE;
+		return *stream;
+	}
+
+	void boxEdges(const glm::vec3 corners[8], const glm::vec4& color, float duration, bool depthTest)
+	{
+		// corner index bits are x, y and z, edges connect corners differing in one bit
+		static const int EDGES[12][2] = {
+			{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+			{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+			{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+		};
+		Unorm8x4 packed = packUnorm8x4(color);
+		LineBatch batch(*this, duration, depthTest);
+		for (const int* edge : EDGES)
+			batch.add(corners[edge[0]], corners[edge[1]], packed);
+	}
+
+	/* Copies the lines of one depth mode out of every stream, followed by the timed lines
+	   that have not expired. Returns the number of vertices written, what did not fit is
+	   added to dropped. streamsMutex must be held */
+	size_t gatherVertices(int depth, double now, DebugVertex* destination, size_t capacity, size_t& dropped)
+	{
+		size_t written = 0;
+		for (std::unique_ptr<ThreadStream>& stream : streams)
+		{
+			stream->lock();
+			size_t count = std::min(stream->counts[depth], capacity - written);
+			if (count > 0)
+				std::memcpy(destination + written, stream->vertices[depth].data(), count * sizeof(DebugVertex));
+			written += count;
+			dropped += stream->counts[depth] - count;
+			stream->counts[depth] = 0;
+			for (const TimedVertex& vertex : stream->timed[depth])
+				persistentLines[depth].push_back({ vertex.vertex, now + vertex.expiry });
+			stream->timed[depth].clear();
+			stream->unlock();
+		}
+
+		std::vector<TimedVertex>& lines = persistentLines[depth];
+		size_t kept = 0;
+		for (size_t i = 0; i < lines.size(); i += 2)
+		{
+			if (lines[i].expiry < now)
+				continue;
+			if (written + 2 <= capacity)
+			{
+				destination[written++] = lines[i].vertex;
+				destination[written++] = lines[i + 1].vertex;
+			}
+			else
+				dropped += 2;
+			lines[kept++] = lines[i];
+			lines[kept++] = lines[i + 1];
+		}
+		lines.resize(kept);
+		return written;
+	}
+};
+
+#endif
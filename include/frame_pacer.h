@@ -0,0 +1,137 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+#include <timing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Keeps the CPU from running ahead of the GPU and evens out frame times.
+   - a fence is inserted after every frame; before starting a new one the pacer waits on
+     the fence from maxFramesInFlight frames ago, so at most that many frames are queued
+     in the driver no matter how many it would allow
+   - with a target frame rate, the remaining frame time is slept away and the last
+     SPIN_THRESHOLD is spun, since OS sleeps overshoot by a millisecond or more
+   Frame times are accumulated with Welford's algorithm for a mean/variance report.
+   Must be used on the thread that owns the GL context. */
+class FramePacer
+{
+public:
+	FramePacer(unsigned int maxFramesInFlight, double targetFrameRate = 0.0)
+		: fences(std::max(maxFramesInFlight, 1u), (GLsync)0)
+	{
+		setTargetFrameRate(targetFrameRate);
+	}
+
+	~FramePacer()
+	{
+		for (GLsync fence : fences)
+			if (fence != 0)
+				glDeleteSync(fence);
+	}
+
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// 0 disables the frame rate cap, only the frames in flight limit applies
+	void setTargetFrameRate(double framesPerSecond)
+	{
+		targetFrameTime = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+	}
+
+	// waits until the GPU finished the frame that used this fence slot last time
+	void beginFrame()
+	{
+		GLsync& fence = fences[frameIndex % fences.size()];
+		if (fence == 0)
+			return;
+		// the flush bit makes sure the fence was actually submitted before sleeping on it
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+		if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+			std::cout << "ERROR::FRAME_PACER::FENCE_WAIT_FAILED" << std::endl;
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	// call right after the buffer swap
+	void endFrame()
+	{
+		fences[frameIndex % fences.size()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		frameIndex++;
+
+		if (targetFrameTime > 0.0)
+			waitUntil(lastFrameEnd + targetFrameTime);
+
+		double now = getSteadyTime();
+		if (lastFrameEnd > 0.0)
+			addSample(now - lastFrameEnd);
+		// catching up after a long stall would only produce a burst of short frames
+		lastFrameEnd = (targetFrameTime > 0.0 && now - lastFrameEnd < 2.0 * targetFrameTime)
+			? lastFrameEnd + targetFrameTime
+			: now;
+	}
+
+	unsigned long long getFrameCount() const { return sampleCount; }
+	double getMeanFrameTime() const { return mean; }
+	double getFrameTimeVariance() const { return sampleCount > 1 ? m2 / (double)(sampleCount - 1) : 0.0; }
+	double getMinFrameTime() const { return minFrameTime; }
+	double getMaxFrameTime() const { return maxFrameTime; }
+
+	void resetStatistics()
+	{
+		sampleCount = 0;
+		mean = m2 = 0.0;
+		minFrameTime = 1e9;
+		maxFrameTime = 0.0;
+	}
+
+	void printReport() const
+	{
+		std::cout << "FRAME_PACER frames: " << sampleCount
+			<< " mean: " << mean * 1000.0 << " ms"
+			<< " stddev: " << std::sqrt(getFrameTimeVariance()) * 1000.0 << " ms"
+			<< " min: " << (sampleCount > 0 ? minFrameTime * 1000.0 : 0.0) << " ms"
+			<< " max: " << maxFrameTime * 1000.0 << " ms" << std::endl;
+	}
+
+private:
+	static constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000000; // 1 second, only hit on a lost device
+	static constexpr double SPIN_THRESHOLD = 0.002;
+
+	std::vector<GLsync> fences;
+	unsigned long long frameIndex = 0;
+	double targetFrameTime = 0.0;
+	double lastFrameEnd = 0.0;
+
+	unsigned long long sampleCount = 0;
+	double mean = 0.0;
+	double m2 = 0.0;
+	double minFrameTime = 1e9;
+	double maxFrameTime = 0.0;
+
+	static void waitUntil(double deadline)
+	{
+		double remaining = deadline - getSteadyTime();
+		if (remaining > SPIN_THRESHOLD)
+			std::this_thread::sleep_for(std::chrono::duration<double>(remaining - SPIN_THRESHOLD));
+		while (getSteadyTime() < deadline)
+			std::this_thread::yield();
+	}
+
+	void addSample(double frameTime)
+	{
+		sampleCount++;
+		double delta = frameTime - mean;
+		mean += delta / (double)sampleCount;
+		m2 += delta * (frameTime - mean);
+		minFrameTime = std::min(minFrameTime, frameTime);
+		maxFrameTime = std::max(maxFrameTime, frameTime);
+	}
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/* Bounded hand-off of per-frame state from the simulation thread to the render thread.
+   The producer fills a slot while the consumer reads another one, so frame N+1 is built
+   while frame N is submitted. maxQueuedFrames caps how many finished frames may wait for
+   the render thread: 1 gives the lowest latency, higher values absorb frame time spikes.
+   Slots are reused so steady-state frames do not allocate. */
+template <typename T>
+class FramePipeline
+{
+public:
+	explicit FramePipeline(size_t maxQueuedFrames)
+		: maxQueuedFrames(maxQueuedFrames > 0 ? maxQueuedFrames : 1),
+		// one slot being written and one being read on top of the queued ones
+		slots(this->maxQueuedFrames + 2),
+		freeSlots(slots.size()),
+		readySlots(slots.size())
+	{
+		for (size_t i = 0; i < slots.size(); i++)
+			freeSlots.push_back(i);
+	}
+
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	// blocks while maxQueuedFrames frames are waiting to be rendered. the returned slot still
+	// holds whatever frame it carried last, so containers keep their capacity
+	T& beginWrite()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		slotFreed.wait(lock, [this]() { return closed || (readySlots.size() < maxQueuedFrames && !freeSlots.empty()); });
+		writeSlot = freeSlots.front();
+		freeSlots.pop_front();
+		return slots[writeSlot];
+	}
+
+	void endWrite()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			readySlots.push_back(writeSlot);
+		}
+		frameReady.notify_one();
+	}
+
+	// blocks until a frame is available. returns NULL once the pipeline is closed and drained
+	const T* beginRead()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		frameReady.wait(lock, [this]() { return closed || !readySlots.empty(); });
+		if (readySlots.empty())
+			return NULL;
+		readSlot = readySlots.front();
+		readySlots.pop_front();
+		return &slots[readSlot];
+	}
+
+	void endRead()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freeSlots.push_back(readSlot);
+		}
+		slotFreed.notify_one();
+	}
+
+	// wakes both threads up; the consumer still renders frames that were already queued
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		frameReady.notify_all();
+		slotFreed.notify_all();
+	}
+
+	size_t queuedFrames()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return readySlots.size();
+	}
+
+private:
+	/* FIFO of slot indices in fixed storage. A std::deque allocates a new block whenever
+	   its elements move past the end of the current one, every few dozen frames */
+	class SlotQueue
+	{
+	public:
+		explicit SlotQueue(size_t capacity)
+			: items(capacity)
+		{
+		}
+
+		bool empty() const { return count == 0; }
+		size_t size() const { return count; }
+		size_t front() const { return items[head]; }
+
+		// never holds more than the pipeline's slots
+		void push_back(size_t item)
+		{
+			items[(head + count) % items.size()] = item;
+			count++;
+		}
+
+		void pop_front()
+		{
+			head = (head + 1) % items.size();
+			count--;
+		}
+
+	private:
+		std::vector<size_t> items;
+		size_t head = 0;
+		size_t count = 0;
+	};
+
+	size_t maxQueuedFrames;
+	std::vector<T> slots;
+	SlotQueue freeSlots;
+	SlotQueue readySlots;
+	size_t writeSlot = 0;
+	size_t readSlot = 0;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable frameReady;
+	std::condition_variable slotFreed;
+};
+
+#endif
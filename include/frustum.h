@@ -0,0 +1,87 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/* View frustum as six inward facing planes (xyz = normal, w = distance), extracted from a
+   view-projection matrix with the Gribb/Hartmann method. reverseZ selects the [0, 1] depth
+   range with the near plane at 1, as used with glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE). */
+struct Frustum
+{
+	// prefixed because windows.h defines NEAR and FAR as macros
+	enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+	enum Containment { OUTSIDE, INTERSECTING, INSIDE };
+
+	glm::vec4 planes[PLANE_COUNT];
+
+	Frustum() = default;
+
+	explicit Frustum(const glm::mat4& viewProjection, bool reverseZ = false)
+	{
+		// rows of the matrix, glm stores columns
+		glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		planes[PLANE_LEFT] = row3 + row0;
+		planes[PLANE_RIGHT] = row3 - row0;
+		planes[PLANE_BOTTOM] = row3 + row1;
+		planes[PLANE_TOP] = row3 - row1;
+		planes[PLANE_NEAR] = reverseZ ? row3 - row2 : row3 + row2;
+		planes[PLANE_FAR] = reverseZ ? row2 : row3 - row2;
+
+		for (glm::vec4& plane : planes)
+		{
+			float length = glm::length(glm::vec3(plane));
+			// an infinite far plane degenerates to a zero normal and never rejects anything
+			plane = length > 0.0f ? plane / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	// false when the box is completely outside one of the planes
+	bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const
+	{
+		for (const glm::vec4& plane : planes)
+		{
+			// corner of the box furthest along the plane normal
+			glm::vec3 positive(
+				plane.x >= 0.0f ? max.x : min.x,
+				plane.y >= 0.0f ? max.y : min.y,
+				plane.z >= 0.0f ? max.z : min.z
+			);
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	// like intersectsAABB, but also tells when the box is fully inside so hierarchical
+	// queries can accept a whole subtree without testing it further
+	Containment classifyAABB(const glm::vec3& min, const glm::vec3& max) const
+	{
+		Containment result = INSIDE;
+		for (const glm::vec4& plane : planes)
+		{
+			glm::vec3 normal(plane);
+			glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+			glm::vec3 negative(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+			if (glm::dot(normal, positive) + plane.w < 0.0f)
+				return OUTSIDE;
+			if (glm::dot(normal, negative) + plane.w < 0.0f)
+				result = INTERSECTING;
+		}
+		return result;
+	}
+
+	bool intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const glm::vec4& plane : planes)
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		return true;
+	}
+};
+
+#endif
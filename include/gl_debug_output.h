@@ -0,0 +1,278 @@
+#ifndef GL_DEBUG_OUTPUT_H
+#define GL_DEBUG_OUTPUT_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/* Collects the driver's KHR_debug messages (core in OpenGL 4.3) for the whole run. Messages
+   are deduplicated by source, type and id and counted, only the first of each is printed.
+   Performance warnings are sorted into the usual suspects by their text, which is driver
+   specific: buffers moved between memory types, shaders recompiled for the current state and
+   implicit synchronization with the GPU. The synchronous mode reports a message on the thread
+   and inside the call that caused it, which is what a debugger needs, but keeps the driver
+   from working ahead. The asynchronous mode costs little enough to profile with, its messages
+   may come from any driver thread. Without OpenGL 4.3 errors are still caught by pollErrors() */
+class GLDebugOutput
+{
+public:
+	enum Mode { MODE_SYNCHRONOUS, MODE_ASYNCHRONOUS };
+	enum Category { CATEGORY_NONE, CATEGORY_BUFFER, CATEGORY_RECOMPILE, CATEGORY_SYNC, CATEGORY_OTHER };
+
+	// needs a current context, best a debug one. returns false without OpenGL 4.3
+	bool enable(Mode mode)
+	{
+		if (!GLAD_GL_VERSION_4_3)
+		{
+			std::cout << "OpenGL 4.3 not available, GL errors are polled once per frame" << std::endl;
+			return false;
+		}
+		int flags = 0;
+		glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+		if ((flags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0)
+			std::cout << "GL_DEBUG not a debug context, the driver may report less" << std::endl;
+
+		glEnable(GL_DEBUG_OUTPUT);
+		if (mode == MODE_SYNCHRONOUS)
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		else
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(callback, this);
+		// everything down to notifications, minus the echo of our own debug groups
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+		glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+		glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+		enabled = true;
+		return true;
+	}
+
+	// counts the frames the messages are first seen in, call once per frame on the GL thread
+	void beginFrame()
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		frame++;
+	}
+
+	// without the callback GL errors are only found by asking, once per frame is enough to
+	// know something is wrong. does nothing while the callback reports them
+	void pollErrors()
+	{
+		if (enabled)
+			return;
+		GLenum error;
+		while ((error = glGetError()) != GL_NO_ERROR)
+		{
+			const char* name = errorName(error);
+			record(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, error, GL_DEBUG_SEVERITY_HIGH, name, std::strlen(name));
+		}
+	}
+
+	uint64_t getCount(GLenum type) const
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		uint64_t count = 0;
+		for (const auto& entry : messages)
+			if (entry.second.type == type)
+				count += entry.second.count;
+		return count;
+	}
+
+	/* Every distinct message with its count, most frequent first, after totals per type and
+	   per performance category */
+	void printReport() const
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		std::vector<const Message*> sorted;
+		uint64_t total = 0;
+		uint64_t errors = 0;
+		uint64_t performance[CATEGORY_OTHER + 1] = {};
+		for (const auto& entry : messages)
+		{
+			const Message& message = entry.second;
+			sorted.push_back(&message);
+			total += message.count;
+			if (message.type == GL_DEBUG_TYPE_ERROR)
+				errors += message.count;
+			performance[message.category] += message.count;
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const Message* a, const Message* b) { return a->count > b->count; });
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "GL_DEBUG %llu messages, %zu distinct, %llu errors", (unsigned long long)total,
+			sorted.size(), (unsigned long long)errors);
+		std::cout << line << std::endl;
+		std::snprintf(line, sizeof(line), "GL_DEBUG performance warnings: %llu buffer placement, %llu shader recompiles, %llu implicit syncs, %llu other",
+			(unsigned long long)performance[CATEGORY_BUFFER], (unsigned long long)performance[CATEGORY_RECOMPILE],
+			(unsigned long long)performance[CATEGORY_SYNC], (unsigned long long)performance[CATEGORY_OTHER]);
+		std::cout << line << std::endl;
+		for (const Message* message : sorted)
+		{
+			std::snprintf(line, sizeof(line), "  %8llu x  %-12s %-12s %-8s id %-6u first frame %-6llu ",
+				(unsigned long long)message->count, typeName(message->type), categoryName(message->category),
+				severityName(message->severity), message->id, (unsigned long long)message->firstFrame);
+			std::cout << line << message->text << std::endl;
+		}
+	}
+
+	// names an object for debuggers and for the driver's messages. the object must have been
+	// bound once, a name that was only generated is no object yet
+	static void label(GLenum identifier, unsigned int name, const char* text)
+	{
+		if (glad_glObjectLabel != NULL && name != 0)
+			glObjectLabel(identifier, name, -1, text);
+	}
+
+	// nests the following commands under name in debuggers and frame captures
+	static void pushGroup(const char* name)
+	{
+		if (glad_glPushDebugGroup != NULL)
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	}
+
+	static void popGroup()
+	{
+		if (glad_glPopDebugGroup != NULL)
+			glPopDebugGroup();
+	}
+
+private:
+	struct Message
+	{
+		GLenum source;
+		GLenum type;
+		GLuint id;
+		GLenum severity;
+		Category category;
+		uint64_t count;
+		uint64_t firstFrame;
+		std::string text; // of the first occurrence, the rest usually differ in object names only
+	};
+
+	mutable std::mutex mutex; // asynchronous messages come from driver threads
+	std::map<std::tuple<GLenum, GLenum, GLuint>, Message> messages;
+	uint64_t frame = 0;
+	bool enabled = false;
+
+	static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+		const GLchar* text, const void* user)
+	{
+		GLDebugOutput* output = (GLDebugOutput*)user;
+		output->record(source, type, id, severity, text, length >= 0 ? (size_t)length : std::strlen(text));
+	}
+
+	// a repeated message is only counted, its text is copied the first time it is seen
+	void record(GLenum source, GLenum type, GLuint id, GLenum severity, const char* text, size_t length)
+	{
+		std::string firstText;
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			auto key = std::make_tuple(source, type, id);
+			auto found = messages.find(key);
+			if (found != messages.end())
+			{
+				found->second.count++;
+				return;
+			}
+			firstText.assign(text, length);
+			messages[key] = { source, type, id, severity, categorize(type, firstText), 1, frame, firstText };
+		}
+		if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+			return;
+		if (type == GL_DEBUG_TYPE_ERROR)
+			std::cout << "ERROR::GL_DEBUG::" << errorSource(source) << " id " << id << ": " << firstText << std::endl;
+		else
+			std::cout << "GL_DEBUG " << typeName(type) << " " << severityName(severity) << " id " << id << ": " << firstText << std::endl;
+	}
+
+	static Category categorize(GLenum type, const std::string& text)
+	{
+		if (type != GL_DEBUG_TYPE_PERFORMANCE)
+			return CATEGORY_NONE;
+		std::string lower(text);
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+		auto contains = [&](const char* word) { return lower.find(word) != std::string::npos; };
+		// stalls first: "buffer is busy, stalling" is about the wait, not the buffer
+		if (contains("stall") || contains("sync") || contains("wait") || contains("busy") || contains("flush"))
+			return CATEGORY_SYNC;
+		if (contains("recompil") || contains("shader state") || contains("variant"))
+			return CATEGORY_RECOMPILE;
+		if (contains("buffer") || contains("memory") || contains("migrat"))
+			return CATEGORY_BUFFER;
+		return CATEGORY_OTHER;
+	}
+
+	static const char* errorName(GLenum error)
+	{
+		switch (error)
+		{
+		case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+		case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+		case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+		case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+		case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
+		default: return "unknown error";
+		}
+	}
+
+	static const char* errorSource(GLenum source)
+	{
+		switch (source)
+		{
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "WINDOW_SYSTEM";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER_COMPILER";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "THIRD_PARTY";
+		case GL_DEBUG_SOURCE_APPLICATION: return "APPLICATION";
+		default: return "OTHER";
+		}
+	}
+
+	static const char* typeName(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_DEBUG_TYPE_ERROR: return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined";
+		case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+		case GL_DEBUG_TYPE_MARKER: return "marker";
+		default: return "other";
+		}
+	}
+
+	static const char* severityName(GLenum severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+		default: return "info";
+		}
+	}
+
+	static const char* categoryName(Category category)
+	{
+		switch (category)
+		{
+		case CATEGORY_BUFFER: return "buffer";
+		case CATEGORY_RECOMPILE: return "recompile";
+		case CATEGORY_SYNC: return "sync";
+		case CATEGORY_OTHER: return "other";
+		default: return "-";
+		}
+	}
+};
+
+#endif
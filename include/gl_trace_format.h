@@ -0,0 +1,200 @@
+#ifndef GL_TRACE_FORMAT_H
+#define GL_TRACE_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+/* Binary layout of a captured GL frame, written by GLTraceRecorder and replayed by
+   src/tools/gl_trace_replay.cpp. Little endian:
+    - a GLTraceHeader
+    - setupBytes of commands creating every object the frame uses, with its contents as they
+      were when the object was first used
+    - resetBytes of commands restoring the state the frame started with, run before every
+      repetition of the frame
+    - frameBytes of the frame's own commands
+   A command is a GLTraceCommand followed by wordCount 32-bit arguments and dataSize bytes
+   of data, floats are stored as their bits. Object names are the ones of the captured
+   process, the replayer maps them to its own. The argument lists are next to the calls. */
+const uint32_t GL_TRACE_MAGIC = 0x52544C47; // "GLTR"
+const uint32_t GL_TRACE_VERSION = 1;
+const unsigned int GL_TRACE_MAX_WORDS = 16;
+
+struct GLTraceHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width; // of the default framebuffer
+	uint32_t height;
+	uint32_t setupBytes;
+	uint32_t resetBytes;
+	uint32_t frameBytes;
+};
+
+struct GLTraceCommand
+{
+	uint16_t call; // a GLTraceCall
+	uint8_t wordCount;
+	uint8_t reserved;
+	uint32_t dataSize;
+};
+
+enum GLTraceCall : uint16_t
+{
+	// setup, name first
+	GL_TRACE_CREATE_BUFFER, // name, size, usage | contents, none for a name never bound
+	GL_TRACE_CREATE_TEXTURE_2D, // name, internal format, width, height, levels, immutable, min filter, mag filter,
+		// wrap s, wrap t, format, type | level 0 in format and type, tightly packed, none for depth
+	GL_TRACE_CREATE_PROGRAM, // name, shader count | per shader: uint32 type, uint32 length, source
+	GL_TRACE_UNIFORM_LOCATION, // program, location | uniform name
+	GL_TRACE_UNIFORM_VALUE, // program, location, type | one element's components
+	GL_TRACE_CREATE_VERTEX_ARRAY, // name, element buffer
+	GL_TRACE_VERTEX_ATTRIBUTE, // vertex array, index, enabled, buffer, size, type, normalized, integer, stride, offset, divisor
+	GL_TRACE_CREATE_FRAMEBUFFER, // name, color texture, depth texture
+
+	// state, arguments as in GL
+	GL_TRACE_ENABLE,
+	GL_TRACE_DISABLE,
+	GL_TRACE_DEPTH_FUNC,
+	GL_TRACE_DEPTH_MASK,
+	GL_TRACE_BLEND_FUNC,
+	GL_TRACE_CLIP_CONTROL,
+	GL_TRACE_CLEAR_DEPTH, // float
+	GL_TRACE_CLEAR_COLOR,
+	GL_TRACE_VIEWPORT,
+	GL_TRACE_PIXEL_STORE,
+	GL_TRACE_CLEAR,
+
+	// binds
+	GL_TRACE_USE_PROGRAM,
+	GL_TRACE_BIND_VERTEX_ARRAY,
+	GL_TRACE_ACTIVE_TEXTURE,
+	GL_TRACE_BIND_TEXTURE,
+	GL_TRACE_BIND_BUFFER,
+	GL_TRACE_BIND_BUFFER_BASE,
+	GL_TRACE_BIND_FRAMEBUFFER,
+	GL_TRACE_BIND_IMAGE_TEXTURE,
+
+	// uniforms of the bound program, location first
+	GL_TRACE_UNIFORM_1I,
+	GL_TRACE_UNIFORM_1UI,
+	GL_TRACE_UNIFORM_1F,
+	GL_TRACE_UNIFORM_2F,
+	GL_TRACE_UNIFORM_4FV, // location, count | values
+	GL_TRACE_UNIFORM_MATRIX_4FV, // location, count, transpose | values
+
+	// uploads
+	GL_TRACE_BUFFER_DATA, // target, size, usage | contents, none when orphaning
+	GL_TRACE_BUFFER_SUB_DATA, // target, offset | contents
+	GL_TRACE_TEX_IMAGE_2D, // target, level, internal format, width, height, format, type | pixels as unpacked
+	GL_TRACE_TEX_SUB_IMAGE_2D, // target, level, x, y, width, height, format, type | pixels as unpacked
+	GL_TRACE_MAPPED_WRITE, // buffer, offset | bytes written through a persistent mapping
+
+	// draws, offsets into the bound element or indirect buffer
+	GL_TRACE_DRAW_ARRAYS,
+	GL_TRACE_DRAW_ELEMENTS,
+	GL_TRACE_DRAW_ARRAYS_INSTANCED,
+	GL_TRACE_DRAW_ELEMENTS_INSTANCED,
+	GL_TRACE_DRAW_ARRAYS_INDIRECT,
+	GL_TRACE_DRAW_ELEMENTS_INDIRECT,
+	GL_TRACE_BLIT_FRAMEBUFFER,
+
+	// compute
+	GL_TRACE_DISPATCH_COMPUTE,
+	GL_TRACE_MEMORY_BARRIER,
+
+	// debug groups
+	GL_TRACE_PUSH_GROUP, // | message
+	GL_TRACE_POP_GROUP,
+
+	GL_TRACE_CALL_COUNT
+};
+
+/* What a call does, the replayer skips and reorders whole classes */
+enum GLTraceClass
+{
+	GL_TRACE_CLASS_SETUP,
+	GL_TRACE_CLASS_STATE,
+	GL_TRACE_CLASS_CLEAR,
+	GL_TRACE_CLASS_BIND,
+	GL_TRACE_CLASS_UNIFORM,
+	GL_TRACE_CLASS_UPLOAD,
+	GL_TRACE_CLASS_DRAW,
+	GL_TRACE_CLASS_COMPUTE,
+	GL_TRACE_CLASS_MARKER,
+	GL_TRACE_CLASS_COUNT
+};
+
+inline GLTraceClass getTraceClass(uint16_t call)
+{
+	if (call <= GL_TRACE_CREATE_FRAMEBUFFER)
+		return GL_TRACE_CLASS_SETUP;
+	if (call <= GL_TRACE_PIXEL_STORE)
+		return GL_TRACE_CLASS_STATE;
+	if (call == GL_TRACE_CLEAR)
+		return GL_TRACE_CLASS_CLEAR;
+	if (call <= GL_TRACE_BIND_IMAGE_TEXTURE)
+		return GL_TRACE_CLASS_BIND;
+	if (call <= GL_TRACE_UNIFORM_MATRIX_4FV)
+		return GL_TRACE_CLASS_UNIFORM;
+	if (call <= GL_TRACE_MAPPED_WRITE)
+		return GL_TRACE_CLASS_UPLOAD;
+	if (call <= GL_TRACE_BLIT_FRAMEBUFFER)
+		return GL_TRACE_CLASS_DRAW;
+	if (call <= GL_TRACE_MEMORY_BARRIER)
+		return GL_TRACE_CLASS_COMPUTE;
+	return GL_TRACE_CLASS_MARKER;
+}
+
+inline const char* getTraceClassName(GLTraceClass traceClass)
+{
+	const char* names[GL_TRACE_CLASS_COUNT] = { "setup", "state", "clear", "bind", "uniform", "upload", "draw", "compute", "marker" };
+	return names[traceClass];
+}
+
+enum GLTraceUniformKind { GL_TRACE_UNIFORM_FLOAT, GL_TRACE_UNIFORM_INT, GL_TRACE_UNIFORM_UNSIGNED_INT, GL_TRACE_UNIFORM_MATRIX };
+
+/* How a GL_TRACE_UNIFORM_VALUE of a uniform type is stored: components 32-bit values of
+   kind. Samplers and images store their unit as an int, the other types the project does
+   not use (doubles, non square matrices) have no components and are not captured */
+inline unsigned int getTraceUniformLayout(GLenum type, GLTraceUniformKind& kind)
+{
+	kind = GL_TRACE_UNIFORM_FLOAT;
+	switch (type)
+	{
+	case GL_FLOAT: return 1;
+	case GL_FLOAT_VEC2: return 2;
+	case GL_FLOAT_VEC3: return 3;
+	case GL_FLOAT_VEC4: return 4;
+	}
+	kind = GL_TRACE_UNIFORM_MATRIX;
+	switch (type)
+	{
+	case GL_FLOAT_MAT2: return 4;
+	case GL_FLOAT_MAT3: return 9;
+	case GL_FLOAT_MAT4: return 16;
+	case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+	case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+	case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+	case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4:
+		return 0;
+	}
+	kind = GL_TRACE_UNIFORM_UNSIGNED_INT;
+	switch (type)
+	{
+	case GL_UNSIGNED_INT: return 1;
+	case GL_UNSIGNED_INT_VEC2: return 2;
+	case GL_UNSIGNED_INT_VEC3: return 3;
+	case GL_UNSIGNED_INT_VEC4: return 4;
+	}
+	kind = GL_TRACE_UNIFORM_INT;
+	switch (type)
+	{
+	case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+	case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+	case GL_INT_VEC4: case GL_BOOL_VEC4: return 4;
+	default: return 1; // int, bool, samplers and images
+	}
+}
+
+#endif
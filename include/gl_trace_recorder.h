@@ -0,0 +1,1006 @@
+#ifndef GL_TRACE_RECORDER_H
+#define GL_TRACE_RECORDER_H
+
+#include <glad/glad.h>
+#include <gl_trace_format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gl_trace_detail
+{
+	// a buffer written through a persistent mapping, no GL call sees those writes
+	struct MappedBuffer
+	{
+		unsigned char* pointer;
+		size_t offset;
+		size_t size;
+		std::vector<unsigned char> recorded; // the mapped bytes as the trace has them
+		bool captured;
+	};
+
+	inline bool recording = false;
+	inline unsigned int paused = 0; // snapshots make GL calls of their own
+	inline uint32_t width = 0;
+	inline uint32_t height = 0;
+	inline std::vector<unsigned char> setup;
+	inline std::vector<unsigned char> reset;
+	inline std::vector<unsigned char> frame;
+	inline uint32_t frameCommands = 0;
+	inline std::set<GLuint> buffers, textures, programs, vertexArrays, framebuffers; // in setup
+	inline std::map<GLuint, MappedBuffer> mappedBuffers; // tracked from startup
+
+	// the real entry points behind the recording hooks
+	inline PFNGLENABLEPROC enable = NULL;
+	inline PFNGLDISABLEPROC disable = NULL;
+	inline PFNGLDEPTHFUNCPROC depthFunc = NULL;
+	inline PFNGLDEPTHMASKPROC depthMask = NULL;
+	inline PFNGLBLENDFUNCPROC blendFunc = NULL;
+	inline PFNGLCLIPCONTROLPROC clipControl = NULL;
+	inline PFNGLCLEARDEPTHPROC clearDepth = NULL;
+	inline PFNGLCLEARCOLORPROC clearColor = NULL;
+	inline PFNGLVIEWPORTPROC viewport = NULL;
+	inline PFNGLPIXELSTOREIPROC pixelStorei = NULL;
+	inline PFNGLCLEARPROC clear = NULL;
+	inline PFNGLUSEPROGRAMPROC useProgram = NULL;
+	inline PFNGLBINDVERTEXARRAYPROC bindVertexArray = NULL;
+	inline PFNGLACTIVETEXTUREPROC activeTexture = NULL;
+	inline PFNGLBINDTEXTUREPROC bindTexture = NULL;
+	inline PFNGLBINDBUFFERPROC bindBuffer = NULL;
+	inline PFNGLBINDBUFFERBASEPROC bindBufferBase = NULL;
+	inline PFNGLBINDFRAMEBUFFERPROC bindFramebuffer = NULL;
+	inline PFNGLBINDIMAGETEXTUREPROC bindImageTexture = NULL;
+	inline PFNGLUNIFORM1IPROC uniform1i = NULL;
+	inline PFNGLUNIFORM1UIPROC uniform1ui = NULL;
+	inline PFNGLUNIFORM1FPROC uniform1f = NULL;
+	inline PFNGLUNIFORM2FPROC uniform2f = NULL;
+	inline PFNGLUNIFORM4FVPROC uniform4fv = NULL;
+	inline PFNGLUNIFORMMATRIX4FVPROC uniformMatrix4fv = NULL;
+	inline PFNGLBUFFERDATAPROC bufferData = NULL;
+	inline PFNGLBUFFERSUBDATAPROC bufferSubData = NULL;
+	inline PFNGLTEXIMAGE2DPROC texImage2D = NULL;
+	inline PFNGLTEXSUBIMAGE2DPROC texSubImage2D = NULL;
+	inline PFNGLDRAWARRAYSPROC drawArrays = NULL;
+	inline PFNGLDRAWELEMENTSPROC drawElements = NULL;
+	inline PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced = NULL;
+	inline PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced = NULL;
+	inline PFNGLDRAWARRAYSINDIRECTPROC drawArraysIndirect = NULL;
+	inline PFNGLDRAWELEMENTSINDIRECTPROC drawElementsIndirect = NULL;
+	inline PFNGLBLITFRAMEBUFFERPROC blitFramebuffer = NULL;
+	inline PFNGLDISPATCHCOMPUTEPROC dispatchCompute = NULL;
+	inline PFNGLMEMORYBARRIERPROC memoryBarrier = NULL;
+	inline PFNGLPUSHDEBUGGROUPPROC pushDebugGroup = NULL;
+	inline PFNGLPOPDEBUGGROUPPROC popDebugGroup = NULL;
+	inline PFNGLMAPBUFFERRANGEPROC mapBufferRange = NULL;
+	inline PFNGLUNMAPBUFFERPROC unmapBuffer = NULL;
+
+	struct Pause
+	{
+		Pause() { paused++; }
+		~Pause() { paused--; }
+	};
+
+	inline bool isRecording()
+	{
+		return recording && paused == 0;
+	}
+
+	inline uint32_t bits(float value)
+	{
+		uint32_t result;
+		std::memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+
+	inline void write(std::vector<unsigned char>& out, GLTraceCall call, std::initializer_list<uint32_t> words,
+		const void* data = NULL, size_t dataSize = 0)
+	{
+		GLTraceCommand command = { (uint16_t)call, (uint8_t)words.size(), 0, (uint32_t)dataSize };
+		const unsigned char* header = (const unsigned char*)&command;
+		out.insert(out.end(), header, header + sizeof(command));
+		for (uint32_t word : words)
+		{
+			const unsigned char* bytes = (const unsigned char*)&word;
+			out.insert(out.end(), bytes, bytes + sizeof(word));
+		}
+		if (dataSize > 0)
+			out.insert(out.end(), (const unsigned char*)data, (const unsigned char*)data + dataSize);
+	}
+
+	inline void record(GLTraceCall call, std::initializer_list<uint32_t> words, const void* data = NULL, size_t dataSize = 0)
+	{
+		write(frame, call, words, data, dataSize);
+		frameCommands++;
+	}
+
+	inline GLenum getBufferBinding(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return GL_ARRAY_BUFFER_BINDING;
+		case GL_ELEMENT_ARRAY_BUFFER: return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+		case GL_UNIFORM_BUFFER: return GL_UNIFORM_BUFFER_BINDING;
+		case GL_SHADER_STORAGE_BUFFER: return GL_SHADER_STORAGE_BUFFER_BINDING;
+		case GL_DRAW_INDIRECT_BUFFER: return GL_DRAW_INDIRECT_BUFFER_BINDING;
+		case GL_DISPATCH_INDIRECT_BUFFER: return GL_DISPATCH_INDIRECT_BUFFER_BINDING;
+		case GL_COPY_READ_BUFFER: return GL_COPY_READ_BUFFER_BINDING;
+		case GL_COPY_WRITE_BUFFER: return GL_COPY_WRITE_BUFFER_BINDING;
+		case GL_PIXEL_PACK_BUFFER: return GL_PIXEL_PACK_BUFFER_BINDING;
+		case GL_PIXEL_UNPACK_BUFFER: return GL_PIXEL_UNPACK_BUFFER_BINDING;
+		default: return 0;
+		}
+	}
+
+	inline GLuint getBoundBuffer(GLenum target)
+	{
+		GLenum binding = getBufferBinding(target);
+		GLint buffer = 0;
+		if (binding != 0)
+			glGetIntegerv(binding, &buffer);
+		return (GLuint)buffer;
+	}
+
+	inline GLuint getBoundTexture2D()
+	{
+		GLint texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+		return (GLuint)texture;
+	}
+
+	// bytes GL reads for an image with the current unpack alignment
+	inline size_t getImageBytes(GLsizei imageWidth, GLsizei imageHeight, GLenum format, GLenum type)
+	{
+		size_t components = 4;
+		if (format == GL_RED || format == GL_RED_INTEGER || format == GL_DEPTH_COMPONENT)
+			components = 1;
+		else if (format == GL_RG || format == GL_RG_INTEGER)
+			components = 2;
+		else if (format == GL_RGB || format == GL_BGR || format == GL_RGB_INTEGER)
+			components = 3;
+		size_t componentSize = 1;
+		if (type == GL_FLOAT || type == GL_INT || type == GL_UNSIGNED_INT)
+			componentSize = 4;
+		else if (type == GL_HALF_FLOAT || type == GL_SHORT || type == GL_UNSIGNED_SHORT)
+			componentSize = 2;
+		if (imageWidth <= 0 || imageHeight <= 0)
+			return 0;
+		GLint alignment = 4;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		size_t row = (size_t)imageWidth * components * componentSize;
+		size_t alignedRow = (row + alignment - 1) / alignment * alignment;
+		return alignedRow * (imageHeight - 1) + row; // the last row has no padding
+	}
+
+	// how a texture's level 0 is read back, false for depth, whose contents are not kept
+	inline bool getReadFormat(GLint internalFormat, GLenum& format, GLenum& type)
+	{
+		switch (internalFormat)
+		{
+		case GL_DEPTH_COMPONENT: case GL_DEPTH_COMPONENT16: case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32: case GL_DEPTH_COMPONENT32F:
+			format = GL_DEPTH_COMPONENT;
+			type = GL_FLOAT;
+			return false;
+		case GL_DEPTH24_STENCIL8:
+			format = GL_DEPTH_STENCIL;
+			type = GL_UNSIGNED_INT_24_8;
+			return false;
+		case GL_DEPTH32F_STENCIL8:
+			format = GL_DEPTH_STENCIL;
+			type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+			return false;
+		case GL_RED: case GL_R8:
+			format = GL_RED;
+			type = GL_UNSIGNED_BYTE;
+			return true;
+		case GL_R16F: case GL_R32F:
+			format = GL_RED;
+			type = GL_FLOAT;
+			return true;
+		case GL_RG: case GL_RG8:
+			format = GL_RG;
+			type = GL_UNSIGNED_BYTE;
+			return true;
+		case GL_RG16F: case GL_RG32F:
+			format = GL_RG;
+			type = GL_FLOAT;
+			return true;
+		case GL_RGB: case GL_RGB8: case GL_SRGB8:
+			format = GL_RGB;
+			type = GL_UNSIGNED_BYTE;
+			return true;
+		case GL_RGB16F: case GL_RGB32F: case GL_RGBA16F: case GL_RGBA32F: case GL_R11F_G11F_B10F:
+			format = GL_RGBA;
+			type = GL_FLOAT;
+			return true;
+		default:
+			format = GL_RGBA;
+			type = GL_UNSIGNED_BYTE;
+			return true;
+		}
+	}
+
+	/* The snapshots below add an object to the setup the first time the frame uses it,
+	   before the call using it runs, so the trace starts from the object's state at that
+	   point. They restore every binding they change */
+	inline void captureBuffer(GLuint name)
+	{
+		if (name == 0 || !buffers.insert(name).second)
+			return;
+		Pause pause;
+		if (!glIsBuffer(name))
+		{
+			write(setup, GL_TRACE_CREATE_BUFFER, { name, 0, GL_STATIC_DRAW });
+			return;
+		}
+		GLint previous = 0, size = 0, usage = GL_STATIC_DRAW;
+		glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previous);
+		glBindBuffer(GL_COPY_READ_BUFFER, name);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+		std::vector<unsigned char> contents((size_t)size);
+		if (size > 0)
+			glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, contents.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, previous);
+
+		// the mapped bytes are whatever the application wrote, whether the GPU saw it yet or not
+		auto mapped = mappedBuffers.find(name);
+		if (mapped != mappedBuffers.end())
+		{
+			MappedBuffer& buffer = mapped->second;
+			std::memcpy(contents.data() + buffer.offset, buffer.pointer, buffer.size);
+			buffer.recorded.assign(buffer.pointer, buffer.pointer + buffer.size);
+			buffer.captured = true;
+		}
+		write(setup, GL_TRACE_CREATE_BUFFER, { name, (uint32_t)size, (uint32_t)usage }, contents.data(), contents.size());
+	}
+
+	inline void captureTexture(GLuint name)
+	{
+		if (name == 0 || !textures.insert(name).second)
+			return;
+		Pause pause;
+		GLint target = GL_TEXTURE_2D;
+		if (glIsTexture(name) && GLAD_GL_VERSION_4_5)
+			glGetTextureParameteriv(name, GL_TEXTURE_TARGET, &target);
+		if (!glIsTexture(name) || target != GL_TEXTURE_2D)
+		{
+			// only the name, the frame's bind creates the texture
+			write(setup, GL_TRACE_CREATE_TEXTURE_2D, { name, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 });
+			return;
+		}
+		GLint previous = getBoundTexture2D();
+		glBindTexture(GL_TEXTURE_2D, name);
+		GLint textureWidth = 0, textureHeight = 0, internalFormat = GL_RGBA8, levels = 1, immutable = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &textureWidth);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &textureHeight);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+		if (GLAD_GL_VERSION_4_3)
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+		if (immutable)
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+		else
+		{
+			GLint levelWidth = textureWidth;
+			for (levels = 0; levels < 16 && levelWidth > 0; levels++)
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, levels + 1, GL_TEXTURE_WIDTH, &levelWidth);
+		}
+		GLint minFilter, magFilter, wrapS, wrapT;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &magFilter);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapS);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &wrapT);
+
+		GLenum format, type;
+		std::vector<unsigned char> pixels;
+		if (getReadFormat(internalFormat, format, type) && textureWidth > 0)
+		{
+			GLint packAlignment = 4;
+			glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			size_t components = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : 4;
+			pixels.resize((size_t)textureWidth * textureHeight * components * (type == GL_FLOAT ? 4 : 1));
+			glGetTexImage(GL_TEXTURE_2D, 0, format, type, pixels.data());
+			glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+		}
+		glBindTexture(GL_TEXTURE_2D, previous);
+		write(setup, GL_TRACE_CREATE_TEXTURE_2D, { name, (uint32_t)internalFormat, (uint32_t)textureWidth, (uint32_t)textureHeight,
+			(uint32_t)levels, (uint32_t)immutable, (uint32_t)minFilter, (uint32_t)magFilter, (uint32_t)wrapS, (uint32_t)wrapT,
+			format, type }, pixels.data(), pixels.size());
+	}
+
+	// the sources of the attached shaders, then every active uniform's location and value
+	inline void captureProgram(GLuint name)
+	{
+		if (name == 0 || !programs.insert(name).second)
+			return;
+		Pause pause;
+		if (!glIsProgram(name))
+		{
+			write(setup, GL_TRACE_CREATE_PROGRAM, { name, 0 });
+			return;
+		}
+		GLuint shaders[8];
+		GLsizei shaderCount = 0;
+		glGetAttachedShaders(name, 8, &shaderCount, shaders);
+		std::vector<unsigned char> sources;
+		for (GLsizei i = 0; i < shaderCount; i++)
+		{
+			GLint type = 0, length = 0;
+			glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+			glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length);
+			std::string source((size_t)length, '\0');
+			if (length > 0)
+				glGetShaderSource(shaders[i], length, &length, &source[0]);
+			uint32_t header[2] = { (uint32_t)type, (uint32_t)length };
+			sources.insert(sources.end(), (const unsigned char*)header, (const unsigned char*)(header + 2));
+			sources.insert(sources.end(), source.begin(), source.begin() + length);
+		}
+		write(setup, GL_TRACE_CREATE_PROGRAM, { name, (uint32_t)shaderCount }, sources.data(), sources.size());
+
+		GLint uniformCount = 0;
+		glGetProgramiv(name, GL_ACTIVE_UNIFORMS, &uniformCount);
+		for (GLint i = 0; i < uniformCount; i++)
+		{
+			char uniformName[256];
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(name, (GLuint)i, sizeof(uniformName), &length, &size, &type, uniformName);
+			GLTraceUniformKind kind;
+			unsigned int components = getTraceUniformLayout(type, kind);
+			std::string base(uniformName, length);
+			if (base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+				base.resize(base.size() - 3);
+			for (GLint element = 0; element < size && components > 0; element++)
+			{
+				std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+				GLint location = glGetUniformLocation(name, elementName.c_str());
+				if (location < 0)
+					continue; // in a uniform block
+				uint32_t values[16];
+				if (kind == GL_TRACE_UNIFORM_INT)
+					glGetUniformiv(name, location, (GLint*)values);
+				else if (kind == GL_TRACE_UNIFORM_UNSIGNED_INT)
+					glGetUniformuiv(name, location, (GLuint*)values);
+				else
+					glGetUniformfv(name, location, (GLfloat*)values);
+				write(setup, GL_TRACE_UNIFORM_LOCATION, { name, (uint32_t)location }, elementName.c_str(), elementName.size());
+				write(setup, GL_TRACE_UNIFORM_VALUE, { name, (uint32_t)location, type }, values, components * sizeof(uint32_t));
+			}
+		}
+	}
+
+	inline void captureVertexArray(GLuint name)
+	{
+		if (name == 0 || !vertexArrays.insert(name).second)
+			return;
+		Pause pause;
+		if (!glIsVertexArray(name))
+		{
+			write(setup, GL_TRACE_CREATE_VERTEX_ARRAY, { name, 0 });
+			return;
+		}
+		GLint previous = 0, elementBuffer = 0, maxAttributes = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+		glBindVertexArray(name);
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+		glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+		std::vector<std::vector<uint32_t>> attributes;
+		for (GLint index = 0; index < maxAttributes; index++)
+		{
+			GLint enabled = 0, buffer = 0, size = 4, type = GL_FLOAT, normalized = 0, integer = 0, stride = 0, divisor = 0;
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+			if (!enabled && buffer == 0)
+				continue;
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &normalized);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &integer);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+			glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+			void* offset = NULL;
+			glGetVertexAttribPointerv(index, GL_VERTEX_ATTRIB_ARRAY_POINTER, &offset);
+			attributes.push_back({ name, (uint32_t)index, (uint32_t)enabled, (uint32_t)buffer, (uint32_t)size, (uint32_t)type,
+				(uint32_t)normalized, (uint32_t)integer, (uint32_t)stride, (uint32_t)(uintptr_t)offset, (uint32_t)divisor });
+		}
+		glBindVertexArray(previous);
+
+		// the buffers come first, the replayer binds them while building the vertex array
+		captureBuffer(elementBuffer);
+		for (const std::vector<uint32_t>& attribute : attributes)
+			captureBuffer(attribute[3]);
+		write(setup, GL_TRACE_CREATE_VERTEX_ARRAY, { name, (uint32_t)elementBuffer });
+		for (const std::vector<uint32_t>& a : attributes)
+			write(setup, GL_TRACE_VERTEX_ATTRIBUTE, { a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10] });
+	}
+
+	// texture attachments only, the project renders to nothing else
+	inline void captureFramebuffer(GLuint name)
+	{
+		if (name == 0 || !framebuffers.insert(name).second)
+			return;
+		Pause pause;
+		GLint previous = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, name);
+		GLint attachments[2] = { 0, 0 };
+		GLenum points[2] = { GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT };
+		for (int i = 0; i < 2; i++)
+		{
+			GLint type = GL_NONE;
+			glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, points[i], GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+			if (type == GL_TEXTURE)
+				glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, points[i], GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &attachments[i]);
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+		captureTexture(attachments[0]);
+		captureTexture(attachments[1]);
+		write(setup, GL_TRACE_CREATE_FRAMEBUFFER, { name, (uint32_t)attachments[0], (uint32_t)attachments[1] });
+	}
+
+	// records what the application wrote into persistently mapped buffers since the last draw
+	inline void recordMappedWrites()
+	{
+		for (auto& entry : mappedBuffers)
+		{
+			MappedBuffer& buffer = entry.second;
+			if (!buffer.captured)
+				continue;
+			size_t first = 0, last = buffer.size;
+			while (first < last && buffer.pointer[first] == buffer.recorded[first])
+				first++;
+			while (last > first && buffer.pointer[last - 1] == buffer.recorded[last - 1])
+				last--;
+			if (first == last)
+				continue;
+			record(GL_TRACE_MAPPED_WRITE, { entry.first, (uint32_t)(buffer.offset + first) }, buffer.pointer + first, last - first);
+			std::memcpy(buffer.recorded.data() + first, buffer.pointer + first, last - first);
+		}
+	}
+
+	// the state the frame starts from, restored before every replayed repetition
+	inline void captureState()
+	{
+		Pause pause;
+		GLint values[4];
+		GLfloat floats[4];
+		glGetIntegerv(GL_VIEWPORT, values);
+		write(reset, GL_TRACE_VIEWPORT, { (uint32_t)values[0], (uint32_t)values[1], (uint32_t)values[2], (uint32_t)values[3] });
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, floats);
+		write(reset, GL_TRACE_CLEAR_COLOR, { bits(floats[0]), bits(floats[1]), bits(floats[2]), bits(floats[3]) });
+		glGetFloatv(GL_DEPTH_CLEAR_VALUE, floats);
+		write(reset, GL_TRACE_CLEAR_DEPTH, { bits(floats[0]) });
+		for (GLenum capability : { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_RASTERIZER_DISCARD })
+			write(reset, glIsEnabled(capability) ? GL_TRACE_ENABLE : GL_TRACE_DISABLE, { capability });
+		glGetIntegerv(GL_DEPTH_FUNC, values);
+		write(reset, GL_TRACE_DEPTH_FUNC, { (uint32_t)values[0] });
+		glGetIntegerv(GL_DEPTH_WRITEMASK, values);
+		write(reset, GL_TRACE_DEPTH_MASK, { (uint32_t)values[0] });
+		glGetIntegerv(GL_BLEND_SRC_RGB, values);
+		glGetIntegerv(GL_BLEND_DST_RGB, values + 1);
+		write(reset, GL_TRACE_BLEND_FUNC, { (uint32_t)values[0], (uint32_t)values[1] });
+		if (GLAD_GL_VERSION_4_5)
+		{
+			glGetIntegerv(GL_CLIP_ORIGIN, values);
+			glGetIntegerv(GL_CLIP_DEPTH_MODE, values + 1);
+			write(reset, GL_TRACE_CLIP_CONTROL, { (uint32_t)values[0], (uint32_t)values[1] });
+		}
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, values);
+		write(reset, GL_TRACE_PIXEL_STORE, { GL_UNPACK_ALIGNMENT, (uint32_t)values[0] });
+
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, values);
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, values + 1);
+		captureFramebuffer(values[0]);
+		captureFramebuffer(values[1]);
+		write(reset, GL_TRACE_BIND_FRAMEBUFFER, { GL_DRAW_FRAMEBUFFER, (uint32_t)values[0] });
+		write(reset, GL_TRACE_BIND_FRAMEBUFFER, { GL_READ_FRAMEBUFFER, (uint32_t)values[1] });
+		glGetIntegerv(GL_CURRENT_PROGRAM, values);
+		captureProgram(values[0]);
+		write(reset, GL_TRACE_USE_PROGRAM, { (uint32_t)values[0] });
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, values);
+		captureVertexArray(values[0]);
+		write(reset, GL_TRACE_BIND_VERTEX_ARRAY, { (uint32_t)values[0] });
+		GLuint arrayBuffer = getBoundBuffer(GL_ARRAY_BUFFER);
+		captureBuffer(arrayBuffer);
+		write(reset, GL_TRACE_BIND_BUFFER, { GL_ARRAY_BUFFER, arrayBuffer });
+
+		GLint active = GL_TEXTURE0, units = 0;
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &units);
+		for (GLint unit = 0; unit < std::min(units, 16); unit++)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			GLuint texture = getBoundTexture2D();
+			captureTexture(texture);
+			write(reset, GL_TRACE_ACTIVE_TEXTURE, { (uint32_t)(GL_TEXTURE0 + unit) });
+			write(reset, GL_TRACE_BIND_TEXTURE, { GL_TEXTURE_2D, texture });
+		}
+		glActiveTexture(active);
+		write(reset, GL_TRACE_ACTIVE_TEXTURE, { (uint32_t)active });
+	}
+
+	inline void APIENTRY traceEnable(GLenum capability)
+	{
+		if (isRecording())
+			record(GL_TRACE_ENABLE, { capability });
+		enable(capability);
+	}
+
+	inline void APIENTRY traceDisable(GLenum capability)
+	{
+		if (isRecording())
+			record(GL_TRACE_DISABLE, { capability });
+		disable(capability);
+	}
+
+	inline void APIENTRY traceDepthFunc(GLenum function)
+	{
+		if (isRecording())
+			record(GL_TRACE_DEPTH_FUNC, { function });
+		depthFunc(function);
+	}
+
+	inline void APIENTRY traceDepthMask(GLboolean flag)
+	{
+		if (isRecording())
+			record(GL_TRACE_DEPTH_MASK, { flag });
+		depthMask(flag);
+	}
+
+	inline void APIENTRY traceBlendFunc(GLenum source, GLenum destination)
+	{
+		if (isRecording())
+			record(GL_TRACE_BLEND_FUNC, { source, destination });
+		blendFunc(source, destination);
+	}
+
+	inline void APIENTRY traceClipControl(GLenum origin, GLenum depth)
+	{
+		if (isRecording())
+			record(GL_TRACE_CLIP_CONTROL, { origin, depth });
+		clipControl(origin, depth);
+	}
+
+	inline void APIENTRY traceClearDepth(GLdouble depth)
+	{
+		if (isRecording())
+			record(GL_TRACE_CLEAR_DEPTH, { bits((float)depth) });
+		clearDepth(depth);
+	}
+
+	inline void APIENTRY traceClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		if (isRecording())
+			record(GL_TRACE_CLEAR_COLOR, { bits(red), bits(green), bits(blue), bits(alpha) });
+		clearColor(red, green, blue, alpha);
+	}
+
+	inline void APIENTRY traceViewport(GLint x, GLint y, GLsizei viewportWidth, GLsizei viewportHeight)
+	{
+		if (isRecording())
+			record(GL_TRACE_VIEWPORT, { (uint32_t)x, (uint32_t)y, (uint32_t)viewportWidth, (uint32_t)viewportHeight });
+		viewport(x, y, viewportWidth, viewportHeight);
+	}
+
+	inline void APIENTRY tracePixelStorei(GLenum name, GLint value)
+	{
+		if (isRecording())
+			record(GL_TRACE_PIXEL_STORE, { name, (uint32_t)value });
+		pixelStorei(name, value);
+	}
+
+	inline void APIENTRY traceClear(GLbitfield mask)
+	{
+		if (isRecording())
+			record(GL_TRACE_CLEAR, { mask });
+		clear(mask);
+	}
+
+	inline void APIENTRY traceUseProgram(GLuint program)
+	{
+		if (isRecording())
+		{
+			captureProgram(program);
+			record(GL_TRACE_USE_PROGRAM, { program });
+		}
+		useProgram(program);
+	}
+
+	inline void APIENTRY traceBindVertexArray(GLuint array)
+	{
+		if (isRecording())
+		{
+			captureVertexArray(array);
+			record(GL_TRACE_BIND_VERTEX_ARRAY, { array });
+		}
+		bindVertexArray(array);
+	}
+
+	inline void APIENTRY traceActiveTexture(GLenum unit)
+	{
+		if (isRecording())
+			record(GL_TRACE_ACTIVE_TEXTURE, { unit });
+		activeTexture(unit);
+	}
+
+	inline void APIENTRY traceBindTexture(GLenum target, GLuint texture)
+	{
+		if (isRecording())
+		{
+			captureTexture(texture);
+			record(GL_TRACE_BIND_TEXTURE, { target, texture });
+		}
+		bindTexture(target, texture);
+	}
+
+	inline void APIENTRY traceBindBuffer(GLenum target, GLuint buffer)
+	{
+		if (isRecording())
+		{
+			captureBuffer(buffer);
+			record(GL_TRACE_BIND_BUFFER, { target, buffer });
+		}
+		bindBuffer(target, buffer);
+	}
+
+	inline void APIENTRY traceBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		if (isRecording())
+		{
+			captureBuffer(buffer);
+			record(GL_TRACE_BIND_BUFFER_BASE, { target, index, buffer });
+		}
+		bindBufferBase(target, index, buffer);
+	}
+
+	inline void APIENTRY traceBindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		if (isRecording())
+		{
+			captureFramebuffer(framebuffer);
+			record(GL_TRACE_BIND_FRAMEBUFFER, { target, framebuffer });
+		}
+		bindFramebuffer(target, framebuffer);
+	}
+
+	inline void APIENTRY traceBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+		GLenum access, GLenum format)
+	{
+		if (isRecording())
+		{
+			captureTexture(texture);
+			record(GL_TRACE_BIND_IMAGE_TEXTURE, { unit, texture, (uint32_t)level, layered, (uint32_t)layer, access, format });
+		}
+		bindImageTexture(unit, texture, level, layered, layer, access, format);
+	}
+
+	inline void APIENTRY traceUniform1i(GLint location, GLint value)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_1I, { (uint32_t)location, (uint32_t)value });
+		uniform1i(location, value);
+	}
+
+	inline void APIENTRY traceUniform1ui(GLint location, GLuint value)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_1UI, { (uint32_t)location, value });
+		uniform1ui(location, value);
+	}
+
+	inline void APIENTRY traceUniform1f(GLint location, GLfloat value)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_1F, { (uint32_t)location, bits(value) });
+		uniform1f(location, value);
+	}
+
+	inline void APIENTRY traceUniform2f(GLint location, GLfloat x, GLfloat y)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_2F, { (uint32_t)location, bits(x), bits(y) });
+		uniform2f(location, x, y);
+	}
+
+	inline void APIENTRY traceUniform4fv(GLint location, GLsizei count, const GLfloat* values)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_4FV, { (uint32_t)location, (uint32_t)count }, values, count * 4 * sizeof(GLfloat));
+		uniform4fv(location, count, values);
+	}
+
+	inline void APIENTRY traceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* values)
+	{
+		if (isRecording())
+			record(GL_TRACE_UNIFORM_MATRIX_4FV, { (uint32_t)location, (uint32_t)count, transpose }, values, count * 16 * sizeof(GLfloat));
+		uniformMatrix4fv(location, count, transpose, values);
+	}
+
+	inline void APIENTRY traceBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (isRecording())
+		{
+			captureBuffer(getBoundBuffer(target));
+			record(GL_TRACE_BUFFER_DATA, { target, (uint32_t)size, usage }, data, data != NULL ? (size_t)size : 0);
+		}
+		bufferData(target, size, data, usage);
+	}
+
+	inline void APIENTRY traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		if (isRecording())
+		{
+			captureBuffer(getBoundBuffer(target));
+			record(GL_TRACE_BUFFER_SUB_DATA, { target, (uint32_t)offset }, data, (size_t)size);
+		}
+		bufferSubData(target, offset, size, data);
+	}
+
+	inline void APIENTRY traceTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei imageWidth, GLsizei imageHeight,
+		GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		if (isRecording())
+		{
+			captureTexture(getBoundTexture2D());
+			record(GL_TRACE_TEX_IMAGE_2D, { target, (uint32_t)level, (uint32_t)internalFormat, (uint32_t)imageWidth, (uint32_t)imageHeight,
+				format, type }, pixels, pixels != NULL ? getImageBytes(imageWidth, imageHeight, format, type) : 0);
+		}
+		texImage2D(target, level, internalFormat, imageWidth, imageHeight, border, format, type, pixels);
+	}
+
+	inline void APIENTRY traceTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei imageWidth, GLsizei imageHeight,
+		GLenum format, GLenum type, const void* pixels)
+	{
+		if (isRecording())
+		{
+			captureTexture(getBoundTexture2D());
+			record(GL_TRACE_TEX_SUB_IMAGE_2D, { target, (uint32_t)level, (uint32_t)x, (uint32_t)y, (uint32_t)imageWidth, (uint32_t)imageHeight,
+				format, type }, pixels, getImageBytes(imageWidth, imageHeight, format, type));
+		}
+		texSubImage2D(target, level, x, y, imageWidth, imageHeight, format, type, pixels);
+	}
+
+	inline void APIENTRY traceDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ARRAYS, { mode, (uint32_t)first, (uint32_t)count });
+		}
+		drawArrays(mode, first, count);
+	}
+
+	inline void APIENTRY traceDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ELEMENTS, { mode, (uint32_t)count, type, (uint32_t)(uintptr_t)indices });
+		}
+		drawElements(mode, count, type, indices);
+	}
+
+	inline void APIENTRY traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ARRAYS_INSTANCED, { mode, (uint32_t)first, (uint32_t)count, (uint32_t)instanceCount });
+		}
+		drawArraysInstanced(mode, first, count, instanceCount);
+	}
+
+	inline void APIENTRY traceDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ELEMENTS_INSTANCED, { mode, (uint32_t)count, type, (uint32_t)(uintptr_t)indices, (uint32_t)instanceCount });
+		}
+		drawElementsInstanced(mode, count, type, indices, instanceCount);
+	}
+
+	inline void APIENTRY traceDrawArraysIndirect(GLenum mode, const void* indirect)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ARRAYS_INDIRECT, { mode, (uint32_t)(uintptr_t)indirect });
+		}
+		drawArraysIndirect(mode, indirect);
+	}
+
+	inline void APIENTRY traceDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DRAW_ELEMENTS_INDIRECT, { mode, type, (uint32_t)(uintptr_t)indirect });
+		}
+		drawElementsIndirect(mode, type, indirect);
+	}
+
+	inline void APIENTRY traceBlitFramebuffer(GLint sourceX0, GLint sourceY0, GLint sourceX1, GLint sourceY1,
+		GLint destinationX0, GLint destinationY0, GLint destinationX1, GLint destinationY1, GLbitfield mask, GLenum filter)
+	{
+		if (isRecording())
+			record(GL_TRACE_BLIT_FRAMEBUFFER, { (uint32_t)sourceX0, (uint32_t)sourceY0, (uint32_t)sourceX1, (uint32_t)sourceY1,
+				(uint32_t)destinationX0, (uint32_t)destinationY0, (uint32_t)destinationX1, (uint32_t)destinationY1, mask, filter });
+		blitFramebuffer(sourceX0, sourceY0, sourceX1, sourceY1, destinationX0, destinationY0, destinationX1, destinationY1, mask, filter);
+	}
+
+	inline void APIENTRY traceDispatchCompute(GLuint x, GLuint y, GLuint z)
+	{
+		if (isRecording())
+		{
+			recordMappedWrites();
+			record(GL_TRACE_DISPATCH_COMPUTE, { x, y, z });
+		}
+		dispatchCompute(x, y, z);
+	}
+
+	inline void APIENTRY traceMemoryBarrier(GLbitfield barriers)
+	{
+		if (isRecording())
+			record(GL_TRACE_MEMORY_BARRIER, { barriers });
+		memoryBarrier(barriers);
+	}
+
+	inline void APIENTRY tracePushDebugGroup(GLenum source, GLuint id, GLsizei length, const GLchar* message)
+	{
+		if (isRecording())
+			record(GL_TRACE_PUSH_GROUP, {}, message, length >= 0 ? (size_t)length : std::strlen(message));
+		pushDebugGroup(source, id, length, message);
+	}
+
+	inline void APIENTRY tracePopDebugGroup()
+	{
+		if (isRecording())
+			record(GL_TRACE_POP_GROUP, {});
+		popDebugGroup();
+	}
+
+	// persistent mappings are tracked all the time, they are made long before a capture
+	inline void* APIENTRY traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		void* pointer = mapBufferRange(target, offset, length, access);
+		if (pointer != NULL && (access & GL_MAP_PERSISTENT_BIT) != 0 && (access & GL_MAP_WRITE_BIT) != 0)
+			mappedBuffers[getBoundBuffer(target)] = { (unsigned char*)pointer, (size_t)offset, (size_t)length, {}, false };
+		return pointer;
+	}
+
+	inline GLboolean APIENTRY traceUnmapBuffer(GLenum target)
+	{
+		mappedBuffers.erase(getBoundBuffer(target));
+		return unmapBuffer(target);
+	}
+
+	template <typename Function>
+	void hook(Function& entryPoint, Function& original, Function tracing)
+	{
+		// installing twice would make the hook call itself
+		if (entryPoint == NULL || entryPoint == tracing)
+			return;
+		original = entryPoint;
+		entryPoint = tracing;
+	}
+}
+
+/* Records the GL calls of one frame into a trace file, see gl_trace_format.h, for
+   src/tools/gl_trace_replay.cpp to replay offline. Like RenderStats the recording hooks are
+   swapped into glad's function pointers, so the call sites stay as they are, and the objects
+   the frame uses are read back from GL when it first uses them. Calls that only read state
+   or synchronize (queries, fences) are not recorded, the replayer times the frame itself.
+   Writes through persistent mappings are recorded as the changed bytes before each draw.
+   Render thread only. */
+class GLTraceRecorder
+{
+public:
+	// call once after glad is loaded, before any buffer is mapped, and after
+	// RenderStats::installHooks() so the counting stays behind the recording
+	static void installHooks()
+	{
+		using namespace gl_trace_detail;
+		hook(glad_glEnable, enable, traceEnable);
+		hook(glad_glDisable, disable, traceDisable);
+		hook(glad_glDepthFunc, depthFunc, traceDepthFunc);
+		hook(glad_glDepthMask, depthMask, traceDepthMask);
+		hook(glad_glBlendFunc, blendFunc, traceBlendFunc);
+		hook(glad_glClipControl, clipControl, traceClipControl);
+		hook(glad_glClearDepth, clearDepth, traceClearDepth);
+		hook(glad_glClearColor, clearColor, traceClearColor);
+		hook(glad_glViewport, viewport, traceViewport);
+		hook(glad_glPixelStorei, pixelStorei, tracePixelStorei);
+		hook(glad_glClear, clear, traceClear);
+		hook(glad_glUseProgram, useProgram, traceUseProgram);
+		hook(glad_glBindVertexArray, bindVertexArray, traceBindVertexArray);
+		hook(glad_glActiveTexture, activeTexture, traceActiveTexture);
+		hook(glad_glBindTexture, bindTexture, traceBindTexture);
+		hook(glad_glBindBuffer, bindBuffer, traceBindBuffer);
+		hook(glad_glBindBufferBase, bindBufferBase, traceBindBufferBase);
+		hook(glad_glBindFramebuffer, bindFramebuffer, traceBindFramebuffer);
+		hook(glad_glBindImageTexture, bindImageTexture, traceBindImageTexture);
+		hook(glad_glUniform1i, uniform1i, traceUniform1i);
+		hook(glad_glUniform1ui, uniform1ui, traceUniform1ui);
+		hook(glad_glUniform1f, uniform1f, traceUniform1f);
+		hook(glad_glUniform2f, uniform2f, traceUniform2f);
+		hook(glad_glUniform4fv, uniform4fv, traceUniform4fv);
+		hook(glad_glUniformMatrix4fv, uniformMatrix4fv, traceUniformMatrix4fv);
+		hook(glad_glBufferData, bufferData, traceBufferData);
+		hook(glad_glBufferSubData, bufferSubData, traceBufferSubData);
+		hook(glad_glTexImage2D, texImage2D, traceTexImage2D);
+		hook(glad_glTexSubImage2D, texSubImage2D, traceTexSubImage2D);
+		hook(glad_glDrawArrays, drawArrays, traceDrawArrays);
+		hook(glad_glDrawElements, drawElements, traceDrawElements);
+		hook(glad_glDrawArraysInstanced, drawArraysInstanced, traceDrawArraysInstanced);
+		hook(glad_glDrawElementsInstanced, drawElementsInstanced, traceDrawElementsInstanced);
+		hook(glad_glDrawArraysIndirect, drawArraysIndirect, traceDrawArraysIndirect);
+		hook(glad_glDrawElementsIndirect, drawElementsIndirect, traceDrawElementsIndirect);
+		hook(glad_glBlitFramebuffer, blitFramebuffer, traceBlitFramebuffer);
+		hook(glad_glDispatchCompute, dispatchCompute, traceDispatchCompute);
+		hook(glad_glMemoryBarrier, memoryBarrier, traceMemoryBarrier);
+		hook(glad_glPushDebugGroup, pushDebugGroup, tracePushDebugGroup);
+		hook(glad_glPopDebugGroup, popDebugGroup, tracePopDebugGroup);
+		hook(glad_glMapBufferRange, mapBufferRange, traceMapBufferRange);
+		hook(glad_glUnmapBuffer, unmapBuffer, traceUnmapBuffer);
+	}
+
+	// starts recording at the beginning of a frame drawn to a default framebuffer of the given size
+	static void beginCapture(int framebufferWidth, int framebufferHeight)
+	{
+		using namespace gl_trace_detail;
+		setup.clear();
+		reset.clear();
+		frame.clear();
+		frameCommands = 0;
+		buffers.clear();
+		textures.clear();
+		programs.clear();
+		vertexArrays.clear();
+		framebuffers.clear();
+		for (auto& entry : mappedBuffers)
+			entry.second.captured = false;
+		width = (uint32_t)framebufferWidth;
+		height = (uint32_t)framebufferHeight;
+		captureState();
+		recording = true;
+	}
+
+	static bool isCapturing()
+	{
+		return gl_trace_detail::recording;
+	}
+
+	// stops recording and writes the trace
+	static bool endCapture(const char* path)
+	{
+		using namespace gl_trace_detail;
+		recording = false;
+		GLTraceHeader header = { GL_TRACE_MAGIC, GL_TRACE_VERSION, width, height,
+			(uint32_t)setup.size(), (uint32_t)reset.size(), (uint32_t)frame.size() };
+		std::ofstream file(path, std::ios::binary);
+		if (!file.write((const char*)&header, sizeof(header))
+			|| !file.write((const char*)setup.data(), setup.size())
+			|| !file.write((const char*)reset.data(), reset.size())
+			|| !file.write((const char*)frame.data(), frame.size()))
+		{
+			std::cout << "ERROR::GL_TRACE::FILE_NOT_SUCCESFULLY_WRITTEN " << path << std::endl;
+			return false;
+		}
+		std::cout << "GL_TRACE " << frameCommands << " calls, " << setup.size() / 1024 << " KB of objects, "
+			<< frame.size() / 1024 << " KB of frame written to " << path << std::endl;
+		return true;
+	}
+};
+
+#endif
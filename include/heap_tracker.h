@@ -0,0 +1,258 @@
+#ifndef HEAP_TRACKER_H
+#define HEAP_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+/* Counts every heap allocation of the program. src/heap_tracker.cpp replaces the global
+   operator new and delete, and stb_image allocates through allocate(), so containers,
+   strings and image loads are all seen; memory the driver or GLFW takes with their own
+   malloc is not.
+
+   An allocation is attributed to the memory tag of the thread that made it: a subsystem
+   ("textures", "shaders") set with a TagScope around its setup, or a frame phase, which
+   PerfCounters sets for the phases it scopes. printReport() lists the allocations and the
+   peak of live bytes per tag. FrameAllocations checks that a thread's steady frames do not
+   allocate at all, and while it does, the call stack of every allocation is kept in a few
+   call sites for printCallSites() */
+class HeapTracker
+{
+public:
+	static const int MAX_TAGS = 32;
+	static const int MAX_TAG_NAME = 32;
+	static const int MAX_CALL_SITES = 16;
+	static const int CALL_STACK_DEPTH = 12;
+	static const int UNTAGGED = 0;
+
+	enum TagFlags
+	{
+		TAG_EXEMPT = 1 // expected to grow while running, e.g. a recording. not counted against frames
+	};
+
+	struct Totals
+	{
+		uint64_t allocations;
+		uint64_t bytes;
+	};
+
+	/* Sets the calling thread's tag for its lifetime */
+	class TagScope
+	{
+	public:
+		explicit TagScope(int tag)
+			: previous(setThreadTag(tag))
+		{
+		}
+
+		~TagScope()
+		{
+			setThreadTag(previous);
+		}
+
+		TagScope(const TagScope&) = delete;
+		TagScope& operator=(const TagScope&) = delete;
+
+	private:
+		int previous;
+	};
+
+	// the same name always gives the same tag, so phases of several threads add up.
+	// UNTAGGED once all tags are taken
+	static int registerTag(const char* name, unsigned int flags = 0)
+	{
+		std::lock_guard<std::mutex> guard(tagMutex);
+		int count = tagCount.load(std::memory_order_relaxed);
+		for (int i = 1; i < count; i++)
+			if (std::strncmp(tags[i].name, name, MAX_TAG_NAME - 1) == 0)
+				return i;
+		if (count == MAX_TAGS)
+		{
+			std::cout << "ERROR::HEAP_TRACKER::TOO_MANY_TAGS " << name << std::endl;
+			return UNTAGGED;
+		}
+		std::strncpy(tags[count].name, name, MAX_TAG_NAME - 1);
+		tags[count].flags = flags;
+		tagCount.store(count + 1, std::memory_order_release);
+		return count;
+	}
+
+	// returns the tag the thread had
+	static int setThreadTag(int tag)
+	{
+		int previous = threadTag;
+		threadTag = tag;
+		return previous;
+	}
+
+	static int getThreadTag()
+	{
+		return threadTag;
+	}
+
+	// allocations of the calling thread so far, exempt tags left out
+	static Totals getThreadTotals()
+	{
+		return threadTotals;
+	}
+
+	// keeps the call stacks of the calling thread's allocations while set
+	static void setCaptureCallSites(bool capture)
+	{
+		captureCallSites = capture;
+	}
+
+	static uint64_t getLiveBytes()
+	{
+		return liveBytes.load(std::memory_order_relaxed);
+	}
+
+	static uint64_t getPeakBytes()
+	{
+		return peakBytes.load(std::memory_order_relaxed);
+	}
+
+	// malloc, realloc and free with the same bookkeeping as operator new and delete, in src/heap_tracker.cpp
+	static void* allocate(size_t size);
+	static void* reallocate(void* pointer, size_t size);
+	static void release(void* pointer);
+
+	// allocations, bytes, live and peak bytes per tag
+	static void printReport()
+	{
+		std::printf("HEAP_TRACKER peak %.1f KB, live %.1f KB\n", getPeakBytes() / 1024.0, getLiveBytes() / 1024.0);
+		std::printf("%-20s %12s %12s %12s %12s\n", "tag", "allocations", "alloc_kb", "live_kb", "peak_kb");
+		int count = tagCount.load(std::memory_order_acquire);
+		for (int i = 0; i < count; i++)
+		{
+			const TagStats& tag = tags[i];
+			uint64_t allocations = tag.allocations.load(std::memory_order_relaxed);
+			if (allocations == 0)
+				continue;
+			std::printf("%-20s %12llu %12.1f %12.1f %12.1f\n", getTagName(i), (unsigned long long)allocations,
+				tag.bytes.load(std::memory_order_relaxed) / 1024.0, tag.liveBytes.load(std::memory_order_relaxed) / 1024.0,
+				tag.peakBytes.load(std::memory_order_relaxed) / 1024.0);
+		}
+	}
+
+	// the stacks kept by setCaptureCallSites(), most allocations first, in src/heap_tracker.cpp
+	static void printCallSites();
+
+	static const char* getTagName(int tag)
+	{
+		return tag == UNTAGGED ? "untagged" : tags[tag].name;
+	}
+
+	static void clearCallSites()
+	{
+		std::lock_guard<std::mutex> guard(callSiteMutex);
+		callSiteCount = 0;
+		droppedCallSites = 0;
+	}
+
+private:
+	// zero in static storage, tag 0 is UNTAGGED and has no name
+	struct TagStats
+	{
+		char name[MAX_TAG_NAME];
+		unsigned int flags;
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> liveBytes;
+		std::atomic<uint64_t> peakBytes;
+	};
+
+	struct CallSite
+	{
+		void* frames[CALL_STACK_DEPTH];
+		int depth;
+		int tag;
+		uint64_t allocations;
+		uint64_t bytes;
+	};
+
+	// constant initialized, so they are ready before the first operator new of any static constructor
+	static inline TagStats tags[MAX_TAGS];
+	static inline std::atomic<int> tagCount{ 1 };
+	static inline std::mutex tagMutex;
+	static inline std::atomic<uint64_t> liveBytes{ 0 };
+	static inline std::atomic<uint64_t> peakBytes{ 0 };
+	static inline thread_local int threadTag = UNTAGGED;
+	static inline thread_local Totals threadTotals;
+	static inline thread_local bool captureCallSites = false;
+	static inline CallSite callSites[MAX_CALL_SITES];
+	static inline int callSiteCount = 0;
+	static inline uint64_t droppedCallSites = 0; // allocations whose stack found no free call site
+	static inline std::mutex callSiteMutex;
+
+	friend struct HeapTrackerHooks;
+};
+
+/* Per frame allocations of the thread that owns it. The first warmUpFrames frames may
+   allocate, vectors grow to their working size there; every later frame that allocates is
+   counted, and its allocations leave their call stacks with HeapTracker */
+class FrameAllocations
+{
+public:
+	FrameAllocations(const char* name, uint64_t warmUpFrames)
+		: name(name), warmUpFrames(warmUpFrames)
+	{
+	}
+
+	void beginFrame()
+	{
+		start = HeapTracker::getThreadTotals();
+		HeapTracker::setCaptureCallSites(frames >= warmUpFrames);
+	}
+
+	void endFrame()
+	{
+		HeapTracker::setCaptureCallSites(false);
+		HeapTracker::Totals end = HeapTracker::getThreadTotals();
+		uint64_t allocations = end.allocations - start.allocations;
+		if (frames++ < warmUpFrames || allocations == 0)
+			return;
+		allocatingFrames++;
+		totals.allocations += allocations;
+		totals.bytes += end.bytes - start.bytes;
+		if (allocations > maxAllocations)
+			maxAllocations = allocations;
+	}
+
+	uint64_t getSteadyFrames() const
+	{
+		return frames > warmUpFrames ? frames - warmUpFrames : 0;
+	}
+
+	uint64_t getAllocatingFrames() const
+	{
+		return allocatingFrames;
+	}
+
+	void printReport() const
+	{
+		if (allocatingFrames == 0)
+		{
+			std::cout << "HEAP_TRACKER " << name << ": none of " << getSteadyFrames() << " steady frames allocated" << std::endl;
+			return;
+		}
+		std::printf("ERROR::HEAP_TRACKER::FRAME_ALLOCATED %s: %llu of %llu steady frames, %.1f allocations and %.0f bytes per allocating frame, at most %llu\n",
+			name, (unsigned long long)allocatingFrames, (unsigned long long)getSteadyFrames(),
+			(double)totals.allocations / allocatingFrames, (double)totals.bytes / allocatingFrames, (unsigned long long)maxAllocations);
+	}
+
+private:
+	const char* name;
+	uint64_t warmUpFrames;
+	uint64_t frames = 0;
+	HeapTracker::Totals start = {};
+	HeapTracker::Totals totals = {}; // of the allocating steady frames
+	uint64_t allocatingFrames = 0;
+	uint64_t maxAllocations = 0;
+};
+
+#endif
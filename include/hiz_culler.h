@@ -0,0 +1,257 @@
+#ifndef HIZ_CULLER_H
+#define HIZ_CULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <compute_shader.h>
+#include <frustum.h>
+
+#include <algorithm>
+#include <cstddef>
+
+/* Per object data read by the cull and draw shaders, laid out for std430 */
+struct CullObject
+{
+	glm::mat4 model;
+	glm::vec4 boundsMin; // world space, w unused
+	glm::vec4 boundsMax;
+};
+
+/* Two phase occlusion culling on the GPU against a hierarchical depth (Hi-Z) pyramid:
+    1. every object is tested against the frustum and last frame's pyramid; passing objects
+       are appended to the first indirect draw, rejected ones are kept in a list
+    2. the first draw is rendered and the pyramid rebuilt from its depth
+    3. the rejected list is tested again against the new pyramid and the objects that became
+       visible are appended to the second indirect draw
+   All draws are one instanced glDrawArraysIndirect per phase whose instance count is written
+   by the cull shader, so nothing is read back to the CPU. The draw shader looks its object up
+   through gl_InstanceID in the visible list of the phase.
+
+   Pyramid level 0 is the depth size rounded down to a power of two and every level keeps the
+   farthest depth of the texels below it. Needs OpenGL 4.3 (compute, SSBOs, indirect draws). */
+class HiZCuller
+{
+public:
+	enum Phase { PHASE_FIRST, PHASE_SECOND, PHASE_COUNT };
+
+	// loads both compute programs, returns false if either failed
+	bool create(const char* cullPath, const char* downsamplePath)
+	{
+		if (!cullShader.load(cullPath) || !downsampleShader.load(downsamplePath))
+			return false;
+
+		glGenBuffers(1, &objectBuffer);
+		glGenBuffers(1, &commandBuffer);
+		glGenBuffers(PHASE_COUNT, visibleBuffers);
+		glGenBuffers(1, &rejectedBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Commands), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return true;
+	}
+
+	void destroy()
+	{
+		cullShader.destroy();
+		downsampleShader.destroy();
+		if (objectBuffer == 0)
+			return;
+		glDeleteBuffers(1, &objectBuffer);
+		glDeleteBuffers(1, &commandBuffer);
+		glDeleteBuffers(PHASE_COUNT, visibleBuffers);
+		glDeleteBuffers(1, &rejectedBuffer);
+		glDeleteTextures(1, &pyramid);
+		objectBuffer = commandBuffer = rejectedBuffer = pyramid = 0;
+		visibleBuffers[PHASE_FIRST] = visibleBuffers[PHASE_SECOND] = 0;
+		objectCapacity = 0;
+	}
+
+	// (re)creates the pyramid for a depth buffer of the given size. the old pyramid is
+	// dropped, so the next first phase lets everything in the frustum through
+	void resize(int depthWidth, int depthHeight, bool reverseDepth)
+	{
+		reverseZ = reverseDepth;
+		pyramidWidth = previousPowerOfTwo(depthWidth);
+		pyramidHeight = previousPowerOfTwo(depthHeight);
+		pyramidLevels = 1;
+		while ((std::max(pyramidWidth, pyramidHeight) >> pyramidLevels) > 0)
+			pyramidLevels++;
+
+		glDeleteTextures(1, &pyramid);
+		glGenTextures(1, &pyramid);
+		glBindTexture(GL_TEXTURE_2D, pyramid);
+		glTexStorage2D(GL_TEXTURE_2D, pyramidLevels, GL_R32F, pyramidWidth, pyramidHeight);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		pyramidValid = false;
+	}
+
+	/* Uploads this frame's objects and resets both indirect draws to vertexCount vertices
+	   and no instances */
+	void beginFrame(const CullObject* objects, size_t count, unsigned int vertexCount)
+	{
+		objectCount = (unsigned int)count;
+		if (count > objectCapacity)
+		{
+			// grow geometrically so a slowly growing scene does not reallocate every frame
+			objectCapacity = std::max(count, objectCapacity * 2);
+			allocateStorage(objectBuffer, objectCapacity * sizeof(CullObject));
+			allocateStorage(visibleBuffers[PHASE_FIRST], objectCapacity * sizeof(GLuint));
+			allocateStorage(visibleBuffers[PHASE_SECOND], objectCapacity * sizeof(GLuint));
+			allocateStorage(rejectedBuffer, objectCapacity * sizeof(GLuint));
+		}
+		if (count > 0)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(CullObject), objects);
+		}
+
+		Commands commands = {};
+		for (DrawArraysIndirectCommand& command : commands.draws)
+			command.count = vertexCount;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Commands), &commands);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* Fills the indirect draw of a phase. The first phase tests against the pyramid from
+	   the last endFrame(), the second against the one from the last buildPyramid() */
+	void cull(Phase phase, const glm::mat4& viewProjection)
+	{
+		if (objectCount == 0)
+			return;
+		const glm::mat4& testViewProjection = phase == PHASE_FIRST ? pyramidViewProjection : viewProjection;
+		Frustum frustum(viewProjection, reverseZ);
+
+		cullShader.use();
+		cullShader.setUint("objectCount", objectCount);
+		cullShader.setInt("phase", (int)phase);
+		cullShader.setInt("pyramidValid", pyramidValid);
+		cullShader.setInt("reverseZ", reverseZ);
+		cullShader.setInt("pyramid", TEXTURE_UNIT);
+		glUniform4fv(glGetUniformLocation(cullShader.ID, "frustumPlanes"), Frustum::PLANE_COUNT, glm::value_ptr(frustum.planes[0]));
+		glUniformMatrix4fv(glGetUniformLocation(cullShader.ID, "pyramidViewProjection"), 1, GL_FALSE, glm::value_ptr(testViewProjection));
+
+		glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, pyramid);
+		glActiveTexture(GL_TEXTURE0);
+		bindBuffers(phase);
+		ComputeShader::dispatchCovering(objectCount, 1, CULL_GROUP_SIZE, 1);
+		// the draw reads the instance count as a command and the indices from a buffer
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	// draws the objects that passed the phase's test. the draw program and vertex array
+	// must be bound
+	void draw(Phase phase)
+	{
+		if (objectCount == 0)
+			return;
+		bindBuffers(phase);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glDrawArraysIndirect(GL_TRIANGLES, (const void*)(phase * sizeof(DrawArraysIndirectCommand)));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	/* Rebuilds the pyramid from a depth texture. The texture must not be attached to the
+	   bound framebuffer, sampling it there would be a feedback loop */
+	void buildPyramid(unsigned int depthTexture)
+	{
+		downsampleShader.use();
+		downsampleShader.setInt("reverseZ", reverseZ);
+		downsampleShader.setInt("depthTexture", TEXTURE_UNIT);
+		glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+		for (int level = 0; level < pyramidLevels; level++)
+		{
+			downsampleShader.setInt("fromDepth", level == 0);
+			glBindImageTexture(0, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			if (level > 0)
+				glBindImageTexture(1, pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			ComputeShader::dispatchCovering(std::max(pyramidWidth >> level, 1), std::max(pyramidHeight >> level, 1),
+				PYRAMID_GROUP_SIZE, PYRAMID_GROUP_SIZE);
+			// each level reads the one written just before
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		// the depth texture goes back to being a render target
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glActiveTexture(GL_TEXTURE0);
+		pyramidValid = true;
+	}
+
+	// remembers the camera the pyramid was last built with, for the next frame's first phase
+	void endFrame(const glm::mat4& viewProjection)
+	{
+		pyramidViewProjection = viewProjection;
+	}
+
+private:
+	static constexpr int TEXTURE_UNIT = 7; // keeps the lower units free for the draw shaders
+	static constexpr unsigned int CULL_GROUP_SIZE = 64; // local_size_x of occlusion_cull.comp
+	static constexpr unsigned int PYRAMID_GROUP_SIZE = 8; // local_size of hiz_downsample.comp
+
+	struct DrawArraysIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	// matches the Commands block of occlusion_cull.comp
+	struct Commands
+	{
+		DrawArraysIndirectCommand draws[PHASE_COUNT];
+		GLuint rejectedCount;
+		GLuint padding[3];
+	};
+
+	ComputeShader cullShader;
+	ComputeShader downsampleShader;
+
+	unsigned int objectBuffer = 0;
+	unsigned int commandBuffer = 0;
+	unsigned int visibleBuffers[PHASE_COUNT] = {};
+	unsigned int rejectedBuffer = 0;
+	size_t objectCapacity = 0;
+	unsigned int objectCount = 0;
+
+	unsigned int pyramid = 0;
+	int pyramidWidth = 0;
+	int pyramidHeight = 0;
+	int pyramidLevels = 0;
+	bool pyramidValid = false;
+	glm::mat4 pyramidViewProjection = glm::mat4(1.0f);
+	bool reverseZ = false;
+
+	static int previousPowerOfTwo(int value)
+	{
+		int power = 1;
+		while (power * 2 <= value)
+			power *= 2;
+		return power;
+	}
+
+	static void allocateStorage(unsigned int buffer, size_t size)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	}
+
+	// binding points shared by occlusion_cull.comp and shader_culled.vs
+	void bindBuffers(Phase phase)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objectBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, visibleBuffers[phase]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, rejectedBuffer);
+	}
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef INSTANCE_BENCHMARK_H
+#define INSTANCE_BENCHMARK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <shader.h>
+#include <shader_preprocessor.h>
+#include <instancing.h>
+#include <packed_instance.h>
+#include <timing.h>
+#include <transform.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/* Compares PackedInstance against a full model matrix per instance:
+    - CPU: building the matrices versus packing the transforms, scalar and SIMD
+    - upload: orphaning and refilling the instance buffer, timed to glFinish
+    - vertex stage: an instanced draw of the mesh with rasterization disabled, timed with a
+      GL_TIME_ELAPSED query, so the difference is the instance fetch and decode cost
+   Every measurement is repeated and the fastest run reported, which filters out scheduling
+   noise. createMesh must return a vertex array object with positions at location 0 and
+   texture coordinates at location 1, the packed instances are drawn with the
+   PACKED_INSTANCING variant of the cube shader at vertexPath. */
+class InstanceBenchmark
+{
+public:
+	static const size_t INSTANCE_COUNT = 1000000;
+	static const int REPETITIONS = 10;
+
+	static void run(unsigned int (*createMesh)(), int vertexCount,
+		const char* vertexPath, const char* matrixVertexPath, const char* fragmentPath)
+	{
+		std::vector<Transform> transforms = createTransforms();
+		std::vector<glm::mat4> matrices(INSTANCE_COUNT);
+		std::vector<PackedInstance> packed(INSTANCE_COUNT);
+
+		double matrixBuild = measure([&]() {
+			for (size_t i = 0; i < INSTANCE_COUNT; i++)
+				matrices[i] = transforms[i].toMatrix();
+		});
+		double scalarPack = measure([&]() {
+			for (size_t i = 0; i < INSTANCE_COUNT; i++)
+				packed[i] = packInstance(transforms[i]);
+		});
+		double simdPack = measure([&]() {
+			packInstances(transforms.data(), INSTANCE_COUNT, packed.data());
+		});
+
+		unsigned int matrixVAO = createMesh();
+		unsigned int matrixVBO = createMatrixInstanceBuffer(matrixVAO);
+		unsigned int packedVAO = createMesh();
+		unsigned int packedVBO = createPackedInstanceBuffer(packedVAO);
+
+		double matrixUpload = measure([&]() {
+			uploadInstances(matrixVBO, matrices.data(), matrices.size());
+			glFinish();
+		});
+		double packedUpload = measure([&]() {
+			uploadInstances(packedVBO, packed.data(), packed.size());
+			glFinish();
+		});
+
+		Shader matrixShader(matrixVertexPath, fragmentPath);
+		ShaderPreprocessor preprocessor;
+		preprocessor.define("PACKED_INSTANCING");
+		Shader packedShader = Shader::fromSource(preprocessor.process(vertexPath), preprocessor.process(fragmentPath));
+		double matrixDraw = measureVertexStage(matrixShader, matrixVAO, vertexCount);
+		double packedDraw = measureVertexStage(packedShader, packedVAO, vertexCount);
+
+		std::cout << "INSTANCE_BENCHMARK instances: " << INSTANCE_COUNT << " vertices per instance: " << vertexCount << std::endl;
+		std::cout << "  bytes per instance   mat4: " << sizeof(glm::mat4) << "  packed: " << sizeof(PackedInstance) << std::endl;
+		std::cout << "  cpu build/pack ms    mat4: " << matrixBuild * 1000.0
+			<< "  packed scalar: " << scalarPack * 1000.0 << "  packed simd: " << simdPack * 1000.0 << std::endl;
+		std::cout << "  upload ms            mat4: " << matrixUpload * 1000.0
+			<< " (" << bandwidth(sizeof(glm::mat4), matrixUpload) << " GB/s)"
+			<< "  packed: " << packedUpload * 1000.0
+			<< " (" << bandwidth(sizeof(PackedInstance), packedUpload) << " GB/s)" << std::endl;
+		std::cout << "  vertex stage ms      mat4: " << matrixDraw * 1000.0
+			<< " (" << bandwidth(sizeof(glm::mat4), matrixDraw) << " GB/s instance data)"
+			<< "  packed: " << packedDraw * 1000.0
+			<< " (" << bandwidth(sizeof(PackedInstance), packedDraw) << " GB/s instance data)" << std::endl;
+
+		glDeleteProgram(matrixShader.ID);
+		glDeleteProgram(packedShader.ID);
+		glDeleteBuffers(1, &matrixVBO);
+		glDeleteBuffers(1, &packedVBO);
+		glDeleteVertexArrays(1, &matrixVAO);
+		glDeleteVertexArrays(1, &packedVAO);
+	}
+
+private:
+	static std::vector<Transform> createTransforms()
+	{
+		// fixed seed so runs are comparable
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::normal_distribution<float> component(0.0f, 1.0f);
+		std::vector<Transform> transforms(INSTANCE_COUNT);
+		for (Transform& transform : transforms)
+		{
+			transform.position = glm::vec3(position(random), position(random), position(random));
+			transform.rotation = glm::normalize(glm::quat(component(random), component(random), component(random), component(random)));
+			transform.scale = glm::vec3(0.5f + 0.1f * std::abs(component(random)));
+		}
+		return transforms;
+	}
+
+	template <typename Body>
+	static double measure(Body body)
+	{
+		double fastest = 1e9;
+		for (int i = 0; i < REPETITIONS; i++)
+		{
+			double start = getSteadyTime();
+			body();
+			fastest = std::min(fastest, getSteadyTime() - start);
+		}
+		return fastest;
+	}
+
+	static double measureVertexStage(Shader& shader, unsigned int VAO, int vertexCount)
+	{
+		shader.use();
+		glm::mat4 identity(1.0f);
+		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, &identity[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, &identity[0][0]);
+		glBindVertexArray(VAO);
+		glEnable(GL_RASTERIZER_DISCARD);
+
+		unsigned int query;
+		glGenQueries(1, &query);
+		double fastest = 1e9;
+		for (int i = 0; i < REPETITIONS; i++)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, (GLsizei)INSTANCE_COUNT);
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds); // waits for the draw
+			fastest = std::min(fastest, (double)nanoseconds * 1e-9);
+		}
+		glDeleteQueries(1, &query);
+
+		glDisable(GL_RASTERIZER_DISCARD);
+		glBindVertexArray(0);
+		return fastest;
+	}
+
+	static double bandwidth(size_t bytesPerInstance, double seconds)
+	{
+		return seconds > 0.0 ? (double)(bytesPerInstance * INSTANCE_COUNT) / seconds * 1e-9 : 0.0;
+	}
+};
+
+#endif
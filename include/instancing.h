@@ -0,0 +1,68 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <packed_instance.h>
+
+#include <cstddef>
+
+// first attribute location after the mesh's position and texture coordinates
+const unsigned int INSTANCE_ATTRIBUTE_LOCATION = 2;
+
+/* Adds a per instance PackedInstance stream to a mesh's vertex array object and returns the
+   buffer feeding it. Matches the inputs of shader_instanced.vs */
+inline unsigned int createPackedInstanceBuffer(unsigned int VAO)
+{
+	unsigned int instanceVBO;
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	// position and uniform scale
+	glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PackedInstance), (void*)offsetof(PackedInstance, position));
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION);
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION, 1);
+
+	// orientation, the vertex fetch unpacks it to four normalized floats
+	glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION + 1, 4, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedInstance), (void*)offsetof(PackedInstance, orientation));
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION + 1);
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION + 1, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return instanceVBO;
+}
+
+/* Adds a per instance model matrix stream, one column per attribute location. Matches the
+   inputs of shader_instanced_matrix.vs */
+inline unsigned int createMatrixInstanceBuffer(unsigned int VAO)
+{
+	unsigned int instanceVBO;
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION + column);
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION + column, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return instanceVBO;
+}
+
+/* Replaces the contents of an instance buffer. Orphaning the old storage first lets the
+   driver hand out fresh memory instead of waiting for draws still reading the previous data */
+template <typename Instance>
+void uploadInstances(unsigned int instanceVBO, const Instance* instances, size_t count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(Instance), NULL, GL_STREAM_DRAW);
+	if (count > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Instance), instances);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/* Histogram of durations with log spaced buckets, in the style of HdrHistogram: every power of
+   two range is split into SUB_BUCKETS linear buckets, so any value is stored with a relative
+   error below 1 / SUB_BUCKETS (1.6%) from nanoseconds up to 18 minutes in a fixed 18 KB.
+   Recording is a few shifts and an increment, percentiles are a scan over the buckets.
+   Values are in nanoseconds, the seconds overloads convert. */
+class LatencyHistogram
+{
+public:
+	static const unsigned int SUB_BUCKET_BITS = 6;
+	static const unsigned int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const unsigned int MAX_VALUE_BITS = 40; // 2^40 ns
+	static const unsigned int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKETS + 2 * SUB_BUCKETS;
+
+	LatencyHistogram() : counts(BUCKET_COUNT, 0) {}
+
+	void record(uint64_t nanoseconds)
+	{
+		nanoseconds = std::min(nanoseconds, ((uint64_t)1 << MAX_VALUE_BITS) - 1);
+		counts[bucketIndex(nanoseconds)]++;
+		totalCount++;
+		sum += (double)nanoseconds;
+		minimum = std::min(minimum, nanoseconds);
+		maximum = std::max(maximum, nanoseconds);
+	}
+
+	void recordSeconds(double seconds)
+	{
+		record(seconds > 0.0 ? (uint64_t)std::llround(seconds * 1e9) : 0);
+	}
+
+	void add(const LatencyHistogram& other)
+	{
+		for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+			counts[i] += other.counts[i];
+		totalCount += other.totalCount;
+		sum += other.sum;
+		minimum = std::min(minimum, other.minimum);
+		maximum = std::max(maximum, other.maximum);
+	}
+
+	void reset()
+	{
+		std::fill(counts.begin(), counts.end(), 0);
+		totalCount = 0;
+		sum = 0.0;
+		minimum = UINT64_MAX;
+		maximum = 0;
+	}
+
+	uint64_t getCount() const { return totalCount; }
+	uint64_t getMin() const { return totalCount > 0 ? minimum : 0; }
+	uint64_t getMax() const { return maximum; }
+	double getMean() const { return totalCount > 0 ? sum / (double)totalCount : 0.0; }
+
+	/* The value at or below which percentile percent of the samples lie, reported as the top
+	   of its bucket like HdrHistogram, never above the largest recorded value */
+	uint64_t getPercentile(double percentile) const
+	{
+		if (totalCount == 0)
+			return 0;
+		uint64_t target = (uint64_t)std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * (double)totalCount);
+		target = std::max<uint64_t>(target, 1);
+		uint64_t seen = 0;
+		for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+		{
+			seen += counts[i];
+			if (seen >= target)
+				return std::min(highestInBucket(i), maximum);
+		}
+		return maximum;
+	}
+
+	// samples above threshold, exact when threshold is the top of a bucket and otherwise
+	// includes the threshold's own bucket
+	uint64_t getCountAbove(uint64_t threshold) const
+	{
+		uint64_t above = 0;
+		for (unsigned int i = bucketIndex(std::min(threshold, ((uint64_t)1 << MAX_VALUE_BITS) - 1)); i < BUCKET_COUNT; i++)
+			if (highestInBucket(i) > threshold)
+				above += counts[i];
+		return above;
+	}
+
+	static unsigned int bucketIndex(uint64_t value)
+	{
+		// values below 2 * SUB_BUCKETS have a bucket each
+		if (value < 2 * SUB_BUCKETS)
+			return (unsigned int)value;
+		unsigned int shift = highestBit(value) - SUB_BUCKET_BITS;
+		return shift * SUB_BUCKETS + (unsigned int)(value >> shift);
+	}
+
+	static uint64_t lowestInBucket(unsigned int index)
+	{
+		if (index < 2 * SUB_BUCKETS)
+			return index;
+		unsigned int shift = index / SUB_BUCKETS - 1;
+		return (uint64_t)(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+	}
+
+	static uint64_t highestInBucket(unsigned int index)
+	{
+		if (index < 2 * SUB_BUCKETS)
+			return index;
+		unsigned int shift = index / SUB_BUCKETS - 1;
+		return ((uint64_t)(index % SUB_BUCKETS + SUB_BUCKETS + 1) << shift) - 1;
+	}
+
+private:
+	std::vector<uint64_t> counts;
+	uint64_t totalCount = 0;
+	double sum = 0.0;
+	uint64_t minimum = UINT64_MAX;
+	uint64_t maximum = 0;
+
+	static unsigned int highestBit(uint64_t value)
+	{
+		unsigned int bit = 0;
+		while (value >>= 1)
+			bit++;
+		return bit;
+	}
+};
+
+#endif
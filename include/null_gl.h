@@ -0,0 +1,1242 @@
+#ifndef NULL_GL_H
+#define NULL_GL_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace null_gl_detail
+{
+	enum Call
+	{
+		CALL_ENABLE, CALL_DISABLE, CALL_DEPTH_FUNC, CALL_BLEND_FUNC, CALL_CLEAR_COLOR, CALL_CLEAR_DEPTH, CALL_VIEWPORT,
+		CALL_PIXEL_STORE, CALL_CLEAR, CALL_FINISH, CALL_GET_ERROR, CALL_GET_INTEGER, CALL_GET_STRING,
+		CALL_GEN_BUFFERS, CALL_DELETE_BUFFERS, CALL_BIND_BUFFER, CALL_BIND_BUFFER_BASE, CALL_BUFFER_DATA,
+		CALL_BUFFER_SUB_DATA, CALL_MAP_BUFFER_RANGE, CALL_UNMAP_BUFFER,
+		CALL_GEN_TEXTURES, CALL_DELETE_TEXTURES, CALL_ACTIVE_TEXTURE, CALL_BIND_TEXTURE, CALL_TEX_IMAGE_2D,
+		CALL_TEX_PARAMETER, CALL_GENERATE_MIPMAP,
+		CALL_GEN_VERTEX_ARRAYS, CALL_DELETE_VERTEX_ARRAYS, CALL_BIND_VERTEX_ARRAY, CALL_VERTEX_ATTRIB_POINTER,
+		CALL_VERTEX_ATTRIB_I_POINTER, CALL_ENABLE_VERTEX_ATTRIB_ARRAY, CALL_VERTEX_ATTRIB_DIVISOR,
+		CALL_GEN_FRAMEBUFFERS, CALL_DELETE_FRAMEBUFFERS, CALL_BIND_FRAMEBUFFER, CALL_FRAMEBUFFER_TEXTURE_2D,
+		CALL_CHECK_FRAMEBUFFER_STATUS, CALL_BLIT_FRAMEBUFFER,
+		CALL_CREATE_SHADER, CALL_SHADER_SOURCE, CALL_COMPILE_SHADER, CALL_GET_SHADER, CALL_GET_SHADER_INFO_LOG,
+		CALL_DELETE_SHADER, CALL_CREATE_PROGRAM, CALL_ATTACH_SHADER, CALL_LINK_PROGRAM, CALL_GET_PROGRAM,
+		CALL_GET_PROGRAM_INFO_LOG, CALL_DELETE_PROGRAM, CALL_USE_PROGRAM, CALL_GET_UNIFORM_LOCATION,
+		CALL_UNIFORM_1I, CALL_UNIFORM_1UI, CALL_UNIFORM_1F, CALL_UNIFORM_2F, CALL_UNIFORM_4FV, CALL_UNIFORM_MATRIX_4FV,
+		CALL_DRAW_ARRAYS, CALL_DRAW_ARRAYS_INSTANCED, CALL_DRAW_ELEMENTS, CALL_DRAW_ELEMENTS_INSTANCED,
+		CALL_GEN_QUERIES, CALL_DELETE_QUERIES, CALL_BEGIN_QUERY, CALL_END_QUERY, CALL_QUERY_COUNTER, CALL_GET_QUERY_OBJECT,
+		CALL_FENCE_SYNC, CALL_CLIENT_WAIT_SYNC, CALL_DELETE_SYNC,
+		CALL_COUNT
+	};
+
+	inline const char* const CALL_NAMES[] = {
+		"glEnable", "glDisable", "glDepthFunc", "glBlendFunc", "glClearColor", "glClearDepth", "glViewport",
+		"glPixelStorei", "glClear", "glFinish", "glGetError", "glGetIntegerv", "glGetStringi",
+		"glGenBuffers", "glDeleteBuffers", "glBindBuffer", "glBindBufferBase", "glBufferData",
+		"glBufferSubData", "glMapBufferRange", "glUnmapBuffer",
+		"glGenTextures", "glDeleteTextures", "glActiveTexture", "glBindTexture", "glTexImage2D",
+		"glTexParameteri", "glGenerateMipmap",
+		"glGenVertexArrays", "glDeleteVertexArrays", "glBindVertexArray", "glVertexAttribPointer",
+		"glVertexAttribIPointer", "glEnableVertexAttribArray", "glVertexAttribDivisor",
+		"glGenFramebuffers", "glDeleteFramebuffers", "glBindFramebuffer", "glFramebufferTexture2D",
+		"glCheckFramebufferStatus", "glBlitFramebuffer",
+		"glCreateShader", "glShaderSource", "glCompileShader", "glGetShaderiv", "glGetShaderInfoLog",
+		"glDeleteShader", "glCreateProgram", "glAttachShader", "glLinkProgram", "glGetProgramiv",
+		"glGetProgramInfoLog", "glDeleteProgram", "glUseProgram", "glGetUniformLocation",
+		"glUniform1i", "glUniform1ui", "glUniform1f", "glUniform2f", "glUniform4fv", "glUniformMatrix4fv",
+		"glDrawArrays", "glDrawArraysInstanced", "glDrawElements", "glDrawElementsInstanced",
+		"glGenQueries", "glDeleteQueries", "glBeginQuery", "glEndQuery", "glQueryCounter", "glGetQueryObjectui64v",
+		"glFenceSync", "glClientWaitSync", "glDeleteSync"
+	};
+	static_assert(sizeof(CALL_NAMES) / sizeof(CALL_NAMES[0]) == CALL_COUNT, "a call without a name");
+
+	const unsigned int TEXTURE_UNITS = 32;
+	const unsigned int VERTEX_ATTRIBUTES = 16;
+
+	struct Buffer
+	{
+		std::vector<unsigned char> storage; // only to hand out mappings, nothing reads it
+		bool mapped = false;
+	};
+
+	struct Texture
+	{
+		GLenum target = 0; // set by the first bind
+		GLsizei width = 0;
+		GLsizei height = 0;
+	};
+
+	struct VertexArray
+	{
+		GLuint elementBuffer = 0;
+		uint32_t enabledAttributes = 0;
+	};
+
+	struct ShaderObject
+	{
+		GLenum type;
+		bool hasSource;
+		bool compiled;
+	};
+
+	struct ProgramObject
+	{
+		std::vector<GLuint> shaders;
+		bool linked = false;
+		std::map<std::string, GLint, std::less<>> locations; // handed out on first query
+		std::vector<std::vector<uint32_t>> values; // per location, to spot redundant uploads
+	};
+
+	/* The state the renderer has bound, shadowed to catch calls that change nothing */
+	struct BoundState
+	{
+		GLuint program = 0;
+		GLuint vertexArray = 0;
+		unsigned int activeUnit = 0;
+		GLuint textures[TEXTURE_UNITS] = {}; // 2D
+		std::map<GLenum, GLuint> buffers; // the element array buffer lives in the vertex array
+		GLuint drawFramebuffer = 0;
+		GLuint readFramebuffer = 0;
+		std::map<GLenum, bool> enabled;
+		GLenum depthFunc = GL_LESS;
+		GLenum blendFunc[2] = { GL_ONE, GL_ZERO };
+		GLfloat clearColor[4] = {};
+		GLdouble clearDepth = 1.0;
+		GLint viewport[4] = {};
+		GLint unpackAlignment = 4;
+		std::map<GLenum, GLuint> activeQueries;
+	};
+
+	inline bool installed = false;
+	inline GLuint nextName = 1; // shared by every kind, a name of the wrong kind is caught too
+	inline std::map<GLuint, Buffer> buffers;
+	inline std::map<GLuint, Texture> textures;
+	inline std::map<GLuint, VertexArray> vertexArrays;
+	inline std::map<GLuint, unsigned int> framebuffers; // attachment count
+	inline std::map<GLuint, ShaderObject> shaders;
+	inline std::map<GLuint, ProgramObject> programs;
+	inline std::set<GLuint> queries;
+	inline std::vector<GLsync> syncs; // a handful live at once, and fencing every frame must not allocate
+	inline BoundState bound;
+
+	inline GLenum error = GL_NO_ERROR;
+	inline uint64_t calls[CALL_COUNT] = {};
+	inline uint64_t redundantCalls[CALL_COUNT] = {};
+	inline std::map<std::string, uint64_t> errors; // by call, error and reason
+
+	inline const char* errorName(GLenum code)
+	{
+		switch (code)
+		{
+		case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+		case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+		case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+		default: return "unknown error";
+		}
+	}
+
+	inline void fail(Call call, GLenum code, const char* reason)
+	{
+		// like GL, the first error is kept until glGetError
+		if (error == GL_NO_ERROR)
+			error = code;
+		errors[std::string(CALL_NAMES[call]) + " " + errorName(code) + ": " + reason]++;
+	}
+
+	// sets shadowed state, true when it already had the value
+	template <typename T>
+	bool change(Call call, T& state, T value)
+	{
+		if (state == value)
+		{
+			redundantCalls[call]++;
+			return true;
+		}
+		state = value;
+		return false;
+	}
+
+	template <typename T>
+	bool exists(const std::map<GLuint, T>& objects, GLuint name)
+	{
+		return name == 0 || objects.find(name) != objects.end();
+	}
+
+	template <typename Create>
+	void generate(GLsizei count, GLuint* names, Call call, Create create)
+	{
+		if (count < 0)
+		{
+			fail(call, GL_INVALID_VALUE, "negative count");
+			return;
+		}
+		for (GLsizei i = 0; i < count; i++)
+		{
+			names[i] = nextName++;
+			create(names[i]);
+		}
+	}
+
+	inline bool isBufferTarget(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: case GL_ELEMENT_ARRAY_BUFFER: case GL_COPY_READ_BUFFER: case GL_COPY_WRITE_BUFFER:
+		case GL_DRAW_INDIRECT_BUFFER: case GL_DISPATCH_INDIRECT_BUFFER: case GL_PIXEL_PACK_BUFFER: case GL_PIXEL_UNPACK_BUFFER:
+		case GL_UNIFORM_BUFFER: case GL_SHADER_STORAGE_BUFFER: case GL_TEXTURE_BUFFER: case GL_TRANSFORM_FEEDBACK_BUFFER:
+		case GL_ATOMIC_COUNTER_BUFFER: case GL_QUERY_BUFFER:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	inline GLuint& getBufferBinding(GLenum target)
+	{
+		if (target == GL_ELEMENT_ARRAY_BUFFER)
+			return vertexArrays[bound.vertexArray].elementBuffer;
+		return bound.buffers[target];
+	}
+
+	inline Buffer* getBoundBuffer(Call call, GLenum target)
+	{
+		if (!isBufferTarget(target))
+		{
+			fail(call, GL_INVALID_ENUM, "not a buffer target");
+			return NULL;
+		}
+		GLuint name = getBufferBinding(target);
+		if (name == 0)
+		{
+			fail(call, GL_INVALID_OPERATION, "no buffer bound to the target");
+			return NULL;
+		}
+		return &buffers[name];
+	}
+
+	inline ProgramObject* getUniformProgram(Call call, GLint location, GLsizei count)
+	{
+		if (bound.program == 0)
+		{
+			fail(call, GL_INVALID_OPERATION, "no program in use");
+			return NULL;
+		}
+		if (count < 0)
+		{
+			fail(call, GL_INVALID_VALUE, "negative count");
+			return NULL;
+		}
+		if (location == -1) // quietly ignored, the uniform was optimized out
+			return NULL;
+		ProgramObject& program = programs[bound.program];
+		if (location < 0 || (size_t)location >= program.locations.size())
+		{
+			fail(call, GL_INVALID_OPERATION, "location is not one of the program in use");
+			return NULL;
+		}
+		return &program;
+	}
+
+	inline void setUniform(Call call, GLint location, const void* data, size_t size, GLsizei count = 1)
+	{
+		ProgramObject* program = getUniformProgram(call, location, count);
+		if (program == NULL)
+			return;
+		if (program->values.size() <= (size_t)location)
+			program->values.resize(program->locations.size());
+		std::vector<uint32_t>& value = program->values[location];
+		size_t words = size / sizeof(uint32_t);
+		if (value.size() == words && std::memcmp(value.data(), data, size) == 0)
+		{
+			redundantCalls[call]++;
+			return;
+		}
+		value.assign((const uint32_t*)data, (const uint32_t*)data + words);
+	}
+
+	inline bool checkDraw(Call call, GLenum mode, GLsizei count, GLsizei instanceCount, bool indexed)
+	{
+		if (mode > GL_TRIANGLE_FAN && (mode < GL_LINES_ADJACENCY || mode > GL_PATCHES))
+			fail(call, GL_INVALID_ENUM, "not a primitive mode");
+		else if (count < 0 || instanceCount < 0)
+			fail(call, GL_INVALID_VALUE, "negative count");
+		else if (bound.program == 0)
+			fail(call, GL_INVALID_OPERATION, "no program in use");
+		else if (bound.vertexArray == 0)
+			fail(call, GL_INVALID_OPERATION, "no vertex array bound");
+		else if (indexed && vertexArrays[bound.vertexArray].elementBuffer == 0)
+			fail(call, GL_INVALID_OPERATION, "no element buffer in the vertex array");
+		else
+			return true;
+		return false;
+	}
+
+	inline bool checkAttribute(Call call, GLuint index, GLint size, GLsizei stride, const void* pointer)
+	{
+		if (index >= VERTEX_ATTRIBUTES || ((size < 1 || size > 4) && size != GL_BGRA) || stride < 0)
+			fail(call, GL_INVALID_VALUE, "attribute index, size or stride out of range");
+		else if (bound.vertexArray == 0)
+			fail(call, GL_INVALID_OPERATION, "no vertex array bound");
+		else if (bound.buffers[GL_ARRAY_BUFFER] == 0 && pointer != NULL)
+			fail(call, GL_INVALID_OPERATION, "offset without an array buffer");
+		else
+			return true;
+		return false;
+	}
+
+	// state
+
+	inline void APIENTRY nullEnable(GLenum capability)
+	{
+		calls[CALL_ENABLE]++;
+		change(CALL_ENABLE, bound.enabled[capability], true);
+	}
+
+	inline void APIENTRY nullDisable(GLenum capability)
+	{
+		calls[CALL_DISABLE]++;
+		change(CALL_DISABLE, bound.enabled[capability], false);
+	}
+
+	inline void APIENTRY nullDepthFunc(GLenum function)
+	{
+		calls[CALL_DEPTH_FUNC]++;
+		if (function < GL_NEVER || function > GL_ALWAYS)
+			fail(CALL_DEPTH_FUNC, GL_INVALID_ENUM, "not a comparison");
+		else
+			change(CALL_DEPTH_FUNC, bound.depthFunc, function);
+	}
+
+	inline void APIENTRY nullBlendFunc(GLenum source, GLenum destination)
+	{
+		calls[CALL_BLEND_FUNC]++;
+		if (bound.blendFunc[0] == source && bound.blendFunc[1] == destination)
+			redundantCalls[CALL_BLEND_FUNC]++;
+		bound.blendFunc[0] = source;
+		bound.blendFunc[1] = destination;
+	}
+
+	inline void APIENTRY nullClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		calls[CALL_CLEAR_COLOR]++;
+		GLfloat color[4] = { red, green, blue, alpha };
+		if (std::equal(color, color + 4, bound.clearColor))
+			redundantCalls[CALL_CLEAR_COLOR]++;
+		std::copy(color, color + 4, bound.clearColor);
+	}
+
+	inline void APIENTRY nullClearDepth(GLdouble depth)
+	{
+		calls[CALL_CLEAR_DEPTH]++;
+		change(CALL_CLEAR_DEPTH, bound.clearDepth, depth);
+	}
+
+	inline void APIENTRY nullViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		calls[CALL_VIEWPORT]++;
+		if (width < 0 || height < 0)
+		{
+			fail(CALL_VIEWPORT, GL_INVALID_VALUE, "negative size");
+			return;
+		}
+		GLint viewport[4] = { x, y, width, height };
+		if (std::equal(viewport, viewport + 4, bound.viewport))
+			redundantCalls[CALL_VIEWPORT]++;
+		std::copy(viewport, viewport + 4, bound.viewport);
+	}
+
+	inline void APIENTRY nullPixelStorei(GLenum name, GLint value)
+	{
+		calls[CALL_PIXEL_STORE]++;
+		if (name == GL_UNPACK_ALIGNMENT && value != 1 && value != 2 && value != 4 && value != 8)
+			fail(CALL_PIXEL_STORE, GL_INVALID_VALUE, "alignment not 1, 2, 4 or 8");
+		else if (name == GL_UNPACK_ALIGNMENT)
+			change(CALL_PIXEL_STORE, bound.unpackAlignment, value);
+	}
+
+	inline void APIENTRY nullClear(GLbitfield mask)
+	{
+		calls[CALL_CLEAR]++;
+		if ((mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) != 0)
+			fail(CALL_CLEAR, GL_INVALID_VALUE, "unknown bits in the mask");
+	}
+
+	inline void APIENTRY nullFinish()
+	{
+		calls[CALL_FINISH]++;
+	}
+
+	inline GLenum APIENTRY nullGetError()
+	{
+		calls[CALL_GET_ERROR]++;
+		GLenum code = error;
+		error = GL_NO_ERROR;
+		return code;
+	}
+
+	inline void APIENTRY nullGetIntegerv(GLenum name, GLint* data)
+	{
+		calls[CALL_GET_INTEGER]++;
+		switch (name)
+		{
+		case GL_MAJOR_VERSION: data[0] = 3; break;
+		case GL_MINOR_VERSION: data[0] = 3; break;
+		case GL_CURRENT_PROGRAM: data[0] = (GLint)bound.program; break;
+		case GL_VERTEX_ARRAY_BINDING: data[0] = (GLint)bound.vertexArray; break;
+		case GL_ACTIVE_TEXTURE: data[0] = (GLint)(GL_TEXTURE0 + bound.activeUnit); break;
+		case GL_TEXTURE_BINDING_2D: data[0] = (GLint)bound.textures[bound.activeUnit]; break;
+		case GL_ARRAY_BUFFER_BINDING: data[0] = (GLint)bound.buffers[GL_ARRAY_BUFFER]; break;
+		case GL_ELEMENT_ARRAY_BUFFER_BINDING: data[0] = (GLint)vertexArrays[bound.vertexArray].elementBuffer; break;
+		case GL_DRAW_FRAMEBUFFER_BINDING: data[0] = (GLint)bound.drawFramebuffer; break;
+		case GL_READ_FRAMEBUFFER_BINDING: data[0] = (GLint)bound.readFramebuffer; break;
+		case GL_DEPTH_FUNC: data[0] = (GLint)bound.depthFunc; break;
+		case GL_UNPACK_ALIGNMENT: data[0] = bound.unpackAlignment; break;
+		case GL_VIEWPORT: std::copy(bound.viewport, bound.viewport + 4, data); break;
+		case GL_MAX_TEXTURE_IMAGE_UNITS: data[0] = 16; break;
+		case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: data[0] = (GLint)TEXTURE_UNITS; break;
+		case GL_MAX_VERTEX_ATTRIBS: data[0] = (GLint)VERTEX_ATTRIBUTES; break;
+		default: data[0] = 0; break; // no extensions, no context flags, no limits worth modelling
+		}
+	}
+
+	inline const GLubyte* APIENTRY nullGetStringi(GLenum name, GLuint index)
+	{
+		calls[CALL_GET_STRING]++;
+		fail(CALL_GET_STRING, name == GL_EXTENSIONS ? GL_INVALID_VALUE : GL_INVALID_ENUM, "there are no extensions");
+		return NULL;
+	}
+
+	// buffers
+
+	inline void APIENTRY nullGenBuffers(GLsizei count, GLuint* names)
+	{
+		calls[CALL_GEN_BUFFERS]++;
+		generate(count, names, CALL_GEN_BUFFERS, [](GLuint name) { buffers[name]; });
+	}
+
+	inline void APIENTRY nullDeleteBuffers(GLsizei count, const GLuint* names)
+	{
+		calls[CALL_DELETE_BUFFERS]++;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			// deleting a bound buffer unbinds it
+			for (auto& binding : bound.buffers)
+				if (binding.second == names[i])
+					binding.second = 0;
+			for (auto& vertexArray : vertexArrays)
+				if (vertexArray.second.elementBuffer == names[i])
+					vertexArray.second.elementBuffer = 0;
+			buffers.erase(names[i]);
+		}
+	}
+
+	inline void APIENTRY nullBindBuffer(GLenum target, GLuint buffer)
+	{
+		calls[CALL_BIND_BUFFER]++;
+		if (!isBufferTarget(target))
+			fail(CALL_BIND_BUFFER, GL_INVALID_ENUM, "not a buffer target");
+		else if (!exists(buffers, buffer))
+			fail(CALL_BIND_BUFFER, GL_INVALID_OPERATION, "name is not a generated buffer");
+		else
+			change(CALL_BIND_BUFFER, getBufferBinding(target), buffer);
+	}
+
+	inline void APIENTRY nullBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		calls[CALL_BIND_BUFFER_BASE]++;
+		if (target != GL_UNIFORM_BUFFER && target != GL_SHADER_STORAGE_BUFFER && target != GL_TRANSFORM_FEEDBACK_BUFFER
+			&& target != GL_ATOMIC_COUNTER_BUFFER)
+			fail(CALL_BIND_BUFFER_BASE, GL_INVALID_ENUM, "not an indexed buffer target");
+		else if (!exists(buffers, buffer))
+			fail(CALL_BIND_BUFFER_BASE, GL_INVALID_OPERATION, "name is not a generated buffer");
+		else
+			bound.buffers[target] = buffer; // the generic binding, indices are not tracked
+	}
+
+	inline void APIENTRY nullBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		calls[CALL_BUFFER_DATA]++;
+		Buffer* buffer = getBoundBuffer(CALL_BUFFER_DATA, target);
+		if (buffer == NULL)
+			return;
+		if (size < 0)
+		{
+			fail(CALL_BUFFER_DATA, GL_INVALID_VALUE, "negative size");
+			return;
+		}
+		buffer->storage.resize((size_t)size);
+		buffer->mapped = false;
+	}
+
+	inline void APIENTRY nullBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		calls[CALL_BUFFER_SUB_DATA]++;
+		Buffer* buffer = getBoundBuffer(CALL_BUFFER_SUB_DATA, target);
+		if (buffer == NULL)
+			return;
+		if (offset < 0 || size < 0 || (size_t)(offset + size) > buffer->storage.size())
+			fail(CALL_BUFFER_SUB_DATA, GL_INVALID_VALUE, "range outside the buffer");
+		else if (buffer->mapped)
+			fail(CALL_BUFFER_SUB_DATA, GL_INVALID_OPERATION, "buffer is mapped");
+	}
+
+	inline void* APIENTRY nullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		calls[CALL_MAP_BUFFER_RANGE]++;
+		Buffer* buffer = getBoundBuffer(CALL_MAP_BUFFER_RANGE, target);
+		if (buffer == NULL)
+			return NULL;
+		if (offset < 0 || length <= 0 || (size_t)(offset + length) > buffer->storage.size())
+			fail(CALL_MAP_BUFFER_RANGE, GL_INVALID_VALUE, "range outside the buffer");
+		else if (buffer->mapped)
+			fail(CALL_MAP_BUFFER_RANGE, GL_INVALID_OPERATION, "buffer is already mapped");
+		else if ((access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT)) == 0)
+			fail(CALL_MAP_BUFFER_RANGE, GL_INVALID_OPERATION, "neither read nor write access");
+		else
+		{
+			buffer->mapped = true;
+			return buffer->storage.data() + offset;
+		}
+		return NULL;
+	}
+
+	inline GLboolean APIENTRY nullUnmapBuffer(GLenum target)
+	{
+		calls[CALL_UNMAP_BUFFER]++;
+		Buffer* buffer = getBoundBuffer(CALL_UNMAP_BUFFER, target);
+		if (buffer == NULL)
+			return GL_FALSE;
+		if (!buffer->mapped)
+		{
+			fail(CALL_UNMAP_BUFFER, GL_INVALID_OPERATION, "buffer is not mapped");
+			return GL_FALSE;
+		}
+		buffer->mapped = false;
+		return GL_TRUE;
+	}
+
+	// textures
+
+	inline void APIENTRY nullGenTextures(GLsizei count, GLuint* names)
+	{
+		calls[CALL_GEN_TEXTURES]++;
+		generate(count, names, CALL_GEN_TEXTURES, [](GLuint name) { textures[name]; });
+	}
+
+	inline void APIENTRY nullDeleteTextures(GLsizei count, const GLuint* names)
+	{
+		calls[CALL_DELETE_TEXTURES]++;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			for (GLuint& texture : bound.textures)
+				if (texture == names[i])
+					texture = 0;
+			textures.erase(names[i]);
+		}
+	}
+
+	inline void APIENTRY nullActiveTexture(GLenum unit)
+	{
+		calls[CALL_ACTIVE_TEXTURE]++;
+		if (unit < GL_TEXTURE0 || unit >= GL_TEXTURE0 + TEXTURE_UNITS)
+			fail(CALL_ACTIVE_TEXTURE, GL_INVALID_ENUM, "unit out of range");
+		else
+			change(CALL_ACTIVE_TEXTURE, bound.activeUnit, unit - GL_TEXTURE0);
+	}
+
+	inline void APIENTRY nullBindTexture(GLenum target, GLuint texture)
+	{
+		calls[CALL_BIND_TEXTURE]++;
+		if (!exists(textures, texture))
+		{
+			fail(CALL_BIND_TEXTURE, GL_INVALID_OPERATION, "name is not a generated texture");
+			return;
+		}
+		if (texture != 0)
+		{
+			Texture& object = textures[texture];
+			if (object.target != 0 && object.target != target)
+			{
+				fail(CALL_BIND_TEXTURE, GL_INVALID_OPERATION, "texture was created for another target");
+				return;
+			}
+			object.target = target;
+		}
+		if (target == GL_TEXTURE_2D)
+			change(CALL_BIND_TEXTURE, bound.textures[bound.activeUnit], texture);
+	}
+
+	inline void APIENTRY nullTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+		GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		calls[CALL_TEX_IMAGE_2D]++;
+		if (level < 0 || width < 0 || height < 0 || border != 0)
+		{
+			fail(CALL_TEX_IMAGE_2D, GL_INVALID_VALUE, "negative level or size, or a border");
+			return;
+		}
+		GLuint texture = bound.textures[bound.activeUnit];
+		if (target == GL_TEXTURE_2D && level == 0 && texture != 0)
+		{
+			textures[texture].width = width;
+			textures[texture].height = height;
+		}
+	}
+
+	inline void APIENTRY nullTexParameteri(GLenum target, GLenum name, GLint value)
+	{
+		calls[CALL_TEX_PARAMETER]++;
+	}
+
+	inline void APIENTRY nullGenerateMipmap(GLenum target)
+	{
+		calls[CALL_GENERATE_MIPMAP]++;
+		GLuint texture = bound.textures[bound.activeUnit];
+		if (target == GL_TEXTURE_2D && texture != 0 && textures[texture].width == 0)
+			fail(CALL_GENERATE_MIPMAP, GL_INVALID_OPERATION, "texture has no level 0");
+	}
+
+	// vertex arrays
+
+	inline void APIENTRY nullGenVertexArrays(GLsizei count, GLuint* names)
+	{
+		calls[CALL_GEN_VERTEX_ARRAYS]++;
+		generate(count, names, CALL_GEN_VERTEX_ARRAYS, [](GLuint name) { vertexArrays[name]; });
+	}
+
+	inline void APIENTRY nullDeleteVertexArrays(GLsizei count, const GLuint* names)
+	{
+		calls[CALL_DELETE_VERTEX_ARRAYS]++;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if (names[i] == 0)
+				continue;
+			if (bound.vertexArray == names[i])
+				bound.vertexArray = 0;
+			vertexArrays.erase(names[i]);
+		}
+	}
+
+	inline void APIENTRY nullBindVertexArray(GLuint array)
+	{
+		calls[CALL_BIND_VERTEX_ARRAY]++;
+		if (!exists(vertexArrays, array))
+			fail(CALL_BIND_VERTEX_ARRAY, GL_INVALID_OPERATION, "name is not a generated vertex array");
+		else
+			change(CALL_BIND_VERTEX_ARRAY, bound.vertexArray, array);
+	}
+
+	inline void APIENTRY nullVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		calls[CALL_VERTEX_ATTRIB_POINTER]++;
+		checkAttribute(CALL_VERTEX_ATTRIB_POINTER, index, size, stride, pointer);
+	}
+
+	inline void APIENTRY nullVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer)
+	{
+		calls[CALL_VERTEX_ATTRIB_I_POINTER]++;
+		if (size == GL_BGRA)
+			fail(CALL_VERTEX_ATTRIB_I_POINTER, GL_INVALID_VALUE, "integer attributes cannot be BGRA");
+		else
+			checkAttribute(CALL_VERTEX_ATTRIB_I_POINTER, index, size, stride, pointer);
+	}
+
+	inline void APIENTRY nullEnableVertexAttribArray(GLuint index)
+	{
+		calls[CALL_ENABLE_VERTEX_ATTRIB_ARRAY]++;
+		if (index >= VERTEX_ATTRIBUTES)
+			fail(CALL_ENABLE_VERTEX_ATTRIB_ARRAY, GL_INVALID_VALUE, "attribute index out of range");
+		else if (bound.vertexArray == 0)
+			fail(CALL_ENABLE_VERTEX_ATTRIB_ARRAY, GL_INVALID_OPERATION, "no vertex array bound");
+		else
+		{
+			uint32_t& enabled = vertexArrays[bound.vertexArray].enabledAttributes;
+			change(CALL_ENABLE_VERTEX_ATTRIB_ARRAY, enabled, enabled | (1u << index));
+		}
+	}
+
+	inline void APIENTRY nullVertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		calls[CALL_VERTEX_ATTRIB_DIVISOR]++;
+		if (index >= VERTEX_ATTRIBUTES)
+			fail(CALL_VERTEX_ATTRIB_DIVISOR, GL_INVALID_VALUE, "attribute index out of range");
+		else if (bound.vertexArray == 0)
+			fail(CALL_VERTEX_ATTRIB_DIVISOR, GL_INVALID_OPERATION, "no vertex array bound");
+	}
+
+	// framebuffers
+
+	inline void APIENTRY nullGenFramebuffers(GLsizei count, GLuint* names)
+	{
+		calls[CALL_GEN_FRAMEBUFFERS]++;
+		generate(count, names, CALL_GEN_FRAMEBUFFERS, [](GLuint name) { framebuffers[name] = 0; });
+	}
+
+	inline void APIENTRY nullDeleteFramebuffers(GLsizei count, const GLuint* names)
+	{
+		calls[CALL_DELETE_FRAMEBUFFERS]++;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if (bound.drawFramebuffer == names[i])
+				bound.drawFramebuffer = 0;
+			if (bound.readFramebuffer == names[i])
+				bound.readFramebuffer = 0;
+			framebuffers.erase(names[i]);
+		}
+	}
+
+	inline void APIENTRY nullBindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		calls[CALL_BIND_FRAMEBUFFER]++;
+		if (target != GL_FRAMEBUFFER && target != GL_DRAW_FRAMEBUFFER && target != GL_READ_FRAMEBUFFER)
+			fail(CALL_BIND_FRAMEBUFFER, GL_INVALID_ENUM, "not a framebuffer target");
+		else if (!exists(framebuffers, framebuffer))
+			fail(CALL_BIND_FRAMEBUFFER, GL_INVALID_OPERATION, "name is not a generated framebuffer");
+		else if (target == GL_DRAW_FRAMEBUFFER)
+			change(CALL_BIND_FRAMEBUFFER, bound.drawFramebuffer, framebuffer);
+		else if (target == GL_READ_FRAMEBUFFER)
+			change(CALL_BIND_FRAMEBUFFER, bound.readFramebuffer, framebuffer);
+		else
+		{
+			if (bound.drawFramebuffer == framebuffer && bound.readFramebuffer == framebuffer)
+				redundantCalls[CALL_BIND_FRAMEBUFFER]++;
+			bound.drawFramebuffer = framebuffer;
+			bound.readFramebuffer = framebuffer;
+		}
+	}
+
+	inline void APIENTRY nullFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level)
+	{
+		calls[CALL_FRAMEBUFFER_TEXTURE_2D]++;
+		GLuint framebuffer = target == GL_READ_FRAMEBUFFER ? bound.readFramebuffer : bound.drawFramebuffer;
+		if (framebuffer == 0)
+			fail(CALL_FRAMEBUFFER_TEXTURE_2D, GL_INVALID_OPERATION, "the default framebuffer has no attachments");
+		else if (!exists(textures, texture))
+			fail(CALL_FRAMEBUFFER_TEXTURE_2D, GL_INVALID_OPERATION, "name is not a generated texture");
+		else if (texture != 0)
+			framebuffers[framebuffer]++;
+	}
+
+	inline GLenum APIENTRY nullCheckFramebufferStatus(GLenum target)
+	{
+		calls[CALL_CHECK_FRAMEBUFFER_STATUS]++;
+		GLuint framebuffer = target == GL_READ_FRAMEBUFFER ? bound.readFramebuffer : bound.drawFramebuffer;
+		if (framebuffer != 0 && framebuffers[framebuffer] == 0)
+			return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+		return GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	inline void APIENTRY nullBlitFramebuffer(GLint sourceX0, GLint sourceY0, GLint sourceX1, GLint sourceY1,
+		GLint destinationX0, GLint destinationY0, GLint destinationX1, GLint destinationY1, GLbitfield mask, GLenum filter)
+	{
+		calls[CALL_BLIT_FRAMEBUFFER]++;
+		if ((mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) != 0)
+			fail(CALL_BLIT_FRAMEBUFFER, GL_INVALID_VALUE, "unknown bits in the mask");
+		else if (filter == GL_LINEAR && (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) != 0)
+			fail(CALL_BLIT_FRAMEBUFFER, GL_INVALID_OPERATION, "depth and stencil blits must be GL_NEAREST");
+	}
+
+	// shaders and programs
+
+	inline GLuint APIENTRY nullCreateShader(GLenum type)
+	{
+		calls[CALL_CREATE_SHADER]++;
+		if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER && type != GL_GEOMETRY_SHADER && type != GL_COMPUTE_SHADER
+			&& type != GL_TESS_CONTROL_SHADER && type != GL_TESS_EVALUATION_SHADER)
+		{
+			fail(CALL_CREATE_SHADER, GL_INVALID_ENUM, "not a shader type");
+			return 0;
+		}
+		GLuint name = nextName++;
+		shaders[name] = { type, false, false };
+		return name;
+	}
+
+	inline void APIENTRY nullShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+	{
+		calls[CALL_SHADER_SOURCE]++;
+		if (shaders.find(shader) == shaders.end())
+			fail(CALL_SHADER_SOURCE, GL_INVALID_VALUE, "name is not a shader");
+		else if (count < 0)
+			fail(CALL_SHADER_SOURCE, GL_INVALID_VALUE, "negative count");
+		else
+			shaders[shader].hasSource = count > 0;
+	}
+
+	inline void APIENTRY nullCompileShader(GLuint shader)
+	{
+		calls[CALL_COMPILE_SHADER]++;
+		if (shaders.find(shader) == shaders.end())
+			fail(CALL_COMPILE_SHADER, GL_INVALID_VALUE, "name is not a shader");
+		else
+			shaders[shader].compiled = shaders[shader].hasSource; // any source compiles
+	}
+
+	inline void APIENTRY nullGetShaderiv(GLuint shader, GLenum name, GLint* value)
+	{
+		calls[CALL_GET_SHADER]++;
+		auto found = shaders.find(shader);
+		if (found == shaders.end())
+		{
+			fail(CALL_GET_SHADER, GL_INVALID_VALUE, "name is not a shader");
+			return;
+		}
+		if (name == GL_COMPILE_STATUS)
+			*value = found->second.compiled ? GL_TRUE : GL_FALSE;
+		else if (name == GL_SHADER_TYPE)
+			*value = (GLint)found->second.type;
+		else
+			*value = 0; // no info log, not deleted
+	}
+
+	inline void APIENTRY nullGetShaderInfoLog(GLuint shader, GLsizei bufferSize, GLsizei* length, GLchar* log)
+	{
+		calls[CALL_GET_SHADER_INFO_LOG]++;
+		if (length != NULL)
+			*length = 0;
+		if (bufferSize > 0)
+			log[0] = '\0';
+	}
+
+	inline void APIENTRY nullDeleteShader(GLuint shader)
+	{
+		calls[CALL_DELETE_SHADER]++;
+		if (shader != 0 && shaders.erase(shader) == 0)
+			fail(CALL_DELETE_SHADER, GL_INVALID_VALUE, "name is not a shader");
+	}
+
+	inline GLuint APIENTRY nullCreateProgram()
+	{
+		calls[CALL_CREATE_PROGRAM]++;
+		GLuint name = nextName++;
+		programs[name];
+		return name;
+	}
+
+	inline void APIENTRY nullAttachShader(GLuint program, GLuint shader)
+	{
+		calls[CALL_ATTACH_SHADER]++;
+		if (programs.find(program) == programs.end() || shaders.find(shader) == shaders.end())
+			fail(CALL_ATTACH_SHADER, GL_INVALID_VALUE, "name is not a program or a shader");
+		else
+			programs[program].shaders.push_back(shader);
+	}
+
+	inline void APIENTRY nullLinkProgram(GLuint program)
+	{
+		calls[CALL_LINK_PROGRAM]++;
+		auto found = programs.find(program);
+		if (found == programs.end())
+		{
+			fail(CALL_LINK_PROGRAM, GL_INVALID_VALUE, "name is not a program");
+			return;
+		}
+		ProgramObject& object = found->second;
+		object.linked = !object.shaders.empty();
+		for (GLuint shader : object.shaders)
+			object.linked = object.linked && shaders.find(shader) != shaders.end() && shaders[shader].compiled;
+	}
+
+	inline void APIENTRY nullGetProgramiv(GLuint program, GLenum name, GLint* value)
+	{
+		calls[CALL_GET_PROGRAM]++;
+		auto found = programs.find(program);
+		if (found == programs.end())
+		{
+			fail(CALL_GET_PROGRAM, GL_INVALID_VALUE, "name is not a program");
+			return;
+		}
+		if (name == GL_LINK_STATUS)
+			*value = found->second.linked ? GL_TRUE : GL_FALSE;
+		else if (name == GL_ATTACHED_SHADERS)
+			*value = (GLint)found->second.shaders.size();
+		else if (name == GL_ACTIVE_UNIFORMS)
+			*value = (GLint)found->second.locations.size();
+		else
+			*value = 0;
+	}
+
+	inline void APIENTRY nullGetProgramInfoLog(GLuint program, GLsizei bufferSize, GLsizei* length, GLchar* log)
+	{
+		calls[CALL_GET_PROGRAM_INFO_LOG]++;
+		if (length != NULL)
+			*length = 0;
+		if (bufferSize > 0)
+			log[0] = '\0';
+	}
+
+	inline void APIENTRY nullDeleteProgram(GLuint program)
+	{
+		calls[CALL_DELETE_PROGRAM]++;
+		if (program == 0)
+			return;
+		if (programs.find(program) == programs.end())
+			fail(CALL_DELETE_PROGRAM, GL_INVALID_VALUE, "name is not a program");
+		else if (bound.program != program) // the program in use lives on until replaced
+			programs.erase(program);
+	}
+
+	inline void APIENTRY nullUseProgram(GLuint program)
+	{
+		calls[CALL_USE_PROGRAM]++;
+		if (!exists(programs, program))
+			fail(CALL_USE_PROGRAM, GL_INVALID_VALUE, "name is not a program");
+		else if (program != 0 && !programs[program].linked)
+			fail(CALL_USE_PROGRAM, GL_INVALID_OPERATION, "program is not linked");
+		else
+			change(CALL_USE_PROGRAM, bound.program, program);
+	}
+
+	inline GLint APIENTRY nullGetUniformLocation(GLuint program, const GLchar* name)
+	{
+		calls[CALL_GET_UNIFORM_LOCATION]++;
+		auto found = programs.find(program);
+		if (found == programs.end())
+		{
+			fail(CALL_GET_UNIFORM_LOCATION, GL_INVALID_VALUE, "name is not a program");
+			return -1;
+		}
+		if (!found->second.linked)
+		{
+			fail(CALL_GET_UNIFORM_LOCATION, GL_INVALID_OPERATION, "program is not linked");
+			return -1;
+		}
+		if (std::strncmp(name, "gl_", 3) == 0)
+			return -1;
+		// without a compiler every name is an active uniform
+		std::map<std::string, GLint, std::less<>>& locations = found->second.locations;
+		auto location = locations.find(name);
+		if (location != locations.end())
+			return location->second;
+		GLint next = (GLint)locations.size();
+		locations.emplace(name, next);
+		return next;
+	}
+
+	inline void APIENTRY nullUniform1i(GLint location, GLint value)
+	{
+		calls[CALL_UNIFORM_1I]++;
+		setUniform(CALL_UNIFORM_1I, location, &value, sizeof(value));
+	}
+
+	inline void APIENTRY nullUniform1ui(GLint location, GLuint value)
+	{
+		calls[CALL_UNIFORM_1UI]++;
+		setUniform(CALL_UNIFORM_1UI, location, &value, sizeof(value));
+	}
+
+	inline void APIENTRY nullUniform1f(GLint location, GLfloat value)
+	{
+		calls[CALL_UNIFORM_1F]++;
+		setUniform(CALL_UNIFORM_1F, location, &value, sizeof(value));
+	}
+
+	inline void APIENTRY nullUniform2f(GLint location, GLfloat x, GLfloat y)
+	{
+		calls[CALL_UNIFORM_2F]++;
+		GLfloat value[2] = { x, y };
+		setUniform(CALL_UNIFORM_2F, location, value, sizeof(value));
+	}
+
+	inline void APIENTRY nullUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		calls[CALL_UNIFORM_4FV]++;
+		setUniform(CALL_UNIFORM_4FV, location, value, std::max(count, 0) * 4 * sizeof(GLfloat), count);
+	}
+
+	inline void APIENTRY nullUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		calls[CALL_UNIFORM_MATRIX_4FV]++;
+		setUniform(CALL_UNIFORM_MATRIX_4FV, location, value, std::max(count, 0) * 16 * sizeof(GLfloat), count);
+	}
+
+	// draws
+
+	inline void APIENTRY nullDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		calls[CALL_DRAW_ARRAYS]++;
+		if (first < 0)
+			fail(CALL_DRAW_ARRAYS, GL_INVALID_VALUE, "negative first vertex");
+		else
+			checkDraw(CALL_DRAW_ARRAYS, mode, count, 1, false);
+	}
+
+	inline void APIENTRY nullDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		calls[CALL_DRAW_ARRAYS_INSTANCED]++;
+		if (first < 0)
+			fail(CALL_DRAW_ARRAYS_INSTANCED, GL_INVALID_VALUE, "negative first vertex");
+		else
+			checkDraw(CALL_DRAW_ARRAYS_INSTANCED, mode, count, instanceCount, false);
+	}
+
+	inline void APIENTRY nullDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		calls[CALL_DRAW_ELEMENTS]++;
+		checkDraw(CALL_DRAW_ELEMENTS, mode, count, 1, true);
+	}
+
+	inline void APIENTRY nullDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+	{
+		calls[CALL_DRAW_ELEMENTS_INSTANCED]++;
+		checkDraw(CALL_DRAW_ELEMENTS_INSTANCED, mode, count, instanceCount, true);
+	}
+
+	// queries and fences, everything the GPU would report is done and took no time
+
+	inline void APIENTRY nullGenQueries(GLsizei count, GLuint* names)
+	{
+		calls[CALL_GEN_QUERIES]++;
+		generate(count, names, CALL_GEN_QUERIES, [](GLuint name) { queries.insert(name); });
+	}
+
+	inline void APIENTRY nullDeleteQueries(GLsizei count, const GLuint* names)
+	{
+		calls[CALL_DELETE_QUERIES]++;
+		for (GLsizei i = 0; i < count; i++)
+			queries.erase(names[i]);
+	}
+
+	inline void APIENTRY nullBeginQuery(GLenum target, GLuint query)
+	{
+		calls[CALL_BEGIN_QUERY]++;
+		if (queries.find(query) == queries.end())
+			fail(CALL_BEGIN_QUERY, GL_INVALID_OPERATION, "name is not a generated query");
+		else if (bound.activeQueries[target] != 0)
+			fail(CALL_BEGIN_QUERY, GL_INVALID_OPERATION, "a query of the target is already active");
+		else
+			bound.activeQueries[target] = query;
+	}
+
+	inline void APIENTRY nullEndQuery(GLenum target)
+	{
+		calls[CALL_END_QUERY]++;
+		if (bound.activeQueries[target] == 0)
+			fail(CALL_END_QUERY, GL_INVALID_OPERATION, "no query of the target is active");
+		bound.activeQueries[target] = 0;
+	}
+
+	inline void APIENTRY nullQueryCounter(GLuint query, GLenum target)
+	{
+		calls[CALL_QUERY_COUNTER]++;
+		if (target != GL_TIMESTAMP)
+			fail(CALL_QUERY_COUNTER, GL_INVALID_ENUM, "target is not GL_TIMESTAMP");
+		else if (queries.find(query) == queries.end())
+			fail(CALL_QUERY_COUNTER, GL_INVALID_OPERATION, "name is not a generated query");
+	}
+
+	inline void APIENTRY nullGetQueryObjectui64v(GLuint query, GLenum name, GLuint64* value)
+	{
+		calls[CALL_GET_QUERY_OBJECT]++;
+		if (queries.find(query) == queries.end())
+			fail(CALL_GET_QUERY_OBJECT, GL_INVALID_OPERATION, "name is not a generated query");
+		else
+			*value = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+	}
+
+	inline GLsync APIENTRY nullFenceSync(GLenum condition, GLbitfield flags)
+	{
+		calls[CALL_FENCE_SYNC]++;
+		GLsync sync = (GLsync)(uintptr_t)nextName++;
+		syncs.push_back(sync);
+		return sync;
+	}
+
+	inline GLenum APIENTRY nullClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		calls[CALL_CLIENT_WAIT_SYNC]++;
+		if (std::find(syncs.begin(), syncs.end(), sync) == syncs.end())
+		{
+			fail(CALL_CLIENT_WAIT_SYNC, GL_INVALID_VALUE, "not a fence");
+			return GL_WAIT_FAILED;
+		}
+		return GL_ALREADY_SIGNALED;
+	}
+
+	inline void APIENTRY nullDeleteSync(GLsync sync)
+	{
+		calls[CALL_DELETE_SYNC]++;
+		if (sync == NULL)
+			return;
+		auto found = std::find(syncs.begin(), syncs.end(), sync);
+		if (found == syncs.end())
+		{
+			fail(CALL_DELETE_SYNC, GL_INVALID_VALUE, "not a fence");
+			return;
+		}
+		*found = syncs.back();
+		syncs.pop_back();
+	}
+}
+
+/* A GL implementation that runs nothing, installed into glad's function pointers instead of
+   loading a driver. It checks every call the way a core 3.3 context would, counts it and
+   shadows the bound state, so a call that sets what is already set is counted as redundant.
+   With the driver gone the renderer's CPU time is its own, and benchmarks run on machines
+   without any GL. Queries report zero GPU time and fences are always signaled. Nothing is
+   drawn and nothing can be read back, shaders always compile and every uniform name gets
+   a location. Errors are reported through glGetError like a real context and are all kept
+   for the report. One thread only, like a context */
+class NullGL
+{
+public:
+	// call instead of loading glad, before RenderStats::installHooks so the stats count on top
+	static void install()
+	{
+		using namespace null_gl_detail;
+		glad_glEnable = nullEnable;
+		glad_glDisable = nullDisable;
+		glad_glDepthFunc = nullDepthFunc;
+		glad_glBlendFunc = nullBlendFunc;
+		glad_glClearColor = nullClearColor;
+		glad_glClearDepth = nullClearDepth;
+		glad_glViewport = nullViewport;
+		glad_glPixelStorei = nullPixelStorei;
+		glad_glClear = nullClear;
+		glad_glFinish = nullFinish;
+		glad_glGetError = nullGetError;
+		glad_glGetIntegerv = nullGetIntegerv;
+		glad_glGetStringi = nullGetStringi;
+		glad_glGenBuffers = nullGenBuffers;
+		glad_glDeleteBuffers = nullDeleteBuffers;
+		glad_glBindBuffer = nullBindBuffer;
+		glad_glBindBufferBase = nullBindBufferBase;
+		glad_glBufferData = nullBufferData;
+		glad_glBufferSubData = nullBufferSubData;
+		glad_glMapBufferRange = nullMapBufferRange;
+		glad_glUnmapBuffer = nullUnmapBuffer;
+		glad_glGenTextures = nullGenTextures;
+		glad_glDeleteTextures = nullDeleteTextures;
+		glad_glActiveTexture = nullActiveTexture;
+		glad_glBindTexture = nullBindTexture;
+		glad_glTexImage2D = nullTexImage2D;
+		glad_glTexParameteri = nullTexParameteri;
+		glad_glGenerateMipmap = nullGenerateMipmap;
+		glad_glGenVertexArrays = nullGenVertexArrays;
+		glad_glDeleteVertexArrays = nullDeleteVertexArrays;
+		glad_glBindVertexArray = nullBindVertexArray;
+		glad_glVertexAttribPointer = nullVertexAttribPointer;
+		glad_glVertexAttribIPointer = nullVertexAttribIPointer;
+		glad_glEnableVertexAttribArray = nullEnableVertexAttribArray;
+		glad_glVertexAttribDivisor = nullVertexAttribDivisor;
+		glad_glGenFramebuffers = nullGenFramebuffers;
+		glad_glDeleteFramebuffers = nullDeleteFramebuffers;
+		glad_glBindFramebuffer = nullBindFramebuffer;
+		glad_glFramebufferTexture2D = nullFramebufferTexture2D;
+		glad_glCheckFramebufferStatus = nullCheckFramebufferStatus;
+		glad_glBlitFramebuffer = nullBlitFramebuffer;
+		glad_glCreateShader = nullCreateShader;
+		glad_glShaderSource = nullShaderSource;
+		glad_glCompileShader = nullCompileShader;
+		glad_glGetShaderiv = nullGetShaderiv;
+		glad_glGetShaderInfoLog = nullGetShaderInfoLog;
+		glad_glDeleteShader = nullDeleteShader;
+		glad_glCreateProgram = nullCreateProgram;
+		glad_glAttachShader = nullAttachShader;
+		glad_glLinkProgram = nullLinkProgram;
+		glad_glGetProgramiv = nullGetProgramiv;
+		glad_glGetProgramInfoLog = nullGetProgramInfoLog;
+		glad_glDeleteProgram = nullDeleteProgram;
+		glad_glUseProgram = nullUseProgram;
+		glad_glGetUniformLocation = nullGetUniformLocation;
+		glad_glUniform1i = nullUniform1i;
+		glad_glUniform1ui = nullUniform1ui;
+		glad_glUniform1f = nullUniform1f;
+		glad_glUniform2f = nullUniform2f;
+		glad_glUniform4fv = nullUniform4fv;
+		glad_glUniformMatrix4fv = nullUniformMatrix4fv;
+		glad_glDrawArrays = nullDrawArrays;
+		glad_glDrawArraysInstanced = nullDrawArraysInstanced;
+		glad_glDrawElements = nullDrawElements;
+		glad_glDrawElementsInstanced = nullDrawElementsInstanced;
+		glad_glGenQueries = nullGenQueries;
+		glad_glDeleteQueries = nullDeleteQueries;
+		glad_glBeginQuery = nullBeginQuery;
+		glad_glEndQuery = nullEndQuery;
+		glad_glQueryCounter = nullQueryCounter;
+		glad_glGetQueryObjectui64v = nullGetQueryObjectui64v;
+		glad_glFenceSync = nullFenceSync;
+		glad_glClientWaitSync = nullClientWaitSync;
+		glad_glDeleteSync = nullDeleteSync;
+		// a 3.3 core context, the 4.x paths stay off and their entry points NULL
+		GLAD_GL_VERSION_1_0 = GLAD_GL_VERSION_1_1 = GLAD_GL_VERSION_1_2 = GLAD_GL_VERSION_1_3 = 1;
+		GLAD_GL_VERSION_1_4 = GLAD_GL_VERSION_1_5 = GLAD_GL_VERSION_2_0 = GLAD_GL_VERSION_2_1 = 1;
+		GLAD_GL_VERSION_3_0 = GLAD_GL_VERSION_3_1 = GLAD_GL_VERSION_3_2 = GLAD_GL_VERSION_3_3 = 1;
+		vertexArrays[0] = VertexArray(); // holds the element buffer bound without a vertex array
+		installed = true;
+	}
+
+	static bool isInstalled()
+	{
+		return null_gl_detail::installed;
+	}
+
+	// calls since install or the last resetCounts()
+	static uint64_t getCallCount()
+	{
+		uint64_t total = 0;
+		for (uint64_t count : null_gl_detail::calls)
+			total += count;
+		return total;
+	}
+
+	// calls that set state to the value it already had
+	static uint64_t getRedundantCount()
+	{
+		uint64_t total = 0;
+		for (uint64_t count : null_gl_detail::redundantCalls)
+			total += count;
+		return total;
+	}
+
+	static uint64_t getErrorCount()
+	{
+		uint64_t total = 0;
+		for (const auto& entry : null_gl_detail::errors)
+			total += entry.second;
+		return total;
+	}
+
+	static void resetCounts()
+	{
+		std::fill(std::begin(null_gl_detail::calls), std::end(null_gl_detail::calls), 0);
+		std::fill(std::begin(null_gl_detail::redundantCalls), std::end(null_gl_detail::redundantCalls), 0);
+		null_gl_detail::errors.clear();
+	}
+
+	/* Every entry point that was called with its count and redundant share, most called
+	   first, then every distinct error */
+	static void printReport()
+	{
+		using namespace null_gl_detail;
+		std::vector<int> order;
+		for (int call = 0; call < CALL_COUNT; call++)
+			if (calls[call] > 0)
+				order.push_back(call);
+		std::sort(order.begin(), order.end(), [](int a, int b) { return calls[a] > calls[b]; });
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "NULL_GL %llu calls, %llu redundant, %llu errors", (unsigned long long)getCallCount(),
+			(unsigned long long)getRedundantCount(), (unsigned long long)getErrorCount());
+		std::cout << line << std::endl;
+		for (int call : order)
+		{
+			std::snprintf(line, sizeof(line), "  %-28s %12llu calls %12llu redundant", CALL_NAMES[call],
+				(unsigned long long)calls[call], (unsigned long long)redundantCalls[call]);
+			std::cout << line << std::endl;
+		}
+		for (const auto& entry : errors)
+			std::cout << "ERROR::NULL_GL::" << entry.first << " (" << entry.second << "x)" << std::endl;
+	}
+};
+
+#endif
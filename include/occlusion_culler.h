@@ -0,0 +1,486 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <aabb.h>
+#include <worker_pool.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define OCCLUSION_SSE 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC accepts AVX2 intrinsics in any function, the runtime check guards their use
+#define OCCLUSION_AVX2_TARGET
+#else
+#define OCCLUSION_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+/* CPU occlusion culling in the style of Masked Software Occlusion Culling (Andersson et al.).
+   Occluder triangles are rasterized into a low resolution buffer split into 32x8 pixel tiles.
+   Instead of a depth per pixel each tile keeps a 256 bit coverage mask and two depths:
+    - reference: the farthest occluder depth anywhere in the tile
+    - working: the farthest occluder depth of the pixels set in the mask
+   When the mask fills up the working depth becomes the new reference. Occludee bounding boxes
+   are then tested tile by tile against the reference depth, which makes the tile grid a
+   coarse hierarchical level over the masks.
+
+   Depth is stored as 1/w, which interpolates linearly in screen space and does not depend on
+   the projection's depth mapping (standard or reverse-Z). Larger values are nearer.
+   Coverage masks are computed for all 8 rows of a tile at once, with AVX2 when the CPU has
+   it, SSE otherwise and plain C++ on other architectures. Rasterization is split into
+   horizontal bands of tiles processed on WorkerPool threads; bands never share tiles, so no
+   synchronization is needed. */
+class OcclusionCuller
+{
+public:
+	static constexpr int TILE_WIDTH = 32;
+	static constexpr int TILE_HEIGHT = 8;
+
+	OcclusionCuller(int width, int height)
+	{
+		tilesX = std::max((width + TILE_WIDTH - 1) / TILE_WIDTH, 1);
+		tilesY = std::max((height + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+		Width = tilesX * TILE_WIDTH;
+		Height = tilesY * TILE_HEIGHT;
+		tiles.resize((size_t)tilesX * tilesY);
+		useAVX2 = cpuHasAVX2();
+		clear();
+	}
+
+	int Width;
+	int Height;
+
+	void clear()
+	{
+		for (Tile& tile : tiles)
+		{
+			tile.reference = 0.0f; // infinitely far away, nothing is occluded
+			tile.working = 0.0f;
+			for (uint32_t& row : tile.mask)
+				row = 0;
+		}
+		triangles.clear();
+	}
+
+	void setViewProjection(const glm::mat4& matrix)
+	{
+		viewProjection = matrix;
+	}
+
+	/* Queues the triangles of an occluder mesh. positions holds xyz triplets in object space.
+	   Triangles crossing the near plane are dropped, which only makes culling less aggressive */
+	void addOccluder(const float* positions, const unsigned int* indices, size_t triangleCount, const glm::mat4& model)
+	{
+		glm::mat4 modelViewProjection = viewProjection * model;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			ScreenTriangle triangle;
+			bool clipped = false;
+			for (int v = 0; v < 3; v++)
+			{
+				const float* p = positions + 3 * indices[3 * t + v];
+				glm::vec4 clip = modelViewProjection * glm::vec4(p[0], p[1], p[2], 1.0f);
+				if (clip.w < NEAR_W)
+				{
+					clipped = true;
+					break;
+				}
+				float invW = 1.0f / clip.w;
+				triangle.x[v] = (clip.x * invW * 0.5f + 0.5f) * Width;
+				triangle.y[v] = (clip.y * invW * 0.5f + 0.5f) * Height;
+				triangle.z[v] = invW;
+			}
+			if (!clipped && setupTriangle(triangle))
+				triangles.push_back(triangle);
+		}
+	}
+
+	// rasterizes every queued occluder triangle
+	void rasterizeOccluders()
+	{
+		// threads only pay off once there is enough work to split
+		WorkerPool& pool = WorkerPool::shared();
+		size_t bandCount = triangles.size() < PARALLEL_TRIANGLE_COUNT
+			? 1
+			: std::min<size_t>(pool.getThreadCount(), (size_t)tilesY);
+		int tileRowsPerBand = (int)((tilesY + bandCount - 1) / bandCount);
+		pool.parallelFor(bandCount, 1, [&](size_t begin, size_t end) {
+			for (size_t band = begin; band < end; band++)
+			{
+				int firstRow = (int)band * tileRowsPerBand;
+				int lastRow = std::min(firstRow + tileRowsPerBand, tilesY) - 1;
+				for (const ScreenTriangle& triangle : triangles)
+					rasterizeTriangle(triangle, firstRow, lastRow);
+			}
+		});
+		triangles.clear();
+	}
+
+	// false when the box is hidden behind the occluders rendered since the last clear
+	bool isVisible(const AABB& bounds) const
+	{
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float nearest = 0.0f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 p(corner & 1 ? bounds.max.x : bounds.min.x, corner & 2 ? bounds.max.y : bounds.min.y, corner & 4 ? bounds.max.z : bounds.min.z);
+			glm::vec4 clip = viewProjection * glm::vec4(p, 1.0f);
+			// boxes reaching behind the camera are always visible
+			if (clip.w < NEAR_W)
+				return true;
+			float invW = 1.0f / clip.w;
+			float x = (clip.x * invW * 0.5f + 0.5f) * Width;
+			float y = (clip.y * invW * 0.5f + 0.5f) * Height;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			nearest = std::max(nearest, invW);
+		}
+
+		int tileMinX = std::max((int)std::floor(minX) / TILE_WIDTH, 0);
+		int tileMaxX = std::min((int)std::floor(maxX) / TILE_WIDTH, tilesX - 1);
+		int tileMinY = std::max((int)std::floor(minY) / TILE_HEIGHT, 0);
+		int tileMaxY = std::min((int)std::floor(maxY) / TILE_HEIGHT, tilesY - 1);
+		// off screen boxes are the frustum culler's business
+		if (tileMinX > tileMaxX || tileMinY > tileMaxY)
+			return true;
+
+		int pixelMinX = std::max((int)std::floor(minX), 0);
+		int pixelMaxX = std::min((int)std::floor(maxX), Width - 1);
+		int pixelMinY = std::max((int)std::floor(minY), 0);
+		int pixelMaxY = std::min((int)std::floor(maxY), Height - 1);
+		for (int ty = tileMinY; ty <= tileMaxY; ty++)
+		{
+			for (int tx = tileMinX; tx <= tileMaxX; tx++)
+			{
+				const Tile& tile = tiles[(size_t)ty * tilesX + tx];
+				if (nearest < tile.reference)
+					continue;
+				// behind the working layer only counts where its mask covers the box
+				if (nearest >= tile.working || !maskCovers(tile, tx, ty, pixelMinX, pixelMaxX, pixelMinY, pixelMaxY))
+					return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	struct Tile
+	{
+		uint32_t mask[TILE_HEIGHT]; // bit i of row r covers pixel (x0 + i, y0 + r)
+		float reference;
+		float working;
+	};
+
+	// inside when a * x + b * y + c >= 0
+	struct Edge
+	{
+		float a, b, c;
+	};
+
+	struct ScreenTriangle
+	{
+		float x[3], y[3], z[3];
+		Edge edges[3];
+		// 1/w as a plane over the screen: z = zx * x + zy * y + z0
+		float zx, zy, z0;
+		float zMin;
+		int minX, minY, maxX, maxY; // pixel bounds
+	};
+
+	static constexpr float NEAR_W = 1e-4f;
+	static constexpr size_t PARALLEL_TRIANGLE_COUNT = 2048;
+
+	int tilesX;
+	int tilesY;
+	std::vector<Tile> tiles;
+	std::vector<ScreenTriangle> triangles;
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+	bool useAVX2 = false;
+
+	static bool cpuHasAVX2()
+	{
+#if defined(OCCLUSION_SSE) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && (info[1] & (1 << 5));
+#elif defined(OCCLUSION_SSE)
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+	// computes edges, depth plane and bounds, returns false for degenerate or off screen triangles
+	bool setupTriangle(ScreenTriangle& t) const
+	{
+		float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+		if (std::abs(area) < 1e-6f)
+			return false;
+		// occluders are two sided, flip clockwise triangles so the inside is always positive
+		float sign = area > 0.0f ? 1.0f : -1.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			t.edges[i].a = sign * (t.y[i] - t.y[j]);
+			t.edges[i].b = sign * (t.x[j] - t.x[i]);
+			t.edges[i].c = sign * (t.x[i] * t.y[j] - t.x[j] * t.y[i]);
+		}
+
+		float inverseArea = 1.0f / area;
+		t.zx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) * inverseArea;
+		t.zy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) * inverseArea;
+		t.z0 = t.z[0] - t.zx * t.x[0] - t.zy * t.y[0];
+		t.zMin = std::min(t.z[0], std::min(t.z[1], t.z[2]));
+
+		t.minX = std::max((int)std::floor(std::min(t.x[0], std::min(t.x[1], t.x[2]))), 0);
+		t.minY = std::max((int)std::floor(std::min(t.y[0], std::min(t.y[1], t.y[2]))), 0);
+		t.maxX = std::min((int)std::ceil(std::max(t.x[0], std::max(t.x[1], t.x[2]))), Width - 1);
+		t.maxY = std::min((int)std::ceil(std::max(t.y[0], std::max(t.y[1], t.y[2]))), Height - 1);
+		return t.minX <= t.maxX && t.minY <= t.maxY;
+	}
+
+	void rasterizeTriangle(const ScreenTriangle& t, int firstTileRow, int lastTileRow)
+	{
+		int tileMinY = std::max(t.minY / TILE_HEIGHT, firstTileRow);
+		int tileMaxY = std::min(t.maxY / TILE_HEIGHT, lastTileRow);
+		int tileMinX = t.minX / TILE_WIDTH;
+		int tileMaxX = t.maxX / TILE_WIDTH;
+
+		uint32_t mask[TILE_HEIGHT];
+		for (int ty = tileMinY; ty <= tileMaxY; ty++)
+		{
+			for (int tx = tileMinX; tx <= tileMaxX; tx++)
+			{
+				Tile& tile = tiles[(size_t)ty * tilesX + tx];
+				float x0 = (float)(tx * TILE_WIDTH);
+				float y0 = (float)(ty * TILE_HEIGHT);
+
+				// farthest depth of the triangle inside the tile: the plane is linear, so its
+				// minimum over the tile is at a corner, and never below the farthest vertex
+				float cornerX0 = std::max(x0, (float)t.minX), cornerX1 = std::min(x0 + TILE_WIDTH, (float)t.maxX + 1.0f);
+				float cornerY0 = std::max(y0, (float)t.minY), cornerY1 = std::min(y0 + TILE_HEIGHT, (float)t.maxY + 1.0f);
+				float zFar = std::min(
+					std::min(t.zx * cornerX0 + t.zy * cornerY0, t.zx * cornerX1 + t.zy * cornerY0),
+					std::min(t.zx * cornerX0 + t.zy * cornerY1, t.zx * cornerX1 + t.zy * cornerY1)) + t.z0;
+				zFar = std::max(zFar, t.zMin);
+				// already hidden by the reference layer
+				if (zFar <= tile.reference)
+					continue;
+
+				if (!computeCoverage(t, x0, y0, mask))
+					continue;
+				mergeTile(tile, mask, zFar);
+			}
+		}
+	}
+
+	// fills mask with the pixel centers of the tile inside the triangle, false if none are
+	bool computeCoverage(const ScreenTriangle& t, float x0, float y0, uint32_t mask[TILE_HEIGHT]) const
+	{
+#ifdef OCCLUSION_SSE
+		if (useAVX2)
+			return computeCoverageAVX2(t, x0, y0, mask);
+		return computeCoverageSSE(t, x0, y0, mask);
+#else
+		return computeCoverageScalar(t, x0, y0, mask);
+#endif
+	}
+
+	/* Each edge limits every row to a span: for a > 0 pixels right of the crossing point are
+	   inside, for a < 0 the ones left of it, for a == 0 the whole row is in or out. The three
+	   spans are intersected into [start, end) relative to the tile's left column */
+	static uint32_t spanMask(int start, int end)
+	{
+		start = std::max(start, 0);
+		end = std::min(end, TILE_WIDTH);
+		if (start >= end)
+			return 0;
+		uint32_t upToEnd = end == 32 ? 0xFFFFFFFFu : ((1u << end) - 1u);
+		return upToEnd & ~((1u << start) - 1u);
+	}
+
+	static bool computeCoverageScalar(const ScreenTriangle& t, float x0, float y0, uint32_t mask[TILE_HEIGHT])
+	{
+		uint32_t any = 0;
+		for (int row = 0; row < TILE_HEIGHT; row++)
+		{
+			float y = y0 + row + 0.5f;
+			float start = 0.0f;
+			float end = (float)TILE_WIDTH;
+			for (const Edge& edge : t.edges)
+			{
+				float value = edge.b * y + edge.c + edge.a * (x0 + 0.5f);
+				if (edge.a > 0.0f)
+					start = std::max(start, std::ceil(-value / edge.a));
+				else if (edge.a < 0.0f)
+					end = std::min(end, std::floor(-value / edge.a) + 1.0f);
+				else if (value < 0.0f)
+					end = 0.0f;
+			}
+			mask[row] = spanMask((int)std::min(start, TILE_WIDTH + 1.0f), (int)std::max(end, -1.0f));
+			any |= mask[row];
+		}
+		return any != 0;
+	}
+
+#ifdef OCCLUSION_SSE
+	static bool computeCoverageSSE(const ScreenTriangle& t, float x0, float y0, uint32_t mask[TILE_HEIGHT])
+	{
+		alignas(16) int32_t starts[TILE_HEIGHT];
+		alignas(16) int32_t ends[TILE_HEIGHT];
+		const __m128 rowOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		for (int half = 0; half < TILE_HEIGHT; half += 4)
+		{
+			__m128 y = _mm_add_ps(_mm_set1_ps(y0 + half), rowOffsets);
+			__m128 start = _mm_setzero_ps();
+			__m128 end = _mm_set1_ps((float)TILE_WIDTH);
+			for (const Edge& edge : t.edges)
+			{
+				__m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge.b), y), _mm_set1_ps(edge.c + edge.a * (x0 + 0.5f)));
+				if (edge.a != 0.0f)
+				{
+					__m128 crossing = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), value), _mm_set1_ps(edge.a));
+					// clamp before the int conversion, far away crossings would overflow it
+					crossing = _mm_max_ps(_mm_min_ps(crossing, _mm_set1_ps(TILE_WIDTH + 1.0f)), _mm_set1_ps(-1.0f));
+					if (edge.a > 0.0f)
+						start = _mm_max_ps(start, ceilSSE(crossing));
+					else
+						end = _mm_min_ps(end, _mm_add_ps(floorSSE(crossing), _mm_set1_ps(1.0f)));
+				}
+				else
+				{
+					// rows where the horizontal edge is negative are empty
+					__m128 outside = _mm_cmplt_ps(value, _mm_setzero_ps());
+					end = _mm_andnot_ps(outside, end);
+				}
+			}
+			_mm_store_si128((__m128i*)(starts + half), _mm_cvttps_epi32(start));
+			_mm_store_si128((__m128i*)(ends + half), _mm_cvttps_epi32(end));
+		}
+		// SSE has no per-lane variable shifts, so the masks are built in scalar code
+		uint32_t any = 0;
+		for (int row = 0; row < TILE_HEIGHT; row++)
+		{
+			mask[row] = spanMask(starts[row], ends[row]);
+			any |= mask[row];
+		}
+		return any != 0;
+	}
+
+	// SSE2 lacks round instructions; values are clamped to a small range so truncation works
+	static __m128 floorSSE(__m128 value)
+	{
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+	}
+
+	static __m128 ceilSSE(__m128 value)
+	{
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+		return _mm_add_ps(truncated, _mm_and_ps(_mm_cmplt_ps(truncated, value), _mm_set1_ps(1.0f)));
+	}
+
+	OCCLUSION_AVX2_TARGET
+	static bool computeCoverageAVX2(const ScreenTriangle& t, float x0, float y0, uint32_t mask[TILE_HEIGHT])
+	{
+		// one lane per tile row
+		__m256 y = _mm256_add_ps(_mm256_set1_ps(y0), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+		__m256 start = _mm256_setzero_ps();
+		__m256 end = _mm256_set1_ps((float)TILE_WIDTH);
+		for (const Edge& edge : t.edges)
+		{
+			__m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge.b), y), _mm256_set1_ps(edge.c + edge.a * (x0 + 0.5f)));
+			if (edge.a != 0.0f)
+			{
+				__m256 crossing = _mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), value), _mm256_set1_ps(edge.a));
+				crossing = _mm256_max_ps(_mm256_min_ps(crossing, _mm256_set1_ps(TILE_WIDTH + 1.0f)), _mm256_set1_ps(-1.0f));
+				if (edge.a > 0.0f)
+					start = _mm256_max_ps(start, _mm256_ceil_ps(crossing));
+				else
+					end = _mm256_min_ps(end, _mm256_add_ps(_mm256_floor_ps(crossing), _mm256_set1_ps(1.0f)));
+			}
+			else
+			{
+				__m256 outside = _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_LT_OQ);
+				end = _mm256_andnot_ps(outside, end);
+			}
+		}
+
+		// bits [start, end): ones shifted left by start, minus ones shifted left by end.
+		// variable shifts by 32 or more yield 0, which covers the full and empty cases
+		__m256i ones = _mm256_set1_epi32(-1);
+		__m256i startBits = _mm256_sllv_epi32(ones, _mm256_cvttps_epi32(start));
+		__m256i endBits = _mm256_sllv_epi32(ones, _mm256_cvttps_epi32(end));
+		__m256i rows = _mm256_andnot_si256(endBits, startBits);
+		_mm256_storeu_si256((__m256i*)mask, rows);
+		return !_mm256_testz_si256(rows, rows);
+	}
+#endif
+
+	// true if every pixel of the rectangle that lies inside the tile is set in its mask
+	static bool maskCovers(const Tile& tile, int tx, int ty, int minX, int maxX, int minY, int maxY)
+	{
+		int x0 = tx * TILE_WIDTH;
+		int y0 = ty * TILE_HEIGHT;
+		uint32_t columns = spanMask(minX - x0, maxX - x0 + 1);
+		int firstRow = std::max(minY - y0, 0);
+		int lastRow = std::min(maxY - y0, TILE_HEIGHT - 1);
+		for (int row = firstRow; row <= lastRow; row++)
+			if ((tile.mask[row] & columns) != columns)
+				return false;
+		return true;
+	}
+
+	/* Merges a triangle's coverage into the tile. If the triangle is much farther than the
+	   working layer, closer to the reference than to the working depth, the working layer is
+	   dropped and restarted with the triangle, otherwise the two are combined */
+	static void mergeTile(Tile& tile, const uint32_t mask[TILE_HEIGHT], float zFar)
+	{
+		bool workingEmpty = true;
+		for (int row = 0; row < TILE_HEIGHT; row++)
+			workingEmpty = workingEmpty && tile.mask[row] == 0;
+
+		if (workingEmpty || tile.working - zFar > zFar - tile.reference)
+		{
+			for (int row = 0; row < TILE_HEIGHT; row++)
+				tile.mask[row] = mask[row];
+			tile.working = zFar;
+		}
+		else
+		{
+			for (int row = 0; row < TILE_HEIGHT; row++)
+				tile.mask[row] |= mask[row];
+			tile.working = std::min(tile.working, zFar);
+		}
+
+		bool full = true;
+		for (int row = 0; row < TILE_HEIGHT; row++)
+			full = full && tile.mask[row] == 0xFFFFFFFFu;
+		if (full)
+		{
+			// every pixel is at least as near as the working depth now
+			tile.reference = std::max(tile.reference, tile.working);
+			tile.working = 0.0f;
+			for (int row = 0; row < TILE_HEIGHT; row++)
+				tile.mask[row] = 0;
+		}
+	}
+};
+
+#endif
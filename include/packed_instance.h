@@ -0,0 +1,191 @@
+#ifndef PACKED_INSTANCE_H
+#define PACKED_INSTANCE_H
+
+#include <transform.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PACKED_INSTANCE_SSE 1
+#include <emmintrin.h>
+#endif
+
+/* Per instance vertex attributes, 20 bytes instead of the 64 of a model matrix:
+    - position and uniform scale as four floats
+    - orientation as a "smallest three" quaternion in GL_UNSIGNED_INT_2_10_10_10_REV layout:
+      the largest component is dropped (its sign is made positive by negating the whole
+      quaternion, which is the same rotation) and its index stored in the 2 bit field, the
+      other three lie in [-1/sqrt(2), 1/sqrt(2)] and are quantized to 10 bits each
+   The vertex shader reads the orientation as a normalized vec4 and rebuilds the rotation.
+   Worst case angular error of the quantization is about a quarter of a degree. Only the x component
+   of a transform's scale is kept. */
+struct PackedInstance
+{
+	float position[3];
+	float scale;
+	uint32_t orientation;
+};
+
+static_assert(sizeof(PackedInstance) == 20, "PackedInstance must stay tightly packed for the vertex stream");
+
+namespace packed_instance_detail
+{
+	const float SQRT_HALF = 0.70710678f;
+	const float QUANTIZE_SCALE = 1023.0f * 0.5f / SQRT_HALF; // [-1/sqrt(2), 1/sqrt(2)] to [0, 1023]
+	const float QUANTIZE_BIAS = 1023.0f * 0.5f;
+
+	inline uint32_t quantize(float value)
+	{
+		float scaled = value * QUANTIZE_SCALE + QUANTIZE_BIAS;
+		// rounds half to even like _mm_cvtps_epi32, so both paths produce the same bits
+		return (uint32_t)std::nearbyint(std::min(std::max(scaled, 0.0f), 1023.0f));
+	}
+}
+
+inline uint32_t packOrientation(const glm::quat& rotation)
+{
+	using namespace packed_instance_detail;
+	float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+	// ties go to the last component, the SIMD path below does the same
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+		if (std::abs(q[i]) >= std::abs(q[largest]))
+			largest = i;
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+	uint32_t packed = (uint32_t)largest << 30;
+	int shift = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		packed |= quantize(sign * q[i]) << shift;
+		shift += 10;
+	}
+	return packed;
+}
+
+// CPU mirror of the vertex shader's decode
+inline glm::quat unpackOrientation(uint32_t packed)
+{
+	using namespace packed_instance_detail;
+	int largest = (int)(packed >> 30);
+	float q[4];
+	float sumOfSquares = 0.0f;
+	int shift = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		q[i] = ((float)((packed >> shift) & 1023u) - QUANTIZE_BIAS) / QUANTIZE_SCALE;
+		sumOfSquares += q[i] * q[i];
+		shift += 10;
+	}
+	q[largest] = std::sqrt(std::max(1.0f - sumOfSquares, 0.0f));
+	return glm::quat(q[3], q[0], q[1], q[2]);
+}
+
+inline PackedInstance packInstance(const Transform& transform)
+{
+	PackedInstance instance;
+	instance.position[0] = transform.position.x;
+	instance.position[1] = transform.position.y;
+	instance.position[2] = transform.position.z;
+	instance.scale = transform.scale.x;
+	instance.orientation = packOrientation(transform.rotation);
+	return instance;
+}
+
+#ifdef PACKED_INSTANCE_SSE
+namespace packed_instance_detail
+{
+	inline __m128 select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// packs the orientations of four transforms at once, one quaternion per SIMD lane
+	inline void packOrientations4(const Transform* transforms, uint32_t out[4])
+	{
+		__m128 x = _mm_loadu_ps(&transforms[0].rotation.x);
+		__m128 y = _mm_loadu_ps(&transforms[1].rotation.x);
+		__m128 z = _mm_loadu_ps(&transforms[2].rotation.x);
+		__m128 w = _mm_loadu_ps(&transforms[3].rotation.x);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		__m128 ax = _mm_andnot_ps(signBit, x);
+		__m128 ay = _mm_andnot_ps(signBit, y);
+		__m128 az = _mm_andnot_ps(signBit, z);
+		__m128 aw = _mm_andnot_ps(signBit, w);
+		__m128 largestValue = _mm_max_ps(_mm_max_ps(ax, ay), _mm_max_ps(az, aw));
+
+		// later components win ties, like the scalar loop
+		__m128 isY = _mm_cmpeq_ps(ay, largestValue);
+		__m128 isZ = _mm_cmpeq_ps(az, largestValue);
+		__m128 isW = _mm_cmpeq_ps(aw, largestValue);
+		isY = _mm_andnot_ps(_mm_or_ps(isZ, isW), isY);
+		isZ = _mm_andnot_ps(isW, isZ);
+		__m128 isX = _mm_andnot_ps(_mm_or_ps(_mm_or_ps(isY, isZ), isW), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+		// flip the quaternion so the dropped component is positive
+		__m128 largestSigned = select(isX, x, select(isY, y, select(isZ, z, w)));
+		__m128 flip = _mm_and_ps(largestSigned, signBit);
+		x = _mm_xor_ps(x, flip);
+		y = _mm_xor_ps(y, flip);
+		z = _mm_xor_ps(z, flip);
+		w = _mm_xor_ps(w, flip);
+
+		// the three kept components in their original order
+		__m128 first = select(isX, y, x);
+		__m128 second = select(_mm_or_ps(isX, isY), z, y);
+		__m128 third = select(isW, z, w);
+
+		const __m128 scale = _mm_set1_ps(QUANTIZE_SCALE);
+		const __m128 bias = _mm_set1_ps(QUANTIZE_BIAS);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maximum = _mm_set1_ps(1023.0f);
+		__m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(first, scale), bias), zero), maximum));
+		__m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(second, scale), bias), zero), maximum));
+		__m128i c = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(third, scale), bias), zero), maximum));
+
+		__m128i index = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(_mm_castps_si128(isY), _mm_set1_epi32(1)), _mm_and_si128(_mm_castps_si128(isZ), _mm_set1_epi32(2))),
+			_mm_and_si128(_mm_castps_si128(isW), _mm_set1_epi32(3)));
+		__m128i packed = _mm_or_si128(_mm_or_si128(a, _mm_slli_epi32(b, 10)), _mm_or_si128(_mm_slli_epi32(c, 20), _mm_slli_epi32(index, 30)));
+		_mm_storeu_si128((__m128i*)out, packed);
+	}
+}
+#endif
+
+/* Packs count transforms, four orientations at a time with SSE where available */
+inline void packInstances(const Transform* transforms, size_t count, PackedInstance* out)
+{
+	size_t i = 0;
+#ifdef PACKED_INSTANCE_SSE
+	uint32_t orientations[4];
+	for (; i + 4 <= count; i += 4)
+	{
+		packed_instance_detail::packOrientations4(transforms + i, orientations);
+		for (size_t k = 0; k < 4; k++)
+		{
+			const Transform& transform = transforms[i + k];
+			PackedInstance& instance = out[i + k];
+			instance.position[0] = transform.position.x;
+			instance.position[1] = transform.position.y;
+			instance.position[2] = transform.position.z;
+			instance.scale = transform.scale.x;
+			instance.orientation = orientations[k];
+		}
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = packInstance(transforms[i]);
+}
+
+#endif
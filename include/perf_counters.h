@@ -0,0 +1,389 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <heap_tracker.h>
+#include <timing.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Hardware performance counters (cycles, instructions, branch misses and last level cache
+   read misses) and wall time per frame phase, for telling which phases are bound by memory
+   and which data layouts actually help. A PerfCounters counts the thread that opened it, so
+   every thread with phases of its own needs one:
+
+       int culling = counters.addPhase("culling");
+       counters.open(); // on the counted thread
+       {
+           PerfCounters::Scope scope(counters, culling);
+           ...
+       }
+       counters.endFrame(frameIndex);
+
+   The counters are one perf_event_open group read with a single read() per scope edge and
+   scaled for the time the kernel multiplexed them out. Where they cannot be opened (not
+   Linux, perf_event_paranoid, a virtual machine without a PMU) phases are still timed and
+   the counters are reported as unavailable. Scopes of a PerfCounters that was never opened
+   only set the phase's HeapTracker tag, so they can stay in the frame. endFrame() adds the
+   frame to the totals behind printReport() and, with openLog(), writes one CSV row per
+   phase that ran in the frame */
+class PerfCounters
+{
+public:
+	static const int MAX_PHASES = 8;
+
+	enum Counter { CYCLES, INSTRUCTIONS, BRANCH_MISSES, LLC_MISSES, COUNTER_COUNT };
+
+	struct Sample
+	{
+		double seconds = 0.0;
+		uint64_t counters[COUNTER_COUNT] = {};
+	};
+
+	/* Counts a phase from construction to destruction */
+	class Scope
+	{
+	public:
+		Scope(PerfCounters& counters, int phase)
+			: counters(counters), phase(phase)
+		{
+			counters.begin(phase);
+		}
+
+		~Scope()
+		{
+			counters.end(phase);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		PerfCounters& counters;
+		int phase;
+	};
+
+	// name tells the threads apart in reports and the log
+	explicit PerfCounters(const char* name)
+		: name(name)
+	{
+	}
+
+	// e.g. the scene being measured, for the frames that follow
+	void setName(const std::string& newName)
+	{
+		name = newName;
+	}
+
+	~PerfCounters()
+	{
+		close();
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	// returns the id to scope with, -1 past MAX_PHASES
+	int addPhase(const char* phaseName)
+	{
+		if (phaseCount == MAX_PHASES)
+		{
+			std::cout << "ERROR::PERF_COUNTERS::TOO_MANY_PHASES " << phaseName << std::endl;
+			return -1;
+		}
+		phases[phaseCount].name = phaseName;
+		phases[phaseCount].heapTag = HeapTracker::registerTag(phaseName);
+		return phaseCount++;
+	}
+
+	// starts counting the calling thread. returns false when only time can be measured
+	bool open()
+	{
+		close();
+		enabled = true;
+		openGroup();
+		return leader >= 0;
+	}
+
+	void close()
+	{
+#ifdef __linux__
+		for (int& fd : fds)
+		{
+			if (fd >= 0)
+				::close(fd);
+			fd = -1;
+		}
+#endif
+		leader = -1;
+		enabled = false;
+	}
+
+	bool isEnabled() const
+	{
+		return enabled;
+	}
+
+	bool hasCounter(Counter counter) const
+	{
+		return leader >= 0 && groupIndex[counter] >= 0;
+	}
+
+	void begin(int phase)
+	{
+		if (phase < 0)
+			return;
+		// allocations of the phase are attributed to it even when nothing is counted
+		phases[phase].previousHeapTag = HeapTracker::setThreadTag(phases[phase].heapTag);
+		if (enabled)
+			read(phases[phase].start);
+	}
+
+	void end(int phase)
+	{
+		if (phase < 0)
+			return;
+		HeapTracker::setThreadTag(phases[phase].previousHeapTag);
+		if (!enabled)
+			return;
+		Phase& target = phases[phase];
+		Sample now;
+		read(now);
+		target.frame.seconds += now.seconds - target.start.seconds;
+		// a changed multiplexing scale can make a scaled count go back a little
+		for (int i = 0; i < COUNTER_COUNT; i++)
+			if (now.counters[i] > target.start.counters[i])
+				target.frame.counters[i] += now.counters[i] - target.start.counters[i];
+		target.frameScopes++;
+	}
+
+	// adds the phases of the frame to the totals and the log
+	void endFrame(uint64_t frameIndex)
+	{
+		if (!enabled)
+			return;
+		std::unique_lock<std::mutex> guard(logMutex(), std::defer_lock);
+		if (logFile().is_open())
+			guard.lock();
+		for (int p = 0; p < phaseCount; p++)
+		{
+			Phase& phase = phases[p];
+			if (phase.frameScopes == 0)
+				continue;
+			phase.total.seconds += phase.frame.seconds;
+			for (int i = 0; i < COUNTER_COUNT; i++)
+				phase.total.counters[i] += phase.frame.counters[i];
+			phase.frames++;
+			if (guard.owns_lock())
+				writeRow(frameIndex, phase);
+			phase.frame = Sample();
+			phase.frameScopes = 0;
+		}
+	}
+
+	// forgets the totals, e.g. after a warm up
+	void resetTotals()
+	{
+		for (int p = 0; p < phaseCount; p++)
+		{
+			phases[p].total = Sample();
+			phases[p].frames = 0;
+		}
+	}
+
+	// per frame means of every phase that ran
+	void printReport() const
+	{
+		if (!enabled)
+			return;
+		std::printf("PERF_COUNTERS %s", name.c_str());
+		if (leader < 0)
+			std::printf(" (hardware counters unavailable: %s)", unavailableReason.c_str());
+		std::printf("\n%-18s %9s %12s %12s %6s %12s %12s\n", "phase / frame", "time_ms", "cycles", "instructions", "ipc", "branch_miss", "llc_miss");
+		for (int p = 0; p < phaseCount; p++)
+		{
+			const Phase& phase = phases[p];
+			if (phase.frames == 0)
+				continue;
+			double frames = (double)phase.frames;
+			std::printf("%-18s %9.4f", phase.name.c_str(), phase.total.seconds * 1000.0 / frames);
+			printCount(CYCLES, phase.total, frames);
+			printCount(INSTRUCTIONS, phase.total, frames);
+			if (hasCounter(CYCLES) && hasCounter(INSTRUCTIONS) && phase.total.counters[CYCLES] > 0)
+				std::printf(" %6.2f", (double)phase.total.counters[INSTRUCTIONS] / phase.total.counters[CYCLES]);
+			else
+				std::printf(" %6s", "-");
+			printCount(BRANCH_MISSES, phase.total, frames);
+			printCount(LLC_MISSES, phase.total, frames);
+			std::printf("\n");
+		}
+	}
+
+	/* The per frame CSV shared by every PerfCounters:
+	   source,frame,phase,time_ms,cycles,instructions,ipc,branch_misses,llc_misses
+	   source is the name of the PerfCounters, counters that could not be opened are left empty */
+	static bool openLog(const char* path)
+	{
+		std::lock_guard<std::mutex> guard(logMutex());
+		logFile().open(path);
+		if (!logFile())
+		{
+			std::cout << "ERROR::PERF_COUNTERS::FILE_NOT_OPENED " << path << std::endl;
+			return false;
+		}
+		logFile() << "source,frame,phase,time_ms,cycles,instructions,ipc,branch_misses,llc_misses\n";
+		return true;
+	}
+
+	static void closeLog()
+	{
+		std::lock_guard<std::mutex> guard(logMutex());
+		logFile().close();
+	}
+
+private:
+	struct Phase
+	{
+		std::string name;
+		Sample start;
+		Sample frame;
+		Sample total;
+		unsigned int frameScopes = 0;
+		uint64_t frames = 0;
+		int heapTag = HeapTracker::UNTAGGED;
+		int previousHeapTag = HeapTracker::UNTAGGED;
+	};
+
+	std::string name;
+	Phase phases[MAX_PHASES];
+	int phaseCount = 0;
+	bool enabled = false;
+	// one event per counter, the cycles event leads the group
+	int fds[COUNTER_COUNT] = { -1, -1, -1, -1 };
+	int leader = -1;
+	int groupIndex[COUNTER_COUNT] = { -1, -1, -1, -1 }; // position in the group's read
+	int groupSize = 0;
+	std::string unavailableReason;
+
+	static std::mutex& logMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static std::ofstream& logFile()
+	{
+		static std::ofstream file;
+		return file;
+	}
+
+#ifdef __linux__
+	static int openEvent(uint32_t type, uint64_t config, int groupFd)
+	{
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = type;
+		attributes.config = config;
+		attributes.disabled = groupFd < 0 ? 1 : 0; // the group starts together
+		attributes.exclude_kernel = 1; // what the phase's code does, and allowed at paranoid 2
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		// this thread on any cpu
+		return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+	}
+
+	void openGroup()
+	{
+		groupSize = 0;
+		for (int& index : groupIndex)
+			index = -1;
+		leader = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+		if (leader < 0)
+		{
+			unavailableReason = std::string("perf_event_open ") + std::strerror(errno);
+			return;
+		}
+		fds[CYCLES] = leader;
+		groupIndex[CYCLES] = groupSize++;
+		fds[INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader);
+		fds[BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, leader);
+		fds[LLC_MISSES] = openEvent(PERF_TYPE_HW_CACHE,
+			PERF_COUNT_HW_CACHE_LL | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16, leader);
+		// not every PMU names the last level cache, the generic cache miss event is close
+		if (fds[LLC_MISSES] < 0)
+			fds[LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader);
+		for (int i = INSTRUCTIONS; i < COUNTER_COUNT; i++)
+			if (fds[i] >= 0)
+				groupIndex[i] = groupSize++;
+		ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#else
+	void openGroup()
+	{
+		unavailableReason = "only read on Linux";
+	}
+#endif
+
+	void read(Sample& sample) const
+	{
+		sample.seconds = getSteadyTime();
+#ifdef __linux__
+		if (leader < 0)
+			return;
+		// nr, time enabled, time running, then a value per event
+		uint64_t values[3 + COUNTER_COUNT];
+		if (::read(leader, values, sizeof(values)) < (ssize_t)(3 + groupSize) * (ssize_t)sizeof(uint64_t))
+			return;
+		// multiplexed counters only ran part of the time
+		double scale = values[2] > 0 ? (double)values[1] / (double)values[2] : 1.0;
+		for (int i = 0; i < COUNTER_COUNT; i++)
+			if (groupIndex[i] >= 0)
+				sample.counters[i] = (uint64_t)((double)values[3 + groupIndex[i]] * scale);
+#endif
+	}
+
+	void printCount(Counter counter, const Sample& total, double frames) const
+	{
+		if (hasCounter(counter))
+			std::printf(" %12.0f", total.counters[counter] / frames);
+		else
+			std::printf(" %12s", "-");
+	}
+
+	void writeRow(uint64_t frameIndex, const Phase& phase) const
+	{
+		std::ofstream& file = logFile();
+		file << name << ',' << frameIndex << ',' << phase.name << ',' << phase.frame.seconds * 1000.0;
+		for (int i = 0; i < COUNTER_COUNT; i++)
+		{
+			file << ',';
+			if (hasCounter((Counter)i))
+				file << phase.frame.counters[i];
+			// ipc goes after instructions
+			if (i == INSTRUCTIONS)
+			{
+				file << ',';
+				if (hasCounter(CYCLES) && hasCounter(INSTRUCTIONS) && phase.frame.counters[CYCLES] > 0)
+					file << (double)phase.frame.counters[INSTRUCTIONS] / phase.frame.counters[CYCLES];
+			}
+		}
+		file << '\n';
+	}
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef PERFORMANCE_REPORT_H
+#define PERFORMANCE_REPORT_H
+
+#include <latency_histogram.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Collects named timing series (frame time, per phase CPU and GPU times) into histograms and
+   writes their percentiles every windowSeconds, plus a summary over the whole run when the
+   report is closed. Output is JSON lines or CSV depending on the file extension:
+    - JSON: one object per window {"window":0,"start":0.0,"end":5.0,"series":{"frame":{...}}}
+      and a last one with "window":"total"
+    - CSV: a header, then one row per series and window
+   Durations are written in milliseconds. A hitch is a sample above the series' hitch
+   threshold, counted exactly rather than from the buckets. record() may be called from any
+   thread, every call takes a mutex. */
+class PerformanceReport
+{
+public:
+	enum Format { FORMAT_JSON, FORMAT_CSV };
+
+	PerformanceReport(const char* path, double windowSeconds)
+		: windowSeconds(windowSeconds), file(path)
+	{
+		size_t length = std::strlen(path);
+		format = length >= 4 && std::strcmp(path + length - 4, ".csv") == 0 ? FORMAT_CSV : FORMAT_JSON;
+		if (!file)
+			std::cout << "ERROR::PERFORMANCE_REPORT::FILE_NOT_OPENED " << path << std::endl;
+		else if (format == FORMAT_CSV)
+			file << "window,start_s,end_s,series,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,hitches\n";
+	}
+
+	~PerformanceReport()
+	{
+		close();
+	}
+
+	PerformanceReport(const PerformanceReport&) = delete;
+	PerformanceReport& operator=(const PerformanceReport&) = delete;
+
+	// hitchThreshold in seconds, 0 counts no hitches. returns the id to record with
+	int addSeries(const char* name, double hitchThreshold = 0.0)
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		series.emplace_back(new Series());
+		series.back()->name = name;
+		series.back()->hitchThreshold = hitchThreshold;
+		return (int)series.size() - 1;
+	}
+
+	void record(int seriesId, double seconds)
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		Series& target = *series[seriesId];
+		target.window.recordSeconds(seconds);
+		if (target.hitchThreshold > 0.0 && seconds > target.hitchThreshold)
+			target.windowHitches++;
+	}
+
+	// now in seconds on any clock that started at the report's beginning. writes a window
+	// once it is windowSeconds long
+	void update(double now)
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		lastUpdate = now;
+		if (now - windowStart < windowSeconds)
+			return;
+		writeWindow(std::to_string(windowIndex), windowStart, now);
+		windowIndex++;
+		windowStart = now;
+	}
+
+	// writes the current partial window and the summary, later records are ignored
+	void close()
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		if (!file.is_open())
+			return;
+		bool partial = false;
+		for (std::unique_ptr<Series>& entry : series)
+			partial = partial || entry->window.getCount() > 0;
+		if (partial)
+			writeWindow(std::to_string(windowIndex), windowStart, lastUpdate);
+		for (std::unique_ptr<Series>& entry : series)
+		{
+			entry->window = entry->total;
+			entry->windowHitches = entry->totalHitches;
+		}
+		writeWindow("total", 0.0, lastUpdate);
+		file.close();
+	}
+
+private:
+	struct Series
+	{
+		std::string name;
+		double hitchThreshold = 0.0;
+		LatencyHistogram window;
+		LatencyHistogram total; // every window added, for the summary
+		uint64_t windowHitches = 0;
+		uint64_t totalHitches = 0;
+	};
+
+	Format format;
+	double windowSeconds;
+	std::ofstream file;
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Series>> series;
+	unsigned int windowIndex = 0;
+	double windowStart = 0.0;
+	double lastUpdate = 0.0;
+
+	// writes every series' window histogram and moves it into the totals. mutex must be held
+	void writeWindow(const std::string& window, double start, double end)
+	{
+		lastUpdate = end;
+		char line[512];
+		if (format == FORMAT_JSON)
+		{
+			bool numbered = window != "total";
+			std::snprintf(line, sizeof(line), "{\"window\":%s%s%s,\"start\":%.3f,\"end\":%.3f,\"series\":{",
+				numbered ? "" : "\"", window.c_str(), numbered ? "" : "\"", start, end);
+			file << line;
+		}
+		for (size_t i = 0; i < series.size(); i++)
+		{
+			Series& entry = *series[i];
+			const LatencyHistogram& histogram = entry.window;
+			double mean = histogram.getMean() * 1e-6;
+			double p50 = histogram.getPercentile(50.0) * 1e-6;
+			double p95 = histogram.getPercentile(95.0) * 1e-6;
+			double p99 = histogram.getPercentile(99.0) * 1e-6;
+			double maximum = histogram.getMax() * 1e-6;
+			unsigned long long count = (unsigned long long)histogram.getCount();
+			unsigned long long hitches = (unsigned long long)entry.windowHitches;
+			if (format == FORMAT_JSON)
+				std::snprintf(line, sizeof(line),
+					"%s\"%s\":{\"count\":%llu,\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p95_ms\":%.4f,\"p99_ms\":%.4f,\"max_ms\":%.4f,\"hitches\":%llu}",
+					i > 0 ? "," : "", entry.name.c_str(), count, mean, p50, p95, p99, maximum, hitches);
+			else
+				std::snprintf(line, sizeof(line), "%s,%.3f,%.3f,%s,%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%llu\n",
+					window.c_str(), start, end, entry.name.c_str(), count, mean, p50, p95, p99, maximum, hitches);
+			file << line;
+
+			entry.total.add(entry.window);
+			entry.totalHitches += entry.windowHitches;
+			entry.window.reset();
+			entry.windowHitches = 0;
+		}
+		if (format == FORMAT_JSON)
+			file << "}}\n";
+		file.flush();
+	}
+};
+
+#endif
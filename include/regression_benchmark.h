@@ -0,0 +1,666 @@
+#ifndef REGRESSION_BENCHMARK_H
+#define REGRESSION_BENCHMARK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <aabb.h>
+#include <aabb_tree.h>
+#include <benchmark_baseline.h>
+#include <camera.h>
+#include <camera_path.h>
+#include <gl_debug_output.h>
+#include <heap_tracker.h>
+#include <instancing.h>
+#include <null_gl.h>
+#include <packed_instance.h>
+#include <perf_counters.h>
+#include <render_state.h>
+#include <render_stats.h>
+#include <render_target.h>
+#include <shader.h>
+#include <shader_preprocessor.h>
+#include <timing.h>
+#include <transform.h>
+#include <vertex_layout.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Objects of a benchmark scene. Every object is one of meshCount meshes drawn with one of
+   textureCount textures and one of shaderCount shader programs. Mesh 0 is the benchmark's
+   mesh, mesh i a box with every face split into (i + 1)^2 quads. Instanced scenes draw the
+   visible objects with one instanced draw per mesh and ignore textures and shaders */
+struct BenchmarkScene
+{
+	std::string name; // no spaces, it is a field of the baseline file
+	std::vector<Transform> objects;
+	std::vector<unsigned int> meshes; // per object, empty uses mesh 0 for all
+	std::vector<unsigned int> textures; // per object, empty uses texture 0 for all
+	std::vector<unsigned int> shaders; // per object, empty uses program 0 for all
+	unsigned int meshCount = 1;
+	unsigned int textureCount = 1;
+	unsigned int shaderCount = 1;
+	size_t animatedCount = 0; // the first animatedCount objects spin every frame
+	bool instanced = false;
+	bool sortDraws = false; // sort the visible objects by program, texture and mesh every frame
+	CameraPath path; // flown unless the benchmark was given a recorded path
+	float farPlane = 100.0f;
+};
+
+/* Renders each scene along a camera path at a fixed timestep and measures every frame.
+   Scenes the application can draw, one mesh, texture and program without draw sorting, run
+   through its own frame (see AppFrame), so the main loop's simulation, culling, packing,
+   cube draw path, debug lines, HUD and frame pacing are what gets measured. The others
+   switch between many meshes, textures or programs, which the application never does, and
+   are drawn by the benchmark's own loop into an offscreen target:
+    - cpu_ms: simulation, culling and GL submission on the CPU
+    - gpu_ms: GL_TIMESTAMP queries at the frame's start and end
+    - draw_calls, triangles, state_changes, upload_kb: RenderStats counters per frame
+   Each scene is flown RUNS times after a discarded warm up run. A run is reduced to its
+   median frame, the scene's timings to the median run with the spread of the runs as noise,
+   so BenchmarkBaseline can tell a slowdown from a noisy machine. After the warm up run a
+   frame must not allocate: every frame that does is reported with its call stacks and
+   counted by getAllocatingFrames(), which fails the benchmark. Frames are not overlapped:
+   the GPU result of a frame is read before the next one starts, which keeps CPU and GPU
+   times independent of each other. With enablePerfCounters() the phases of every frame are
+   counted and each scene's last run is summarized per phase; the counters are read a few
+   times a frame, which cpu_ms then includes. Must run on the thread that owns the GL context. */
+class RegressionBenchmark
+{
+public:
+	static const int WIDTH = 1280;
+	static const int HEIGHT = 720;
+	static const unsigned int RUNS = 5;
+	static constexpr double TIMESTEP = 1.0 / 60.0;
+	static constexpr float PATH_DURATION = 5.0f;
+
+	/* What the scenes are drawn with */
+	struct Assets
+	{
+		unsigned int (*createMesh)(); // positions at location 0, texture coordinates at 1, inside a unit cube
+		int vertexCount;
+		const char* vertexPath; // model, view and projection uniforms, PackedInstance attributes with PACKED_INSTANCING
+		const char* fragmentPath; // texture1 and texture2 samplers
+	};
+
+	/* The application's frame, split the way its simulation and render threads split it.
+	   Every scene's camera gets projectionMode, which must match the depth setup the
+	   application left in the context */
+	struct AppFrame
+	{
+		std::function<void(const std::vector<Transform>& objects, size_t animatedCount)> loadScene;
+		std::function<void(float timestep)> simulate;
+		std::function<void(RenderState& state, Camera& camera, int width, int height, float alpha)> buildState;
+		std::function<void(const RenderState& state)> render; // GL commands of the frame, HUD included
+		Projection_Mode projectionMode = Projection_Mode::STANDARD;
+	};
+
+	std::vector<BenchmarkScene> scenes;
+
+	// without an application frame every scene is drawn by the benchmark's own loop
+	void setAppFrame(const AppFrame& frame)
+	{
+		appFrame = frame;
+	}
+
+	// with a path set, every scene flies it instead of its own
+	void setCameraPath(const CameraPath& path)
+	{
+		cameraPath = path;
+	}
+
+	// counts transform update, culling, sort and submission of every frame, see PerfCounters
+	void enablePerfCounters()
+	{
+		perfCountersEnabled = true;
+	}
+
+	// frames of the measured runs that allocated, over all scenes of the last run()
+	uint64_t getAllocatingFrames() const
+	{
+		return allocatingFrames;
+	}
+
+	/* The regression suite: the main scene's cubes, 100k instanced cubes and two scenes of
+	   individually drawn cubes switching between many textures or many shader programs */
+	void addDefaultScenes(const glm::vec3* cubePositions, size_t cubeCount)
+	{
+		BenchmarkScene cubes;
+		cubes.name = "cubes";
+		for (size_t i = 0; i < cubeCount; i++)
+		{
+			Transform cube;
+			cube.position = cubePositions[i];
+			cube.rotation = glm::angleAxis(glm::radians(20.0f * i), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+			cubes.objects.push_back(cube);
+		}
+		cubes.animatedCount = cubeCount;
+		cubes.path = CameraPath::orbit(glm::vec3(0.0f, 0.0f, -6.0f), 14.0f, 3.0f, 180.0f, PATH_DURATION);
+		scenes.push_back(cubes);
+
+		// fixed seed so every run and every machine draws the same scenes
+		std::mt19937 random(1234);
+		BenchmarkScene instanced;
+		instanced.name = "instanced_100k";
+		instanced.objects = randomObjects(random, 100000, 150.0f);
+		instanced.animatedCount = instanced.objects.size() / 10;
+		instanced.instanced = true;
+		instanced.path = CameraPath::orbit(glm::vec3(0.0f), 200.0f, 40.0f, 90.0f, PATH_DURATION);
+		instanced.farPlane = 600.0f;
+		scenes.push_back(instanced);
+
+		BenchmarkScene textures;
+		textures.name = "many_textures";
+		textures.objects = gridObjects(16, 2.5f);
+		textures.textureCount = 256;
+		textures.textures = randomIndices(random, textures.objects.size(), textures.textureCount);
+		textures.animatedCount = textures.objects.size() / 10;
+		textures.path = CameraPath::orbit(glm::vec3(0.0f), 45.0f, 10.0f, 90.0f, PATH_DURATION);
+		textures.farPlane = 200.0f;
+		scenes.push_back(textures);
+
+		BenchmarkScene shaders = textures;
+		shaders.name = "many_shaders";
+		shaders.textureCount = 1;
+		shaders.textures.clear();
+		shaders.shaderCount = 64;
+		shaders.shaders = randomIndices(random, shaders.objects.size(), shaders.shaderCount);
+		scenes.push_back(shaders);
+	}
+
+	// measures every scene, a scene that cannot be set up is reported and left out
+	std::vector<BenchmarkMetric> run(const Assets& assets)
+	{
+		// the counters need the hooks even when the HUD does not
+		RenderStats::installHooks();
+		if (!target.create(WIDTH, HEIGHT))
+			return std::vector<BenchmarkMetric>();
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glGenQueries(2, timerQueries);
+		// the phases also tag the frame's allocations
+		if (phases.transformUpdate < 0)
+		{
+			phases.transformUpdate = counters.addPhase("transform_update");
+			phases.culling = counters.addPhase("culling");
+			phases.sort = counters.addPhase("sort");
+			phases.submission = counters.addPhase("submission");
+		}
+		if (perfCountersEnabled && !counters.isEnabled())
+			counters.open();
+		allocatingFrames = 0;
+
+		std::vector<BenchmarkMetric> metrics;
+		for (const BenchmarkScene& scene : scenes)
+		{
+			// the application's frame binds its own framebuffers
+			target.bind();
+			glViewport(0, 0, WIDTH, HEIGHT);
+			SceneResources resources;
+			if (drawsWithAppFrame(scene) || createResources(scene, assets, resources))
+				measureScene(scene, resources, metrics);
+			destroyResources(resources);
+		}
+
+		glDeleteQueries(2, timerQueries);
+		target.destroy();
+		return metrics;
+	}
+
+private:
+	struct Program
+	{
+		Shader shader;
+		int modelLocation;
+		int viewLocation;
+		int projectionLocation;
+	};
+
+	/* GL objects and per run state of the scene being measured */
+	struct SceneResources
+	{
+		std::vector<unsigned int> VAOs; // per mesh
+		std::vector<int> vertexCounts;
+		std::vector<unsigned int> instanceVBOs;
+		std::vector<uint64_t> sortKeys; // per object
+		std::vector<unsigned int> textures;
+		std::vector<Program> programs;
+		std::vector<Transform> objects;
+		AABBTree tree;
+		std::vector<int> animatedProxies;
+		std::vector<AABB> animatedBounds;
+		// reused by every frame
+		std::vector<int> visible;
+		std::vector<Transform> visibleTransforms;
+		std::vector<PackedInstance> instances;
+	};
+
+	static inline const AABB OBJECT_BOUNDS = AABB(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+	CameraPath cameraPath;
+	AppFrame appFrame;
+	RenderState appState; // reused by every application frame
+	RenderTarget target;
+	unsigned int timerQueries[2] = {}; // frame start and end
+	bool perfCountersEnabled = false;
+	uint64_t allocatingFrames = 0;
+	PerfCounters counters{ "benchmark" }; // renamed after the scene being measured
+	struct
+	{
+		int transformUpdate = -1;
+		int culling = -1;
+		int sort = -1;
+		int submission = -1;
+	} phases;
+
+	void measureScene(const BenchmarkScene& scene, SceneResources& resources, std::vector<BenchmarkMetric>& metrics)
+	{
+		const CameraPath& path = cameraPath.empty() ? scene.path : cameraPath;
+		unsigned int frameCount = (unsigned int)(path.getDuration() / TIMESTEP) + 1;
+		bool app = drawsWithAppFrame(scene);
+		Camera camera;
+		camera.SetAspectRatio((float)WIDTH / (float)HEIGHT);
+		camera.SetClipPlanes(NEAR_PLANE, scene.farPlane);
+		camera.SetProjectionMode(appFrame.projectionMode);
+
+		std::vector<double> cpuTimes(frameCount), gpuTimes(frameCount);
+		std::vector<double> cpuMedians, gpuMedians;
+		FrameCounters totals = {};
+		uint64_t nullCalls = 0, nullRedundant = 0;
+		FrameAllocations allocations(scene.name.c_str(), frameCount); // the warm up run may allocate
+		GLDebugOutput::pushGroup(scene.name.c_str()); // groups the scene's frames in captures
+		counters.setName(scene.name);
+		for (unsigned int run = 0; run <= RUNS; run++)
+		{
+			if (app)
+				appFrame.loadScene(scene.objects, scene.animatedCount);
+			else
+				resetScene(scene, resources);
+			if (run == RUNS)
+			{
+				nullCalls = NullGL::getCallCount();
+				nullRedundant = NullGL::getRedundantCount();
+				counters.resetTotals();
+			}
+			for (unsigned int frame = 0; frame < frameCount; frame++)
+			{
+				path.apply((float)(frame * TIMESTEP), camera);
+				RenderStats::counters() = FrameCounters();
+				// not GL_TIME_ELAPSED: llvmpipe loses its start when the frame first binds a framebuffer
+				glQueryCounter(timerQueries[0], GL_TIMESTAMP);
+				double start = getSteadyTime();
+				allocations.beginFrame();
+				if (app)
+					drawAppFrame(camera);
+				else
+					drawFrame(scene, resources, camera);
+				allocations.endFrame();
+				cpuTimes[frame] = getSteadyTime() - start;
+				glQueryCounter(timerQueries[1], GL_TIMESTAMP);
+				GLuint64 frameStart = 0, frameEnd = 0;
+				glGetQueryObjectui64v(timerQueries[0], GL_QUERY_RESULT, &frameStart);
+				glGetQueryObjectui64v(timerQueries[1], GL_QUERY_RESULT, &frameEnd); // waits for the frame
+				gpuTimes[frame] = (double)(frameEnd - frameStart) * 1e-9;
+				counters.endFrame((uint64_t)run * frameCount + frame);
+
+				const FrameCounters& counters = RenderStats::counters();
+				if (run == RUNS)
+				{
+					totals.drawCalls += counters.drawCalls;
+					totals.triangles += counters.triangles;
+					totals.programBinds += counters.programBinds;
+					totals.vertexArrayBinds += counters.vertexArrayBinds;
+					totals.textureBinds += counters.textureBinds;
+					totals.bufferUploadBytes += counters.bufferUploadBytes;
+				}
+			}
+			// the first run warms up caches, drivers and clocks
+			if (run == 0)
+				continue;
+			cpuMedians.push_back(BenchmarkBaseline::median(cpuTimes) * 1000.0);
+			gpuMedians.push_back(BenchmarkBaseline::median(gpuTimes) * 1000.0);
+		}
+		GLDebugOutput::popGroup();
+		nullCalls = NullGL::getCallCount() - nullCalls;
+		nullRedundant = NullGL::getRedundantCount() - nullRedundant;
+		counters.printReport();
+		if (allocations.getAllocatingFrames() > 0)
+		{
+			allocations.printReport();
+			allocatingFrames += allocations.getAllocatingFrames();
+		}
+
+		double frames = (double)frameCount;
+		metrics.push_back({ scene.name, "cpu_ms", BenchmarkMetric::KIND_TIME,
+			BenchmarkBaseline::median(cpuMedians), BenchmarkBaseline::robustDeviation(cpuMedians) });
+		metrics.push_back({ scene.name, "gpu_ms", BenchmarkMetric::KIND_TIME,
+			BenchmarkBaseline::median(gpuMedians), BenchmarkBaseline::robustDeviation(gpuMedians) });
+		metrics.push_back({ scene.name, "draw_calls", BenchmarkMetric::KIND_COUNT, totals.drawCalls / frames, 0.0 });
+		metrics.push_back({ scene.name, "triangles", BenchmarkMetric::KIND_COUNT, totals.triangles / frames, 0.0 });
+		metrics.push_back({ scene.name, "state_changes", BenchmarkMetric::KIND_COUNT,
+			(totals.programBinds + totals.vertexArrayBinds + totals.textureBinds) / frames, 0.0 });
+		metrics.push_back({ scene.name, "upload_kb", BenchmarkMetric::KIND_COUNT, totals.bufferUploadBytes / 1024.0 / frames, 0.0 });
+		// without a driver cpu_ms is the renderer alone, and every call and redundant one is seen
+		if (NullGL::isInstalled())
+		{
+			metrics.push_back({ scene.name, "gl_calls", BenchmarkMetric::KIND_COUNT, nullCalls / frames, 0.0 });
+			metrics.push_back({ scene.name, "redundant_calls", BenchmarkMetric::KIND_COUNT, nullRedundant / frames, 0.0 });
+		}
+	}
+
+	bool drawsWithAppFrame(const BenchmarkScene& scene) const
+	{
+		return appFrame.render && scene.meshCount <= 1 && scene.textureCount <= 1 && scene.shaderCount <= 1 && !scene.sortDraws;
+	}
+
+	/* One simulation step and one frame of the application, which draws the current state
+	   without blending towards the previous one */
+	void drawAppFrame(Camera& camera)
+	{
+		counters.begin(phases.transformUpdate);
+		appFrame.simulate((float)TIMESTEP);
+		counters.end(phases.transformUpdate);
+		counters.begin(phases.culling);
+		appFrame.buildState(appState, camera, WIDTH, HEIGHT, 1.0f);
+		counters.end(phases.culling);
+		PerfCounters::Scope submission(counters, phases.submission);
+		appFrame.render(appState);
+	}
+
+	/* One frame of a scene the application cannot draw: spin the animated objects, cull
+	   against the frustum, sort and draw what is visible. The simulation and culling are the
+	   application's, the submission switches state per object */
+	void drawFrame(const BenchmarkScene& scene, SceneResources& resources, Camera& camera)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		counters.begin(phases.transformUpdate);
+		// the same spin as the main scene's cubes, 50 degrees per second
+		glm::quat spin = glm::angleAxis(glm::radians(50.0f) * (float)TIMESTEP, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f)));
+		for (size_t i = 0; i < scene.animatedCount; i++)
+		{
+			resources.objects[i].rotation = glm::normalize(resources.objects[i].rotation * spin);
+			resources.animatedBounds[i] = OBJECT_BOUNDS.transformed(resources.objects[i].toMatrix());
+		}
+		if (scene.animatedCount > 0)
+			resources.tree.refitProxies(resources.animatedProxies, resources.animatedBounds);
+		counters.end(phases.transformUpdate);
+
+		counters.begin(phases.culling);
+		resources.visible.clear();
+		resources.tree.queryFrustum(camera.GetFrustum(), [&](int proxyId) {
+			resources.visible.push_back(resources.tree.getUserData(proxyId));
+		});
+		counters.end(phases.culling);
+
+		// instanced scenes need the objects of a mesh next to each other
+		if (scene.sortDraws || (scene.instanced && resources.VAOs.size() > 1))
+		{
+			PerfCounters::Scope scope(counters, phases.sort);
+			const std::vector<uint64_t>& keys = resources.sortKeys;
+			std::sort(resources.visible.begin(), resources.visible.end(), [&](int a, int b) { return keys[a] < keys[b]; });
+		}
+
+		PerfCounters::Scope submission(counters, phases.submission);
+		const glm::mat4& view = camera.GetViewMatrix();
+		const glm::mat4& projection = camera.GetProjectionMatrix();
+		for (Program& program : resources.programs)
+		{
+			program.shader.use();
+			glUniformMatrix4fv(program.viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+			glUniformMatrix4fv(program.projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+		}
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, resources.textures[0]);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, resources.textures[0]);
+
+		if (scene.instanced)
+		{
+			resources.visibleTransforms.clear();
+			for (int object : resources.visible)
+				resources.visibleTransforms.push_back(resources.objects[object]);
+			resources.instances.resize(resources.visibleTransforms.size());
+			packInstances(resources.visibleTransforms.data(), resources.instances.size(), resources.instances.data());
+			for (size_t begin = 0; begin < resources.visible.size();)
+			{
+				unsigned int mesh = scene.meshes.empty() ? 0 : scene.meshes[resources.visible[begin]];
+				size_t end = begin + 1;
+				while (end < resources.visible.size() && (scene.meshes.empty() ? 0 : scene.meshes[resources.visible[end]]) == mesh)
+					end++;
+				glBindVertexArray(resources.VAOs[mesh]);
+				uploadInstances(resources.instanceVBOs[mesh], resources.instances.data() + begin, end - begin);
+				glDrawArraysInstanced(GL_TRIANGLES, 0, resources.vertexCounts[mesh], (GLsizei)(end - begin));
+				begin = end;
+			}
+			glBindVertexArray(0);
+			return;
+		}
+
+		// state is only changed when the next object needs something else
+		unsigned int boundProgram = (unsigned int)resources.programs.size() - 1; // used last above
+		unsigned int boundTexture = 0;
+		unsigned int boundMesh = 0;
+		glBindVertexArray(resources.VAOs[0]);
+		for (int object : resources.visible)
+		{
+			unsigned int program = scene.shaders.empty() ? 0 : scene.shaders[object];
+			unsigned int texture = scene.textures.empty() ? 0 : scene.textures[object];
+			unsigned int mesh = scene.meshes.empty() ? 0 : scene.meshes[object];
+			if (mesh != boundMesh)
+			{
+				glBindVertexArray(resources.VAOs[mesh]);
+				boundMesh = mesh;
+			}
+			if (program != boundProgram)
+			{
+				resources.programs[program].shader.use();
+				boundProgram = program;
+			}
+			if (texture != boundTexture)
+			{
+				glBindTexture(GL_TEXTURE_2D, resources.textures[texture]);
+				boundTexture = texture;
+			}
+			glm::mat4 model = resources.objects[object].toMatrix();
+			glUniformMatrix4fv(resources.programs[program].modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+			glDrawArrays(GL_TRIANGLES, 0, resources.vertexCounts[mesh]);
+		}
+		glBindVertexArray(0);
+	}
+
+	// every run starts from the scene's initial state
+	void resetScene(const BenchmarkScene& scene, SceneResources& resources)
+	{
+		resources.objects = scene.objects;
+		resources.tree.clear(); // keeps the capacity the warm up run grew
+		resources.animatedProxies.clear();
+		for (size_t i = 0; i < resources.objects.size(); i++)
+		{
+			int proxyId = resources.tree.createProxy(OBJECT_BOUNDS.transformed(resources.objects[i].toMatrix()), (int)i);
+			if (i < scene.animatedCount)
+				resources.animatedProxies.push_back(proxyId);
+		}
+		resources.animatedBounds.resize(scene.animatedCount);
+	}
+
+	bool createResources(const BenchmarkScene& scene, const Assets& assets, SceneResources& resources)
+	{
+		unsigned int meshCount = std::max(scene.meshCount, 1u);
+		for (unsigned int i = 0; i < meshCount; i++)
+		{
+			resources.VAOs.push_back(i == 0 ? assets.createMesh() : createSubdividedBox(i + 1));
+			resources.vertexCounts.push_back(i == 0 ? assets.vertexCount : 36 * (i + 1) * (i + 1));
+			if (scene.instanced)
+				resources.instanceVBOs.push_back(createPackedInstanceBuffer(resources.VAOs.back()));
+		}
+		// most expensive state change first
+		resources.sortKeys.resize(scene.objects.size());
+		for (size_t i = 0; i < scene.objects.size(); i++)
+		{
+			uint64_t program = scene.instanced || scene.shaders.empty() ? 0 : scene.shaders[i];
+			uint64_t texture = scene.instanced || scene.textures.empty() ? 0 : scene.textures[i];
+			uint64_t mesh = scene.meshes.empty() ? 0 : scene.meshes[i];
+			resources.sortKeys[i] = program << 42 | texture << 21 | mesh;
+		}
+
+		// program i differs from the others by a define, so the driver cannot share them
+		unsigned int shaderCount = scene.instanced ? 1 : std::max(scene.shaderCount, 1u);
+		for (unsigned int i = 0; i < shaderCount; i++)
+		{
+			ShaderPreprocessor preprocessor;
+			preprocessor.define("BENCHMARK_VARIANT", std::to_string(i));
+			if (scene.instanced)
+				preprocessor.define("PACKED_INSTANCING");
+			std::string vertexCode = preprocessor.process(assets.vertexPath);
+			std::string fragmentCode = preprocessor.process(assets.fragmentPath);
+			if (vertexCode.empty() || fragmentCode.empty())
+			{
+				std::cout << "ERROR::REGRESSION_BENCHMARK::SCENE_SKIPPED " << scene.name << std::endl;
+				return false;
+			}
+			Program program = { Shader::fromSource(vertexCode, fragmentCode), 0, 0, 0 };
+			program.shader.use();
+			program.shader.setInt("texture1", 0);
+			program.shader.setInt("texture2", 1);
+			program.modelLocation = glGetUniformLocation(program.shader.ID, "model");
+			program.viewLocation = glGetUniformLocation(program.shader.ID, "view");
+			program.projectionLocation = glGetUniformLocation(program.shader.ID, "projection");
+			resources.programs.push_back(program);
+		}
+
+		unsigned int textureCount = std::max(scene.textureCount, 1u);
+		for (unsigned int i = 0; i < textureCount; i++)
+			resources.textures.push_back(createCheckerTexture(i));
+		return true;
+	}
+
+	void destroyResources(SceneResources& resources)
+	{
+		for (Program& program : resources.programs)
+			glDeleteProgram(program.shader.ID);
+		if (!resources.textures.empty())
+			glDeleteTextures((GLsizei)resources.textures.size(), resources.textures.data());
+		if (!resources.instanceVBOs.empty())
+			glDeleteBuffers((GLsizei)resources.instanceVBOs.size(), resources.instanceVBOs.data());
+		if (!resources.VAOs.empty())
+			glDeleteVertexArrays((GLsizei)resources.VAOs.size(), resources.VAOs.data());
+	}
+
+	struct MeshVertex
+	{
+		glm::vec3 position;
+		glm::vec2 texCoord;
+	};
+	using MeshVertexLayout = VertexLayout<MeshVertex,
+		VERTEX_ATTRIBUTE(MeshVertex, position), // location 0
+		VERTEX_ATTRIBUTE(MeshVertex, texCoord)>; // location 1
+
+	// unit box with every face split into subdivisions^2 quads, the same size as the box
+	// with more vertex work
+	static unsigned int createSubdividedBox(unsigned int subdivisions)
+	{
+		std::vector<MeshVertex> vertices;
+		vertices.reserve(36 * subdivisions * subdivisions);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (float side = -0.5f; side <= 0.5f; side += 1.0f)
+			{
+				for (unsigned int v = 0; v < subdivisions; v++)
+				{
+					for (unsigned int u = 0; u < subdivisions; u++)
+					{
+						float u0 = (float)u / subdivisions, u1 = (float)(u + 1) / subdivisions;
+						float v0 = (float)v / subdivisions, v1 = (float)(v + 1) / subdivisions;
+						glm::vec2 corners[6] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u1, v1 }, { u0, v1 }, { u0, v0 } };
+						for (const glm::vec2& corner : corners)
+						{
+							glm::vec3 position;
+							position[axis] = side;
+							position[(axis + 1) % 3] = corner.x - 0.5f;
+							position[(axis + 2) % 3] = corner.y - 0.5f;
+							vertices.push_back({ position, corner });
+						}
+					}
+				}
+			}
+		}
+		return createVertexArrayObject<MeshVertexLayout>(vertices.data(), vertices.size());
+	}
+
+	// 64x64 checkerboard in a color of its own, mipmapped like the loaded textures
+	static unsigned int createCheckerTexture(unsigned int index)
+	{
+		const int SIZE = 64;
+		glm::vec3 color = glm::vec3((index * 97) % 256, (index * 57 + 80) % 256, (index * 31 + 160) % 256);
+		std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+		for (int y = 0; y < SIZE; y++)
+		{
+			for (int x = 0; x < SIZE; x++)
+			{
+				float shade = ((x / 8 + y / 8) % 2 == 0) ? 1.0f : 0.5f;
+				unsigned char* pixel = &pixels[(y * SIZE + x) * 4];
+				pixel[0] = (unsigned char)(color.r * shade);
+				pixel[1] = (unsigned char)(color.g * shade);
+				pixel[2] = (unsigned char)(color.b * shade);
+				pixel[3] = 255;
+			}
+		}
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SIZE, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+
+	static std::vector<Transform> randomObjects(std::mt19937& random, size_t count, float extent)
+	{
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::normal_distribution<float> component(0.0f, 1.0f);
+		std::vector<Transform> objects(count);
+		for (Transform& object : objects)
+		{
+			object.position = glm::vec3(position(random), position(random), position(random));
+			object.rotation = glm::normalize(glm::quat(component(random), component(random), component(random), component(random)));
+		}
+		return objects;
+	}
+
+	// size^3 objects spacing apart, centered on the origin
+	static std::vector<Transform> gridObjects(int size, float spacing)
+	{
+		std::vector<Transform> objects;
+		float offset = 0.5f * spacing * (size - 1);
+		for (int z = 0; z < size; z++)
+			for (int y = 0; y < size; y++)
+				for (int x = 0; x < size; x++)
+				{
+					Transform object;
+					object.position = glm::vec3(x, y, z) * spacing - glm::vec3(offset);
+					objects.push_back(object);
+				}
+		return objects;
+	}
+
+	static std::vector<unsigned int> randomIndices(std::mt19937& random, size_t count, unsigned int range)
+	{
+		std::uniform_int_distribution<unsigned int> index(0, range - 1);
+		std::vector<unsigned int> indices(count);
+		for (unsigned int& value : indices)
+			value = index(random);
+		return indices;
+	}
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <glm/glm.hpp>
+#include <packed_instance.h>
+
+#include <vector>
+
+struct DrawCommand
+{
+	glm::mat4 model;
+};
+
+/* Immutable snapshot of everything the render thread needs for one frame. Built by the
+   simulation thread, so the render thread never reads the camera or the scene directly. */
+struct RenderState
+{
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	unsigned int cameraVersion = 0; // lets the renderer skip unchanged view/projection uploads
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	std::vector<DrawCommand> draws;
+	std::vector<PackedInstance> instances; // the same draws packed for instancing, empty when not used
+};
+
+#endif
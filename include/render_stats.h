@@ -0,0 +1,298 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <glad/glad.h>
+#include <timing.h>
+
+#include <algorithm>
+#include <cstdint>
+
+/* What the GL calls of one frame did */
+struct FrameCounters
+{
+	uint32_t drawCalls;
+	uint64_t instances;
+	uint64_t triangles; // indirect draws count as calls only, their sizes live on the GPU
+	uint32_t programBinds;
+	uint32_t vertexArrayBinds;
+	uint32_t textureBinds;
+	uint64_t bufferUploadBytes; // including writes to persistently mapped buffers
+	uint64_t textureUploadBytes;
+};
+
+struct FrameStats
+{
+	FrameCounters counters;
+	double frameInterval; // seconds since the previous frame started
+	double cpuTime; // render thread time from beginFrame to endFrame
+	double gpuTime; // negative until the timer queries come back, a few frames later
+};
+
+namespace render_stats_detail
+{
+	inline FrameCounters counters = {};
+
+	// the real entry points behind the counting hooks
+	inline PFNGLDRAWARRAYSPROC drawArrays = NULL;
+	inline PFNGLDRAWELEMENTSPROC drawElements = NULL;
+	inline PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced = NULL;
+	inline PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced = NULL;
+	inline PFNGLDRAWARRAYSINDIRECTPROC drawArraysIndirect = NULL;
+	inline PFNGLDRAWELEMENTSINDIRECTPROC drawElementsIndirect = NULL;
+	inline PFNGLUSEPROGRAMPROC useProgram = NULL;
+	inline PFNGLBINDVERTEXARRAYPROC bindVertexArray = NULL;
+	inline PFNGLBINDTEXTUREPROC bindTexture = NULL;
+	inline PFNGLBUFFERDATAPROC bufferData = NULL;
+	inline PFNGLBUFFERSUBDATAPROC bufferSubData = NULL;
+	inline PFNGLTEXIMAGE2DPROC texImage2D = NULL;
+	inline PFNGLTEXSUBIMAGE2DPROC texSubImage2D = NULL;
+
+	inline uint64_t triangleCount(GLenum mode, GLsizei count)
+	{
+		if (mode == GL_TRIANGLES)
+			return (uint64_t)(count / 3);
+		if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+			return (uint64_t)std::max(count - 2, 0);
+		return 0;
+	}
+
+	// approximate, row alignment padding is ignored
+	inline uint64_t pixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+	{
+		uint64_t components = 4;
+		if (format == GL_RED || format == GL_DEPTH_COMPONENT || format == GL_RED_INTEGER)
+			components = 1;
+		else if (format == GL_RG || format == GL_RG_INTEGER)
+			components = 2;
+		else if (format == GL_RGB || format == GL_BGR)
+			components = 3;
+		uint64_t componentSize = 1;
+		if (type == GL_FLOAT || type == GL_INT || type == GL_UNSIGNED_INT)
+			componentSize = 4;
+		else if (type == GL_HALF_FLOAT || type == GL_SHORT || type == GL_UNSIGNED_SHORT)
+			componentSize = 2;
+		return (uint64_t)width * (uint64_t)height * components * componentSize;
+	}
+
+	inline void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		counters.drawCalls++;
+		counters.instances++;
+		counters.triangles += triangleCount(mode, count);
+		drawArrays(mode, first, count);
+	}
+
+	inline void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		counters.drawCalls++;
+		counters.instances++;
+		counters.triangles += triangleCount(mode, count);
+		drawElements(mode, count, type, indices);
+	}
+
+	inline void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		counters.drawCalls++;
+		counters.instances += (uint64_t)instanceCount;
+		counters.triangles += triangleCount(mode, count) * (uint64_t)instanceCount;
+		drawArraysInstanced(mode, first, count, instanceCount);
+	}
+
+	inline void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+	{
+		counters.drawCalls++;
+		counters.instances += (uint64_t)instanceCount;
+		counters.triangles += triangleCount(mode, count) * (uint64_t)instanceCount;
+		drawElementsInstanced(mode, count, type, indices, instanceCount);
+	}
+
+	inline void APIENTRY countDrawArraysIndirect(GLenum mode, const void* indirect)
+	{
+		counters.drawCalls++;
+		drawArraysIndirect(mode, indirect);
+	}
+
+	inline void APIENTRY countDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect)
+	{
+		counters.drawCalls++;
+		drawElementsIndirect(mode, type, indirect);
+	}
+
+	inline void APIENTRY countUseProgram(GLuint program)
+	{
+		counters.programBinds++;
+		useProgram(program);
+	}
+
+	inline void APIENTRY countBindVertexArray(GLuint array)
+	{
+		counters.vertexArrayBinds++;
+		bindVertexArray(array);
+	}
+
+	inline void APIENTRY countBindTexture(GLenum target, GLuint texture)
+	{
+		counters.textureBinds++;
+		bindTexture(target, texture);
+	}
+
+	inline void APIENTRY countBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (data != NULL) // orphaning uploads nothing
+			counters.bufferUploadBytes += (uint64_t)size;
+		bufferData(target, size, data, usage);
+	}
+
+	inline void APIENTRY countBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		counters.bufferUploadBytes += (uint64_t)size;
+		bufferSubData(target, offset, size, data);
+	}
+
+	inline void APIENTRY countTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+		GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		if (pixels != NULL)
+			counters.textureUploadBytes += pixelBytes(width, height, format, type);
+		texImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+	}
+
+	inline void APIENTRY countTexSubImage2D(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void* pixels)
+	{
+		counters.textureUploadBytes += pixelBytes(width, height, format, type);
+		texSubImage2D(target, level, xOffset, yOffset, width, height, format, type, pixels);
+	}
+
+	template <typename Function>
+	void hook(Function& entryPoint, Function& original, Function counting)
+	{
+		// installing twice would make the hook call itself
+		if (entryPoint == NULL || entryPoint == counting)
+			return;
+		original = entryPoint;
+		entryPoint = counting;
+	}
+}
+
+/* Per frame rendering statistics for the HUD and benchmarks.
+   - counters come from hooks swapped into glad's function pointers, so every GL call in the
+     program is counted without touching the call sites. Code writing into mapped memory
+     adds its bytes to counters() itself
+   - GPU time is measured with GL_TIMESTAMP queries at the frame's start and end, read back
+     QUERY_LATENCY frames later so the CPU never waits for them
+   - the last HISTORY_SIZE frames are kept for graphs
+   Render thread only. */
+class RenderStats
+{
+public:
+	static const unsigned int HISTORY_SIZE = 240;
+	static const unsigned int QUERY_LATENCY = 4;
+
+	// call once after glad is loaded and before any other thread uses GL
+	static void installHooks()
+	{
+		using namespace render_stats_detail;
+		hook(glad_glDrawArrays, drawArrays, countDrawArrays);
+		hook(glad_glDrawElements, drawElements, countDrawElements);
+		hook(glad_glDrawArraysInstanced, drawArraysInstanced, countDrawArraysInstanced);
+		hook(glad_glDrawElementsInstanced, drawElementsInstanced, countDrawElementsInstanced);
+		hook(glad_glDrawArraysIndirect, drawArraysIndirect, countDrawArraysIndirect);
+		hook(glad_glDrawElementsIndirect, drawElementsIndirect, countDrawElementsIndirect);
+		hook(glad_glUseProgram, useProgram, countUseProgram);
+		hook(glad_glBindVertexArray, bindVertexArray, countBindVertexArray);
+		hook(glad_glBindTexture, bindTexture, countBindTexture);
+		hook(glad_glBufferData, bufferData, countBufferData);
+		hook(glad_glBufferSubData, bufferSubData, countBufferSubData);
+		hook(glad_glTexImage2D, texImage2D, countTexImage2D);
+		hook(glad_glTexSubImage2D, texSubImage2D, countTexSubImage2D);
+	}
+
+	// the frame being recorded
+	static FrameCounters& counters()
+	{
+		return render_stats_detail::counters;
+	}
+
+	void create()
+	{
+		glGenQueries(QUERY_LATENCY, startQueries);
+		glGenQueries(QUERY_LATENCY, endQueries);
+	}
+
+	void destroy()
+	{
+		glDeleteQueries(QUERY_LATENCY, startQueries);
+		glDeleteQueries(QUERY_LATENCY, endQueries);
+	}
+
+	void beginFrame()
+	{
+		unsigned int slot = (unsigned int)(frameCount % QUERY_LATENCY);
+		if (frameCount >= QUERY_LATENCY)
+			resolveGpuTime(slot, frameCount - QUERY_LATENCY);
+		glQueryCounter(startQueries[slot], GL_TIMESTAMP);
+
+		double now = getSteadyTime();
+		frameInterval = frameStart > 0.0 ? now - frameStart : 0.0;
+		frameStart = now;
+		counters() = FrameCounters();
+	}
+
+	void endFrame()
+	{
+		unsigned int slot = (unsigned int)(frameCount % QUERY_LATENCY);
+		glQueryCounter(endQueries[slot], GL_TIMESTAMP);
+
+		FrameStats& stats = history[frameCount % HISTORY_SIZE];
+		stats.counters = counters();
+		stats.frameInterval = frameInterval;
+		stats.cpuTime = getSteadyTime() - frameStart;
+		stats.gpuTime = -1.0;
+		frameCount++;
+	}
+
+	unsigned long long getFrameCount() const
+	{
+		return frameCount;
+	}
+
+	// framesAgo 0 is the last completed frame, at most getHistoryCount() - 1
+	const FrameStats& getFrame(unsigned int framesAgo) const
+	{
+		return history[(frameCount - 1 - framesAgo) % HISTORY_SIZE];
+	}
+
+	unsigned int getHistoryCount() const
+	{
+		return (unsigned int)std::min<unsigned long long>(frameCount, HISTORY_SIZE);
+	}
+
+	// of the newest frame whose queries came back
+	double getLastGpuTime() const
+	{
+		return lastGpuTime;
+	}
+
+private:
+	unsigned int startQueries[QUERY_LATENCY] = {};
+	unsigned int endQueries[QUERY_LATENCY] = {};
+	FrameStats history[HISTORY_SIZE] = {};
+	unsigned long long frameCount = 0;
+	double frameStart = 0.0;
+	double frameInterval = 0.0;
+	double lastGpuTime = 0.0;
+
+	void resolveGpuTime(unsigned int slot, unsigned long long frame)
+	{
+		// QUERY_LATENCY frames later the GPU is done with it, the read does not stall
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(startQueries[slot], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(endQueries[slot], GL_QUERY_RESULT, &end);
+		lastGpuTime = (double)(end - start) * 1e-9;
+		if (frameCount - frame <= HISTORY_SIZE)
+			history[frame % HISTORY_SIZE].gpuTime = lastGpuTime;
+	}
+};
+
+#endif
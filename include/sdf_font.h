@@ -0,0 +1,119 @@
+#ifndef SDF_FONT_H
+#define SDF_FONT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sdf_font_format.h>
+#include <vertex_layout.h>
+#include <vertex_quantizer.h>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+/* A signed distance field glyph atlas baked offline by src/tools/sdf_font_baker.cpp. The
+   distance field stays sharp at any text size, so one atlas serves every size of the HUD.
+   Covers the codepoints below 128, anything else falls back to '?' */
+class SdfFont
+{
+public:
+	/* Glyph metrics ready for layout, in pixels at the baked size */
+	struct Glyph
+	{
+		float advance;
+		glm::vec2 offset; // quad bottom left relative to the pen
+		glm::vec2 size; // empty for glyphs without an outline
+		Unorm16x4 uvRect;
+	};
+
+	unsigned int Texture = 0;
+
+	bool load(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		SdfFontHeader header;
+		if (!file.read((char*)&header, sizeof(header)) || header.magic != SDF_FONT_MAGIC || header.version != SDF_FONT_VERSION)
+		{
+			std::cout << "ERROR::FONT::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return false;
+		}
+		std::vector<SdfGlyph> records(header.glyphCount);
+		std::vector<unsigned char> atlas((size_t)header.atlasWidth * header.atlasHeight);
+		if (!file.read((char*)records.data(), records.size() * sizeof(SdfGlyph)) || !file.read((char*)atlas.data(), atlas.size()))
+		{
+			std::cout << "ERROR::FONT::FILE_TRUNCATED " << path << std::endl;
+			return false;
+		}
+
+		pixelHeight = header.pixelHeight;
+		lineHeight = header.lineHeight;
+		ascent = header.ascent;
+		for (Glyph& glyph : glyphs)
+			glyph = Glyph();
+		for (const SdfGlyph& record : records)
+		{
+			if (record.codepoint >= GLYPH_TABLE_SIZE)
+				continue;
+			Glyph& glyph = glyphs[record.codepoint];
+			glyph.advance = record.advance;
+			glyph.offset = glm::vec2(record.offsetX, record.offsetY);
+			glyph.size = glm::vec2(record.width, record.height);
+			glyph.uvRect = packUnorm16x4(glm::vec4(record.uvRect[0], record.uvRect[1], record.uvRect[2], record.uvRect[3]));
+		}
+
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		// no mipmaps, averaging distances would round the corners of small text
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed bytes
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, header.atlasWidth, header.atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return true;
+	}
+
+	void destroy()
+	{
+		if (Texture != 0)
+			glDeleteTextures(1, &Texture);
+		Texture = 0;
+	}
+
+	bool isLoaded() const
+	{
+		return Texture != 0;
+	}
+
+	const Glyph& getGlyph(unsigned char character) const
+	{
+		return glyphs[character < GLYPH_TABLE_SIZE ? character : '?'];
+	}
+
+	float getPixelHeight() const
+	{
+		return pixelHeight;
+	}
+
+	float getLineHeight() const
+	{
+		return lineHeight;
+	}
+
+	float getAscent() const
+	{
+		return ascent;
+	}
+
+private:
+	static const unsigned int GLYPH_TABLE_SIZE = 128;
+
+	Glyph glyphs[GLYPH_TABLE_SIZE] = {};
+	float pixelHeight = 1.0f;
+	float lineHeight = 0.0f;
+	float ascent = 0.0f;
+};
+
+#endif
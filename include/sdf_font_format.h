@@ -0,0 +1,38 @@
+#ifndef SDF_FONT_FORMAT_H
+#define SDF_FONT_FORMAT_H
+
+#include <cstdint>
+
+/* File layout shared by the offline baker (src/tools/sdf_font_baker.cpp) and SdfFont:
+   an SdfFontHeader, glyphCount SdfGlyph records, then atlasWidth * atlasHeight bytes of
+   distance field, one byte per texel with the glyph outline at 128. Rows are stored in the
+   order glTexImage2D reads them, so the first row is v = 0.
+   Metrics are in pixels at the baked pixelHeight with y pointing up, everything little endian. */
+const uint32_t SDF_FONT_MAGIC = 0x46464453; // "SDFF"
+const uint32_t SDF_FONT_VERSION = 1;
+
+struct SdfFontHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t atlasWidth;
+	uint32_t atlasHeight;
+	float pixelHeight; // size the glyphs were rasterized at
+	float lineHeight; // baseline to baseline
+	float ascent; // baseline to the top of the tallest glyph
+	float spread; // distance in pixels from the outline to where the field reaches 0 or 255
+	uint32_t glyphCount;
+};
+
+struct SdfGlyph
+{
+	uint32_t codepoint;
+	float advance; // horizontal pen movement
+	float offsetX; // bottom left corner of the quad relative to the pen
+	float offsetY;
+	float width; // quad size including the spread
+	float height;
+	float uvRect[4]; // texture coordinates of the quad's bottom left and top right corners
+};
+
+#endif
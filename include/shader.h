@@ -2,21 +2,65 @@
 #define SHADER_H
 
 #include "glad/glad.h"
+#include "shader_preprocessor.h"
 
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <cstring>
 #include <iostream>
 
+// GL_KHR_parallel_shader_compile is not part of the glad core loader, so it is loaded by hand
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
 class Shader
 {
 public:
 	// program ID
 	unsigned int ID;
 
-	Shader(const char* vertexPath, const char* fragmentPath) 
+	Shader(const char* vertexPath, const char* fragmentPath)
+	{
+		ShaderPreprocessor preprocessor;
+		ID = createShaderProgram(preprocessor.process(vertexPath), preprocessor.process(fragmentPath));
+	}
+
+	// builds a program from already preprocessed source. with wait set to false the
+	// build is only submitted and ID stays 0 until pollReload() reports it linked
+	static Shader fromSource(const std::string& vertexCode, const std::string& fragmentCode, bool wait = true)
+	{
+		Shader shader;
+		if (wait)
+			shader.ID = shader.createShaderProgram(vertexCode, fragmentCode);
+		else
+			shader.reload(vertexCode, fragmentCode);
+		return shader;
+	}
+
+	// enables driver side background compilation when GL_KHR_parallel_shader_compile is available.
+	// must be called once after GLAD is loaded
+	static void initParallelCompile(GLADloadproc load)
 	{
-		ID = createShaderProgram(vertexPath, fragmentPath);
+		int extensionCount = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		for (int i = 0; i < extensionCount; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 ||
+				std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+			{
+				PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads =
+					(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+				if (maxThreads == NULL)
+					maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+				if (maxThreads != NULL)
+				{
+					maxThreads(0xFFFFFFFF); // let the driver pick the thread count
+					parallelCompile = true;
+				}
+				return;
+			}
+		}
 	}
 
 	void use()
@@ -24,24 +68,93 @@ public:
 		glUseProgram(ID);
 	};
 
-	void setBool(const std::string& name, bool value) const
+	// names are C strings so literals do not build a std::string per call
+	void setBool(const char* name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(glGetUniformLocation(ID, name), (int)value);
 	};
 
-	void setInt(const std::string& name, int value) const
+	void setInt(const char* name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(glGetUniformLocation(ID, name), value);
 	};
 
-	void setFloat(const std::string& name, float value) const
+	void setFloat(const char* name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(glGetUniformLocation(ID, name), value);
 	};
 
+	// starts building a new program from source without waiting for the result.
+	// the current program stays in use until pollReload() swaps the new one in
+	void reload(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		discardPendingProgram();
+		pendingVertexShader = compileShader(vertexCode, GL_VERTEX_SHADER);
+		pendingFragmentShader = compileShader(fragmentCode, GL_FRAGMENT_SHADER);
+		pendingProgram = glCreateProgram();
+		glAttachShader(pendingProgram, pendingVertexShader);
+		glAttachShader(pendingProgram, pendingFragmentShader);
+		glLinkProgram(pendingProgram);
+		pendingSubmitted = true;
+	}
+
+	// call once per frame. returns true when a pending program linked and replaced ID,
+	// in which case uniforms must be set again. a failed build keeps the old program
+	bool pollReload()
+	{
+		if (pendingProgram == 0)
+			return false;
+
+		// the frame that submitted the build never queries it. without the extension the status
+		// query waits for the compile, a frame later the driver had the time of a frame for it
+		if (pendingSubmitted)
+		{
+			pendingSubmitted = false;
+			return false;
+		}
+
+		// querying the status before the driver finishes would block the render thread
+		if (parallelCompile)
+		{
+			int completed;
+			glGetProgramiv(pendingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+			if (!completed)
+				return false;
+		}
+
+		bool compiled = checkShaderCompilation(pendingVertexShader, "VERTEX");
+		compiled = checkShaderCompilation(pendingFragmentShader, "FRAGMENT") && compiled;
+		if (!compiled || !checkProgramLink(pendingProgram))
+		{
+			std::cout << "ERROR::SHADER::RELOAD_FAILED keeping previous program" << std::endl;
+			discardPendingProgram();
+			return false;
+		}
+
+		glDeleteShader(pendingVertexShader);
+		glDeleteShader(pendingFragmentShader);
+		glDeleteProgram(ID);
+		ID = pendingProgram;
+		pendingProgram = pendingVertexShader = pendingFragmentShader = 0;
+		return true;
+	}
+
+	bool reloadPending() const
+	{
+		return pendingProgram != 0;
+	}
+
 private:
+	inline static bool parallelCompile = false;
+
+	Shader() : ID(0) {}
+
+	unsigned int pendingProgram = 0;
+	unsigned int pendingVertexShader = 0;
+	unsigned int pendingFragmentShader = 0;
+	bool pendingSubmitted = false; // reload() ran since the last pollReload()
 
-	void checkShaderCompilation(unsigned int shader, const char* type)
+	bool checkShaderCompilation(unsigned int shader, const char* type)
 	{
 		int success;
 		char infoLog[512];
@@ -51,9 +164,10 @@ private:
 			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
 			std::cout << "ERROR::SHADER::"<< type <<"::COMPILATION_FAILED\n" << infoLog << std::endl;
 		}
+		return success;
 	}
 
-	void checkProgramLink(unsigned int program)
+	bool checkProgramLink(unsigned int program)
 	{
 		int success;
 		char infoLog[512];
@@ -63,45 +177,30 @@ private:
 			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
 			std::cout << "ERROR::SHADER::PROGRAM::LINK_FAILED\n" << infoLog << std::endl;
 		}
+		return success;
 	}
 
-	unsigned int createShader(const char* shaderPath, const char* type) 
+	unsigned int compileShader(const std::string& shaderCode, GLenum type)
 	{
-		// read shader file from path
-		std::string shaderCode;
-		std::ifstream shaderFile;
-		shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		try
-		{
-			shaderFile.open(shaderPath);
-			std::stringstream shaderStream;
-			shaderStream << shaderFile.rdbuf();
-			shaderFile.close();
-			shaderCode = shaderStream.str();
-		}
-		catch (std::ifstream::failure e)
-		{
-			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-		}
 		const char* shaderSource = shaderCode.c_str();
-
-		// create a shader
-		unsigned int shader;
-		if (type == "VERTEX")
-			shader = glCreateShader(GL_VERTEX_SHADER);
-		else
-			shader = glCreateShader(GL_FRAGMENT_SHADER);
-		// source the code into the created shader and compile
+		// create a shader, source the code into it and compile
+		unsigned int shader = glCreateShader(type);
 		glShaderSource(shader, 1, &shaderSource, NULL);
 		glCompileShader(shader);
+		return shader;
+	}
+
+	unsigned int createShader(const std::string& shaderCode, const char* type)
+	{
+		unsigned int shader = compileShader(shaderCode, std::strcmp(type, "VERTEX") == 0 ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
 		checkShaderCompilation(shader, type);
 		return shader;
 	}
 
-	unsigned int createShaderProgram(const char* vertexPath, const char* fragmentPath) 
+	unsigned int createShaderProgram(const std::string& vertexCode, const std::string& fragmentCode)
 	{
-		unsigned int vertexShader = createShader(vertexPath, "VERTEX");
-		unsigned int fragmentShader = createShader(fragmentPath, "FRAGMENT");
+		unsigned int vertexShader = createShader(vertexCode, "VERTEX");
+		unsigned int fragmentShader = createShader(fragmentCode, "FRAGMENT");
 		// create a program to link the vertex and fragment shaders
 		unsigned int shaderProgram;
 		shaderProgram = glCreateProgram();
@@ -111,11 +210,22 @@ private:
 		checkProgramLink(shaderProgram);
 
 		// after shaders are linked we can delete them
-		glDeleteShader(shaderProgram);
+		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 
 		return shaderProgram;
 	}
+
+	void discardPendingProgram()
+	{
+		if (pendingProgram == 0)
+			return;
+		glDeleteShader(pendingVertexShader);
+		glDeleteShader(pendingFragmentShader);
+		glDeleteProgram(pendingProgram);
+		pendingProgram = pendingVertexShader = pendingFragmentShader = 0;
+		pendingSubmitted = false;
+	}
 };
 
 #endif
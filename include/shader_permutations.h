@@ -0,0 +1,226 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <shader.h>
+#include <shader_preprocessor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Builds variants of one vertex/fragment shader pair from a list of feature flags.
+   A variant is identified by a 64-bit key where bit i enables features[i], which is
+   injected as "#define FEATURE 1". Variants are compiled the first time they are
+   requested and cached by key; a variant that fails to build is not cached. */
+class ShaderPermutations
+{
+public:
+	ShaderPermutations(const char* vertexPath, const char* fragmentPath, std::vector<std::string> features)
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), features(std::move(features))
+	{
+		if (this->features.size() > 64)
+			std::cout << "ERROR::SHADER_PERMUTATIONS::TOO_MANY_FEATURES only the first 64 are used" << std::endl;
+		featureVersions.resize(this->features.size());
+	}
+
+	// variants with the feature replace the root #version, e.g. "430 core" for storage buffers
+	void setFeatureVersion(const std::string& feature, const std::string& version)
+	{
+		for (size_t i = 0; i < features.size(); i++)
+			if (features[i] == feature)
+				featureVersions[i] = version;
+	}
+
+	// returns the key enabling the named feature, or 0 if it is unknown
+	uint64_t featureBit(const std::string& feature) const
+	{
+		for (size_t i = 0; i < features.size() && i < 64; i++)
+			if (features[i] == feature)
+				return uint64_t(1) << i;
+		return 0;
+	}
+
+	// returns the variant for key, compiling it synchronously on first use, or NULL when it
+	// does not build. the pointer stays valid while the variant is cached
+	Shader* get(uint64_t key)
+	{
+		auto cached = variants.find(key);
+		if (cached != variants.end())
+			return &cached->second;
+
+		ShaderPreprocessor preprocessor = createPreprocessor(key);
+		std::string vertexCode = preprocessor.process(vertexPath, &dependencies);
+		std::string fragmentCode = preprocessor.process(fragmentPath, &dependencies);
+		if (vertexCode.empty() || fragmentCode.empty())
+			return NULL;
+		Shader shader = Shader::fromSource(vertexCode, fragmentCode);
+		// the next get() tries again and reports the error again
+		int linked = 0;
+		glGetProgramiv(shader.ID, GL_LINK_STATUS, &linked);
+		if (!linked)
+		{
+			glDeleteProgram(shader.ID);
+			return NULL;
+		}
+		return &variants.emplace(key, shader).first->second;
+	}
+
+	// builds every listed variant up front. sources are preprocessed on worker threads,
+	// then all programs are submitted to the driver before any status is queried so
+	// drivers with parallel shader compilation build them concurrently
+	void precompile(const std::vector<uint64_t>& keys)
+	{
+		std::vector<std::pair<uint64_t, std::future<PreprocessedVariant>>> jobs;
+		for (uint64_t key : keys)
+		{
+			if (variants.count(key) != 0)
+				continue;
+			jobs.emplace_back(key, std::async(std::launch::async, [this, key]() { return preprocess(key); }));
+		}
+
+		// GL calls stay on the thread that owns the context
+		std::vector<uint64_t> pending;
+		for (auto& job : jobs)
+		{
+			PreprocessedVariant variant = job.second.get();
+			addDependencies(variant.dependencies);
+			variants.emplace(job.first, Shader::fromSource(variant.vertexCode, variant.fragmentCode, false));
+			pending.push_back(job.first);
+		}
+
+		while (!pending.empty())
+		{
+			size_t waiting = pending.size();
+			for (size_t i = 0; i < pending.size();)
+			{
+				Shader& shader = variants.at(pending[i]);
+				shader.pollReload();
+				if (shader.reloadPending())
+				{
+					i++;
+					continue;
+				}
+				// a failed variant is dropped so get() retries and reports the error again
+				if (shader.ID == 0)
+					variants.erase(pending[i]);
+				pending[i] = pending.back();
+				pending.pop_back();
+			}
+			// nothing finished, leave the core to the driver's compiler threads
+			if (pending.size() == waiting)
+				std::this_thread::yield();
+		}
+	}
+
+	// rebuilds every cached variant from the files on disk, e.g. after a ShaderWatcher saw an
+	// edit: they all include the same sources. the sources are preprocessed on a worker thread
+	// and every variant keeps its program until pollReload() swaps the rebuilt one in
+	void reload()
+	{
+		reloadKeys.clear();
+		for (const auto& variant : variants)
+			reloadKeys.push_back(variant.first);
+	}
+
+	// call once per frame on the thread that owns the context. returns true when a rebuilt
+	// variant was swapped in, whose uniforms then need setting again. a variant whose
+	// rebuild fails keeps its previous program
+	bool pollReload()
+	{
+		// an edit during a rebuild waits for it, so the worker is never waited on
+		if (!reloadSources.valid() && !reloadKeys.empty())
+		{
+			reloadSources = std::async(std::launch::async, [this, keys = reloadKeys]() {
+				std::vector<PreprocessedVariant> sources;
+				for (uint64_t key : keys)
+					sources.push_back(preprocess(key));
+				return sources;
+			});
+			reloadKeys.clear();
+		}
+		if (reloadSources.valid() && reloadSources.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			for (PreprocessedVariant& variant : reloadSources.get())
+			{
+				// a file caught mid-save reads as empty, the watcher reports the next write
+				if (variant.vertexCode.empty() || variant.fragmentCode.empty())
+					continue;
+				addDependencies(variant.dependencies);
+				variants.at(variant.key).reload(variant.vertexCode, variant.fragmentCode);
+			}
+		}
+
+		bool swapped = false;
+		for (auto& variant : variants)
+			swapped = variant.second.pollReload() || swapped;
+		return swapped;
+	}
+
+	size_t size() const
+	{
+		return variants.size();
+	}
+
+	// every file read while building variants, so a watcher can track #included files
+	const std::vector<std::string>& getDependencies() const
+	{
+		return dependencies;
+	}
+
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::vector<std::string> features;
+	std::vector<std::string> featureVersions; // per feature, empty keeps the file's #version
+	std::unordered_map<uint64_t, Shader> variants;
+	std::vector<std::string> dependencies;
+	std::vector<uint64_t> reloadKeys; // waiting for the next rebuild
+
+	struct PreprocessedVariant
+	{
+		uint64_t key;
+		std::string vertexCode;
+		std::string fragmentCode;
+		std::vector<std::string> dependencies;
+	};
+	std::future<std::vector<PreprocessedVariant>> reloadSources; // of the rebuild in progress
+
+	// reads only the paths and features, which stay fixed while variants build, so it runs on worker threads
+	PreprocessedVariant preprocess(uint64_t key) const
+	{
+		ShaderPreprocessor preprocessor = createPreprocessor(key);
+		PreprocessedVariant variant;
+		variant.key = key;
+		variant.vertexCode = preprocessor.process(vertexPath, &variant.dependencies);
+		variant.fragmentCode = preprocessor.process(fragmentPath, &variant.dependencies);
+		return variant;
+	}
+
+	void addDependencies(const std::vector<std::string>& files)
+	{
+		dependencies.insert(dependencies.end(), files.begin(), files.end());
+		std::sort(dependencies.begin(), dependencies.end());
+		dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+	}
+
+	ShaderPreprocessor createPreprocessor(uint64_t key) const
+	{
+		ShaderPreprocessor preprocessor;
+		for (size_t i = 0; i < features.size() && i < 64; i++)
+			if (key & (uint64_t(1) << i))
+			{
+				preprocessor.define(features[i]);
+				if (!featureVersions[i].empty())
+					preprocessor.version = featureVersions[i];
+			}
+		return preprocessor;
+	}
+};
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Expands a GLSL file before it is handed to glShaderSource:
+    - #include "file" is resolved relative to the including file, #pragma once is honoured
+    - #define NAME VALUE lines are injected right after #version
+    - the #version line of the root file can be overridden
+   #line directives are emitted around includes so compiler errors point at the right file,
+   using the index of the file in the dependency list as the source string number. */
+class ShaderPreprocessor
+{
+public:
+	// replaces the root file #version when not empty, e.g. "330 core"
+	std::string version;
+	std::vector<std::pair<std::string, std::string>> defines;
+
+	void define(const std::string& name, const std::string& value = "1")
+	{
+		defines.emplace_back(name, value);
+	}
+
+	// returns the expanded source of the file at path, or an empty string on failure.
+	// every file that was read is appended to dependencies so callers can watch them
+	std::string process(const std::string& path, std::vector<std::string>* dependencies = nullptr) const
+	{
+		std::vector<std::string> files;
+		std::vector<std::string> includeStack;
+		std::vector<std::string> onceFiles;
+		std::string output;
+		bool versionWritten = false;
+		if (!expand(std::filesystem::path(path).lexically_normal().string(), output, files, includeStack, onceFiles, versionWritten))
+			output.clear();
+		if (dependencies != nullptr)
+			dependencies->insert(dependencies->end(), files.begin(), files.end());
+		return output;
+	}
+
+	static std::string readFile(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return std::string();
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		return stream.str();
+	}
+
+private:
+	bool expand(
+		const std::string& path,
+		std::string& output,
+		std::vector<std::string>& files,
+		std::vector<std::string>& includeStack,
+		std::vector<std::string>& onceFiles,
+		bool& versionWritten
+	) const
+	{
+		if (std::find(onceFiles.begin(), onceFiles.end(), path) != onceFiles.end())
+			return true;
+		if (std::find(includeStack.begin(), includeStack.end(), path) != includeStack.end())
+		{
+			std::cout << "ERROR::SHADER::INCLUDE_CYCLE " << path << std::endl;
+			return false;
+		}
+
+		std::string source = readFile(path);
+		if (source.empty())
+			return false;
+
+		size_t fileIndex = std::find(files.begin(), files.end(), path) - files.begin();
+		if (fileIndex == files.size())
+			files.push_back(path);
+		includeStack.push_back(path);
+		bool root = includeStack.size() == 1;
+
+		if (!root)
+		{
+			output += "#line 1 " + std::to_string(fileIndex) + "\n";
+		}
+		// the root file without a #version still needs the override and defines on top
+		else if (!startsWithVersion(source))
+		{
+			writeHeader(output, std::string(), versionWritten);
+			output += "#line 1 " + std::to_string(fileIndex) + "\n";
+		}
+
+		std::istringstream lines(source);
+		std::string line;
+		int lineNumber = 0;
+		bool inBlockComment = false;
+		while (std::getline(lines, line))
+		{
+			lineNumber++;
+			// a line inside a /* comment, e.g. a license header, is text even if it reads
+			// like a directive
+			std::string directive = inBlockComment ? std::string() : trimDirective(line);
+			inBlockComment = endsInBlockComment(line, inBlockComment);
+
+			if (directive.rfind("#version", 0) == 0)
+			{
+				// only the root file may declare the version, included copies are dropped
+				if (root && !versionWritten)
+				{
+					writeHeader(output, directive.substr(8), versionWritten);
+					output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+				}
+				else
+				{
+					output += "\n";
+				}
+			}
+			else if (directive.rfind("#pragma", 0) == 0 && directive.find("once") != std::string::npos)
+			{
+				onceFiles.push_back(path);
+				output += "\n";
+			}
+			else if (directive.rfind("#include", 0) == 0)
+			{
+				std::string includeName = parseIncludeName(directive);
+				if (includeName.empty())
+				{
+					std::cout << "ERROR::SHADER::INVALID_INCLUDE " << path << ":" << lineNumber << std::endl;
+					includeStack.pop_back();
+					return false;
+				}
+				std::filesystem::path includePath = std::filesystem::path(path).parent_path() / includeName;
+				if (!expand(includePath.lexically_normal().string(), output, files, includeStack, onceFiles, versionWritten))
+				{
+					includeStack.pop_back();
+					return false;
+				}
+				output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+			}
+			else
+			{
+				output += line;
+				output += "\n";
+			}
+		}
+
+		includeStack.pop_back();
+		return true;
+	}
+
+	void writeHeader(std::string& output, std::string originalVersion, bool& versionWritten) const
+	{
+		std::string versionString = version.empty() ? originalVersion : " " + version;
+		if (!versionString.empty())
+			output += "#version" + versionString + "\n";
+		for (const auto& define : defines)
+			output += "#define " + define.first + " " + define.second + "\n";
+		versionWritten = true;
+	}
+
+	// true when the first thing after comments and whitespace, such as a license header, is a
+	// #version directive. like every directive it has to start its line to be seen
+	static bool startsWithVersion(const std::string& source)
+	{
+		size_t i = 0;
+		while (i < source.size())
+		{
+			if (source.compare(i, 2, "//") == 0)
+				i = source.find('\n', i);
+			else if (source.compare(i, 2, "/*") == 0)
+			{
+				i = source.find("*/", i + 2);
+				if (i != std::string::npos)
+					i += 2;
+			}
+			else if (std::isspace((unsigned char)source[i]))
+				i++;
+			else
+			{
+				size_t lineStart = source.rfind('\n', i);
+				lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+				if (source.find_first_not_of(" \t\r", lineStart) != i)
+					return false;
+				return trimDirective(source.substr(lineStart, source.find('\n', i) - lineStart)).rfind("#version", 0) == 0;
+			}
+		}
+		return false;
+	}
+
+	// whether a /* comment is still open at the end of line, given whether one was at its start
+	static bool endsInBlockComment(const std::string& line, bool inComment)
+	{
+		for (size_t i = 0; i + 1 < line.size(); i++)
+		{
+			if (inComment)
+			{
+				if (line.compare(i, 2, "*/") == 0)
+				{
+					inComment = false;
+					i++;
+				}
+			}
+			else if (line.compare(i, 2, "//") == 0)
+				return false;
+			else if (line.compare(i, 2, "/*") == 0)
+			{
+				inComment = true;
+				i++;
+			}
+		}
+		return inComment;
+	}
+
+	// strips leading whitespace and the whitespace GLSL allows between '#' and the directive name
+	static std::string trimDirective(const std::string& line)
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos)
+			return std::string();
+		std::string trimmed = line.substr(start);
+		if (trimmed[0] == '#')
+		{
+			size_t name = trimmed.find_first_not_of(" \t", 1);
+			if (name != std::string::npos)
+				trimmed = "#" + trimmed.substr(name);
+		}
+		size_t end = trimmed.find_last_not_of(" \t\r");
+		return trimmed.substr(0, end + 1);
+	}
+
+	static std::string parseIncludeName(const std::string& directive)
+	{
+		size_t open = directive.find_first_of("\"<", 8);
+		if (open == std::string::npos)
+			return std::string();
+		char closeChar = directive[open] == '"' ? '"' : '>';
+		size_t close = directive.find(closeChar, open + 1);
+		if (close == std::string::npos)
+			return std::string();
+		return directive.substr(open + 1, close - open - 1);
+	}
+};
+
+#endif
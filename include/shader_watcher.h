@@ -0,0 +1,167 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <shader_preprocessor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/* Watches a vertex/fragment shader pair and the files they #include on a background thread
+   and reports through pollChanged() whenever one of them is saved, so the render loop never
+   waits on the disk. The caller rebuilds its programs, e.g. with ShaderPermutations::reload().
+   Uses inotify on Linux and falls back to polling modification times elsewhere.
+   On Linux only includes living in the same directories as the two root files are watched. */
+class ShaderWatcher
+{
+public:
+	ShaderWatcher(const char* vertexPath, const char* fragmentPath)
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), running(true)
+	{
+		// discover the initial #include set so edits to included files are picked up too
+		ShaderPreprocessor preprocessor;
+		std::vector<std::string> files;
+		preprocessor.process(this->vertexPath.string(), &files);
+		preprocessor.process(this->fragmentPath.string(), &files);
+		dependencies.assign(files.begin(), files.end());
+		watcherThread = std::thread(&ShaderWatcher::watch, this);
+	}
+
+	~ShaderWatcher()
+	{
+		running = false;
+		watcherThread.join();
+	}
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// returns true if the files changed since the last call
+	bool pollChanged()
+	{
+		return changed.exchange(false);
+	}
+
+private:
+	// editors often save in several steps (truncate, write, rename), so wait for writes to settle
+	static constexpr std::chrono::milliseconds SETTLE_TIME{ 50 };
+	static constexpr std::chrono::milliseconds POLL_INTERVAL{ 100 };
+
+	std::filesystem::path vertexPath;
+	std::filesystem::path fragmentPath;
+	std::atomic<bool> running;
+	std::atomic<bool> changed{ false };
+	// only touched by the watcher thread
+	std::vector<std::filesystem::path> dependencies;
+	std::thread watcherThread;
+
+	// the sources are only read for their #include set, which an edit may have changed
+	void readSources()
+	{
+		std::this_thread::sleep_for(SETTLE_TIME);
+		ShaderPreprocessor preprocessor;
+		std::vector<std::string> files;
+		bool vertexRead = !preprocessor.process(vertexPath.string(), &files).empty();
+		bool fragmentRead = !preprocessor.process(fragmentPath.string(), &files).empty();
+		// a file caught mid-save reads as empty; the next write event triggers another read
+		if (!vertexRead || !fragmentRead)
+			return;
+		dependencies.assign(files.begin(), files.end());
+		changed = true;
+	}
+
+#ifdef __linux__
+	void watch()
+	{
+		int fd = inotify_init1(IN_NONBLOCK);
+		if (fd < 0)
+		{
+			std::cout << "ERROR::SHADER_WATCHER::INOTIFY_INIT_FAILED" << std::endl;
+			return;
+		}
+		// watch the directories instead of the files so atomic rename-on-save is caught too
+		const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+		int vertexDir = inotify_add_watch(fd, vertexPath.parent_path().c_str(), mask);
+		int fragmentDir = vertexPath.parent_path() == fragmentPath.parent_path()
+			? vertexDir
+			: inotify_add_watch(fd, fragmentPath.parent_path().c_str(), mask);
+
+		alignas(inotify_event) char buffer[4096];
+		while (running)
+		{
+			pollfd pfd = { fd, POLLIN, 0 };
+			if (poll(&pfd, 1, (int)POLL_INTERVAL.count()) <= 0)
+				continue;
+
+			bool shaderChanged = false;
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len)
+				{
+					const inotify_event* event = (const inotify_event*)ptr;
+					if (event->len == 0)
+						continue;
+					// both directories are the same watch when the shaders share one
+					if (event->wd == vertexDir && isDependency(vertexPath.parent_path() / event->name))
+						shaderChanged = true;
+					else if (event->wd == fragmentDir && isDependency(fragmentPath.parent_path() / event->name))
+						shaderChanged = true;
+				}
+			}
+			if (shaderChanged)
+				readSources();
+		}
+		close(fd);
+	}
+
+	// compares whole paths, a file of the same name in another include directory is not one.
+	// the preprocessor records them lexically normal, relative to where the root paths are
+	bool isDependency(const std::filesystem::path& file) const
+	{
+		std::filesystem::path normal = file.lexically_normal();
+		return std::any_of(dependencies.begin(), dependencies.end(),
+			[&normal](const std::filesystem::path& dependency) { return dependency == normal; });
+	}
+#else
+	std::filesystem::file_time_type latestWriteTime() const
+	{
+		std::filesystem::file_time_type latest{};
+		for (const auto& dependency : dependencies)
+		{
+			std::error_code error;
+			auto time = std::filesystem::last_write_time(dependency, error);
+			if (!error && time > latest)
+				latest = time;
+		}
+		return latest;
+	}
+
+	void watch()
+	{
+		auto writeTime = latestWriteTime();
+		while (running)
+		{
+			std::this_thread::sleep_for(POLL_INTERVAL);
+			auto newWriteTime = latestWriteTime();
+			if (newWriteTime == writeTime)
+				continue;
+			writeTime = newWriteTime;
+			readSources();
+		}
+	}
+#endif
+};
+
+#endif
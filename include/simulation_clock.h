@@ -0,0 +1,52 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+/* Fixed timestep clock: real frame time is accumulated in double precision and consumed in
+   steps of exactly one timestep, so the simulation advances identically at any frame rate.
+   The leftover fraction of a step is exposed as an interpolation factor for rendering
+   between the previous and current simulation states. Simulated time is derived from the
+   integer step count, so it does not drift after hours of uptime. */
+class SimulationClock
+{
+public:
+	SimulationClock(double timestep, unsigned int maxStepsPerFrame)
+		: timestep(timestep), maxStepsPerFrame(maxStepsPerFrame)
+	{
+	}
+
+	// adds the real time that passed and returns how many steps to simulate this frame
+	unsigned int advance(double frameTime)
+	{
+		accumulator += frameTime;
+		unsigned int steps = 0;
+		while (accumulator >= timestep && steps < maxStepsPerFrame)
+		{
+			accumulator -= timestep;
+			steps++;
+		}
+		// after a stall, drop the time that could not be caught up instead of
+		// simulating ever more steps per frame
+		if (steps == maxStepsPerFrame && accumulator >= timestep)
+			accumulator = 0.0;
+		stepCount += steps;
+		return steps;
+	}
+
+	// how far the real time is between the last two simulation states, in [0, 1)
+	float getAlpha() const
+	{
+		return (float)(accumulator / timestep);
+	}
+
+	double getTimestep() const { return timestep; }
+	unsigned long long getStepCount() const { return stepCount; }
+	double getSimulationTime() const { return (double)stepCount * timestep; }
+
+private:
+	double timestep;
+	unsigned int maxStepsPerFrame;
+	double accumulator = 0.0;
+	unsigned long long stepCount = 0;
+};
+
+#endif
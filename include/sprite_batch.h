@@ -0,0 +1,242 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <shader.h>
+#include <stream_buffer.h>
+#include <vertex_layout.h>
+#include <vertex_quantizer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/* Per instance attributes of a sprite, 36 bytes */
+struct SpriteInstance
+{
+	glm::vec2 position; // center in pixels
+	glm::vec2 scale; // size in pixels, the plane quad is one unit wide
+	float rotation; // radians, counter-clockwise
+	float layer;
+	Unorm16x4 uvRect; // texture coordinates of the bottom left and top right corners
+	Unorm8x4 color; // multiplies the texture
+};
+
+using SpriteInstanceLayout = VertexLayout<SpriteInstance,
+	VERTEX_ATTRIBUTE(SpriteInstance, position),
+	VERTEX_ATTRIBUTE(SpriteInstance, scale),
+	VERTEX_ATTRIBUTE(SpriteInstance, rotation),
+	VERTEX_ATTRIBUTE(SpriteInstance, layer),
+	VERTEX_ATTRIBUTE(SpriteInstance, uvRect),
+	VERTEX_ATTRIBUTE(SpriteInstance, color)>;
+
+// first location after the plane quad's position, color and texture coordinates
+const unsigned int SPRITE_ATTRIBUTE_LOCATION = 3;
+
+/* 2D sprites in screen pixels, origin at the bottom left, for HUD and overlay content.
+   - every sprite is an instance of the plane quad from createPlaneVertexArrayObject, so a
+     sprite costs one 36 byte instance instead of four vertices
+   - flush() sorts the sprites by texture, then layer, copies them into a StreamBuffer and
+     draws each texture's run with one instanced glDrawElementsInstanced
+   - a frame with more sprites than maxSprites is drawn in chunks of maxSprites, each in the
+     next region of the StreamBuffer. A chunk whose region the GPU still reads waits for it,
+     so batches meant for hundreds of thousands of sprites are created with room for them
+   - layers are written as depth, which keeps higher layers on top across texture runs. Fully
+     transparent texels are discarded, but translucent ones only blend correctly over sprites
+     of the same texture or of a texture drawn earlier
+   Single threaded, submit and flush on the render thread. */
+class SpriteBatch
+{
+public:
+	static const size_t DEFAULT_MAX_SPRITES = 1 << 16;
+	static const unsigned int MAX_LAYER = 0xFFFF;
+
+	void create(unsigned int planeVAO, const char* vertexPath, const char* fragmentPath, size_t maxSprites = DEFAULT_MAX_SPRITES)
+	{
+		this->maxSprites = maxSprites;
+		VAO = planeVAO;
+		shader.reset(new Shader(vertexPath, fragmentPath));
+		shader->use();
+		shader->setInt("spriteTexture", 0);
+		buffer.create(maxSprites * sizeof(SpriteInstance));
+
+		// the instance stream joins the quad's vertices in its vertex array object
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.ID);
+		SpriteInstanceLayout::apply(SPRITE_ATTRIBUTE_LOCATION, 1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	// the plane quad's vertex array object stays with its creator
+	void destroy()
+	{
+		if (VAO == 0)
+			return;
+		buffer.destroy();
+		glDeleteProgram(shader->ID);
+		VAO = 0;
+	}
+
+	void draw(unsigned int texture, const glm::vec2& position, const glm::vec2& scale, float rotation = 0.0f,
+		const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), const glm::vec4& color = glm::vec4(1.0f), unsigned int layer = 0)
+	{
+		if (count == instances.size())
+		{
+			instances.resize(std::max<size_t>(1024, instances.size() * 2));
+			keys.resize(instances.size());
+		}
+		layer = std::min(layer, MAX_LAYER);
+		SpriteInstance& sprite = instances[count];
+		sprite.position = position;
+		sprite.scale = scale;
+		sprite.rotation = rotation;
+		sprite.layer = (float)layer;
+		sprite.uvRect = packUnorm16x4(uvRect);
+		sprite.color = packUnorm8x4(color);
+
+		uint32_t key = (textureSlot(texture) << 16) | layer;
+		if (count > 0 && key < keys[count - 1])
+			sorted = false;
+		keys[count++] = key;
+	}
+
+	/* Draws and clears everything submitted since the last flush over the bound framebuffer.
+	   Clears its depth buffer, which must exist for the layers to work */
+	void flush(int viewportWidth, int viewportHeight, bool reverseZ)
+	{
+		if (count == 0)
+			return;
+		// sprites submitted in texture and layer order skip the sort, the common case for HUDs
+		if (!sorted)
+			sortByKey();
+
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glDepthFunc(reverseZ ? GL_GEQUAL : GL_LEQUAL); // sprites on the same layer draw in order
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		shader->use();
+		glUniform2f(glGetUniformLocation(shader->ID, "viewportSize"), (float)viewportWidth, (float)viewportHeight);
+		glUniform1i(glGetUniformLocation(shader->ID, "reverseZ"), reverseZ);
+		glActiveTexture(GL_TEXTURE0);
+		glBindVertexArray(VAO);
+		for (size_t chunk = 0; chunk < count; chunk += maxSprites)
+			drawChunk(chunk, std::min(maxSprites, count - chunk));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		glDisable(GL_BLEND);
+		glDepthFunc(reverseZ ? GL_GREATER : GL_LESS);
+
+		count = 0;
+		sorted = true;
+		textures.clear();
+	}
+
+private:
+	size_t maxSprites = 0;
+	std::unique_ptr<Shader> shader;
+	StreamBuffer buffer;
+	unsigned int VAO = 0;
+
+	// only the first count entries are in use, the storage is kept between frames
+	std::vector<SpriteInstance> instances;
+	std::vector<uint32_t> keys; // texture slot in the high 16 bits, layer in the low
+	size_t count = 0;
+	bool sorted = true; // keys were submitted in ascending order
+	std::vector<unsigned int> textures; // slot to texture name, rebuilt every frame
+	std::vector<uint32_t> order; // sprite indices in key order
+	std::vector<uint32_t> scratch;
+
+	uint32_t textureSlot(unsigned int texture)
+	{
+		// sprites usually come in runs of one texture
+		if (!textures.empty() && textures.back() == texture)
+			return (uint32_t)textures.size() - 1;
+		for (size_t i = 0; i < textures.size(); i++)
+			if (textures[i] == texture)
+				return (uint32_t)i;
+		textures.push_back(texture);
+		return (uint32_t)textures.size() - 1;
+	}
+
+	uint32_t sortedKey(size_t i) const
+	{
+		return sorted ? keys[i] : keys[order[i]];
+	}
+
+	// the sprites from begin in key order, one draw per run sharing a texture
+	void drawChunk(size_t begin, size_t chunkCount)
+	{
+		SpriteInstance* destination = (SpriteInstance*)buffer.begin();
+		if (sorted)
+			std::memcpy(destination, instances.data() + begin, chunkCount * sizeof(SpriteInstance));
+		else
+		{
+			for (size_t i = 0; i < chunkCount; i++)
+				destination[i] = instances[order[begin + i]];
+		}
+		size_t baseOffset = buffer.end(chunkCount * sizeof(SpriteInstance));
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.ID);
+
+		size_t end = begin + chunkCount;
+		size_t first = begin;
+		while (first < end)
+		{
+			uint32_t slot = sortedKey(first) >> 16;
+			size_t last = first + 1;
+			while (last < end && sortedKey(last) >> 16 == slot)
+				last++;
+			glBindTexture(GL_TEXTURE_2D, textures[slot]);
+			// without base instance support the attributes are pointed at the run instead
+			SpriteInstanceLayout::apply(SPRITE_ATTRIBUTE_LOCATION, 1, baseOffset + (first - begin) * sizeof(SpriteInstance));
+			glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)(last - first));
+			first = last;
+		}
+		buffer.fence();
+	}
+
+	/* Stable LSD radix sort of the sprite indices, 8 bits of the key per pass. A pass where
+	   every key has the same digit changes nothing and is skipped, with a handful of textures
+	   and layers only one or two passes remain */
+	void sortByKey()
+	{
+		order.resize(count);
+		scratch.resize(count);
+		uint32_t histograms[4][256] = {};
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t key = keys[i];
+			order[i] = (uint32_t)i;
+			histograms[0][key & 0xFF]++;
+			histograms[1][(key >> 8) & 0xFF]++;
+			histograms[2][(key >> 16) & 0xFF]++;
+			histograms[3][key >> 24]++;
+		}
+
+		for (int pass = 0; pass < 4; pass++)
+		{
+			int shift = pass * 8;
+			uint32_t* histogram = histograms[pass];
+			if (histogram[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+			uint32_t offset = 0;
+			for (int digit = 0; digit < 256; digit++)
+			{
+				uint32_t digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t index = order[i];
+				scratch[histogram[(keys[index] >> shift) & 0xFF]++] = index;
+			}
+			order.swap(scratch);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef SPRITE_BENCHMARK_H
+#define SPRITE_BENCHMARK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <render_target.h>
+#include <sprite_batch.h>
+#include <timing.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/* Submits and draws SPRITE_COUNT sprites per frame through a SpriteBatch, offscreen:
+    - submit: the draw() calls of a frame, in texture and layer order or shuffled, which
+      makes flush() sort
+    - flush: sorting, copying into the stream buffer and issuing the draws on the CPU
+    - gpu: a GL_TIME_ELAPSED query around the flush
+   Both orders run with a batch sized for every sprite and with the default size, which
+   draws them in chunks. Every measurement is the fastest of FRAMES frames. createPlane must
+   return the plane quad's vertex array object, see SpriteBatch. */
+class SpriteBenchmark
+{
+public:
+	static const size_t SPRITE_COUNT = 500000;
+	static const int FRAMES = 10;
+	static const int WIDTH = 1280;
+	static const int HEIGHT = 720;
+	static const unsigned int TEXTURE_COUNT = 16;
+	static const unsigned int LAYER_COUNT = 8;
+
+	static void run(unsigned int (*createPlane)(), const char* vertexPath, const char* fragmentPath)
+	{
+		RenderTarget target;
+		if (!target.create(WIDTH, HEIGHT))
+			return;
+		target.bind();
+		glViewport(0, 0, WIDTH, HEIGHT);
+		glEnable(GL_DEPTH_TEST);
+		std::vector<unsigned int> textures(TEXTURE_COUNT);
+		for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+			textures[i] = createColorTexture(i);
+		std::vector<Sprite> sorted = createSprites(textures);
+		std::vector<Sprite> shuffled = sorted;
+		std::mt19937 random(1234);
+		std::shuffle(shuffled.begin(), shuffled.end(), random);
+		unsigned int query;
+		glGenQueries(1, &query);
+
+		std::cout << "SPRITE_BENCHMARK sprites: " << SPRITE_COUNT << " textures: " << TEXTURE_COUNT
+			<< " layers: " << LAYER_COUNT << " target: " << WIDTH << "x" << HEIGHT << std::endl;
+		size_t sizes[] = { SPRITE_COUNT, SpriteBatch::DEFAULT_MAX_SPRITES };
+		for (size_t maxSprites : sizes)
+		{
+			unsigned int VAO = createPlane();
+			SpriteBatch batch;
+			batch.create(VAO, vertexPath, fragmentPath, maxSprites);
+			Result inOrder = measure(batch, sorted, query);
+			Result anyOrder = measure(batch, shuffled, query);
+			batch.destroy();
+			glDeleteVertexArrays(1, &VAO);
+
+			std::cout << "  batch of " << maxSprites << " sprites, " << (SPRITE_COUNT + maxSprites - 1) / maxSprites << " chunk(s)" << std::endl;
+			std::cout << "    submit ms   sorted: " << inOrder.submit * 1000.0 << "  shuffled: " << anyOrder.submit * 1000.0 << std::endl;
+			std::cout << "    flush ms    sorted: " << inOrder.flush * 1000.0 << "  shuffled: " << anyOrder.flush * 1000.0 << std::endl;
+			std::cout << "    gpu ms      sorted: " << inOrder.gpu * 1000.0 << "  shuffled: " << anyOrder.gpu * 1000.0 << std::endl;
+		}
+
+		glDeleteQueries(1, &query);
+		glDeleteTextures((GLsizei)textures.size(), textures.data());
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		target.destroy();
+	}
+
+private:
+	struct Sprite
+	{
+		unsigned int texture;
+		glm::vec2 position;
+		glm::vec2 scale;
+		float rotation;
+		glm::vec4 color;
+		unsigned int layer;
+	};
+
+	struct Result
+	{
+		double submit = 1e9;
+		double flush = 1e9;
+		double gpu = 1e9;
+	};
+
+	static Result measure(SpriteBatch& batch, const std::vector<Sprite>& sprites, unsigned int query)
+	{
+		Result result;
+		for (int frame = 0; frame < FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			double start = getSteadyTime();
+			for (const Sprite& sprite : sprites)
+				batch.draw(sprite.texture, sprite.position, sprite.scale, sprite.rotation, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), sprite.color, sprite.layer);
+			double submitted = getSteadyTime();
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			batch.flush(WIDTH, HEIGHT, false);
+			glEndQuery(GL_TIME_ELAPSED);
+			double flushed = getSteadyTime();
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds); // waits for the frame
+			result.submit = std::min(result.submit, submitted - start);
+			result.flush = std::min(result.flush, flushed - submitted);
+			result.gpu = std::min(result.gpu, (double)nanoseconds * 1e-9);
+		}
+		return result;
+	}
+
+	// in texture and layer order, the order flush() draws them in
+	static std::vector<Sprite> createSprites(const std::vector<unsigned int>& textures)
+	{
+		// fixed seed so runs are comparable
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> x(0.0f, (float)WIDTH);
+		std::uniform_real_distribution<float> y(0.0f, (float)HEIGHT);
+		std::uniform_real_distribution<float> size(4.0f, 16.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<Sprite> sprites(SPRITE_COUNT);
+		for (size_t i = 0; i < SPRITE_COUNT; i++)
+		{
+			Sprite& sprite = sprites[i];
+			size_t run = i * TEXTURE_COUNT * LAYER_COUNT / SPRITE_COUNT;
+			sprite.texture = textures[run / LAYER_COUNT];
+			sprite.layer = (unsigned int)(run % LAYER_COUNT);
+			sprite.position = glm::vec2(x(random), y(random));
+			sprite.scale = glm::vec2(size(random), size(random));
+			sprite.rotation = angle(random);
+			sprite.color = glm::vec4(unit(random), unit(random), unit(random), 1.0f);
+		}
+		return sprites;
+	}
+
+	// 8x8 in a color of its own
+	static unsigned int createColorTexture(unsigned int index)
+	{
+		const int SIZE = 8;
+		unsigned char color[4] = { (unsigned char)(index * 97), (unsigned char)(index * 57 + 80), (unsigned char)(index * 31 + 160), 255 };
+		std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+			pixels[i] = color[i % 4];
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SIZE, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+};
+
+#endif
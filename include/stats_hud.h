@@ -0,0 +1,84 @@
+#ifndef STATS_HUD_H
+#define STATS_HUD_H
+
+#include <glm/glm.hpp>
+#include <render_stats.h>
+#include <sdf_font.h>
+#include <sprite_batch.h>
+#include <text_renderer.h>
+
+#include <algorithm>
+#include <cstdio>
+
+/* Overlay of RenderStats: a rolling graph of frame interval and GPU time, one pixel per frame,
+   and the counters of the last frame as text when a font is loaded. The graph is built from
+   sprites of a white texture, so the whole graph is a single sprite batch draw */
+class StatsHud
+{
+public:
+	static constexpr float GRAPH_HEIGHT = 64.0f;
+	static constexpr double GRAPH_RANGE = 1.0 / 30.0; // seconds at the top of the graph
+	static constexpr float TEXT_SIZE = 14.0f;
+
+	// topLeft in pixels from the bottom left of the viewport
+	void draw(const RenderStats& stats, SpriteBatch& sprites, unsigned int whiteTexture,
+		TextRenderer& text, const SdfFont& font, const glm::vec2& topLeft)
+	{
+		const float width = (float)RenderStats::HISTORY_SIZE;
+		glm::vec2 graphBottom(topLeft.x, topLeft.y - GRAPH_HEIGHT);
+		sprites.draw(whiteTexture, graphBottom + glm::vec2(width, GRAPH_HEIGHT) * 0.5f, glm::vec2(width, GRAPH_HEIGHT),
+			0.0f, FULL_RECT, glm::vec4(0.0f, 0.0f, 0.0f, 0.5f), 0);
+
+		// newest frame on the right
+		unsigned int historyCount = stats.getHistoryCount();
+		for (unsigned int i = 0; i < historyCount; i++)
+		{
+			const FrameStats& frame = stats.getFrame(i);
+			float x = graphBottom.x + width - 0.5f - (float)i;
+			bar(sprites, whiteTexture, x, graphBottom.y, frame.frameInterval, glm::vec4(0.3f, 0.8f, 0.3f, 0.8f), 1);
+			if (frame.gpuTime >= 0.0)
+				bar(sprites, whiteTexture, x, graphBottom.y, frame.gpuTime, glm::vec4(1.0f, 0.5f, 0.1f, 0.9f), 2);
+		}
+		// 60 Hz budget
+		float budgetY = graphBottom.y + (float)(GRAPH_HEIGHT * (1.0 / 60.0) / GRAPH_RANGE);
+		sprites.draw(whiteTexture, glm::vec2(graphBottom.x + width * 0.5f, budgetY), glm::vec2(width, 1.0f),
+			0.0f, FULL_RECT, glm::vec4(1.0f, 1.0f, 1.0f, 0.6f), 3);
+
+		if (!font.isLoaded() || historyCount == 0)
+			return;
+		const FrameStats& last = stats.getFrame(0);
+		const FrameCounters& counters = last.counters;
+		char line[128];
+		glm::vec2 position(topLeft.x, graphBottom.y - TEXT_SIZE * 1.2f);
+		std::snprintf(line, sizeof(line), "frame %.2f ms  cpu %.2f ms  gpu %.2f ms",
+			last.frameInterval * 1000.0, last.cpuTime * 1000.0, stats.getLastGpuTime() * 1000.0);
+		textLine(text, font, line, position);
+		std::snprintf(line, sizeof(line), "draws %u  instances %llu  triangles %llu",
+			counters.drawCalls, (unsigned long long)counters.instances, (unsigned long long)counters.triangles);
+		textLine(text, font, line, position);
+		std::snprintf(line, sizeof(line), "binds  program %u  vao %u  texture %u",
+			counters.programBinds, counters.vertexArrayBinds, counters.textureBinds);
+		textLine(text, font, line, position);
+		std::snprintf(line, sizeof(line), "upload  buffer %.1f KB  texture %.1f KB",
+			counters.bufferUploadBytes / 1024.0, counters.textureUploadBytes / 1024.0);
+		textLine(text, font, line, position);
+	}
+
+private:
+	static inline const glm::vec4 FULL_RECT = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	static void bar(SpriteBatch& sprites, unsigned int whiteTexture, float x, float bottom, double seconds, const glm::vec4& color, unsigned int layer)
+	{
+		float height = (float)(GRAPH_HEIGHT * std::min(seconds / GRAPH_RANGE, 1.0));
+		if (height > 0.0f)
+			sprites.draw(whiteTexture, glm::vec2(x, bottom + height * 0.5f), glm::vec2(1.0f, height), 0.0f, FULL_RECT, color, layer);
+	}
+
+	static void textLine(TextRenderer& text, const SdfFont& font, const char* line, glm::vec2& position)
+	{
+		text.drawText(font, line, position, TEXT_SIZE, glm::vec4(1.0f));
+		position.y -= TEXT_SIZE * 1.2f;
+	}
+};
+
+#endif
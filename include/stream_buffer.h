@@ -0,0 +1,129 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include <render_stats.h>
+
+#include <cstddef>
+#include <vector>
+
+/* A vertex buffer whose contents are rewritten every frame.
+   - with OpenGL 4.4 the buffer is persistently mapped and split into REGION_COUNT regions of
+     capacity bytes. Each region is guarded by a fence, so the CPU writes straight into
+     memory the GPU reads without overwriting data of a frame still in flight
+   - otherwise writes go to a CPU copy that end() uploads into orphaned storage
+   Usage per frame: begin(), write up to capacity bytes, end(), draw, fence(). */
+class StreamBuffer
+{
+public:
+	static const unsigned int REGION_COUNT = 3;
+
+	unsigned int ID = 0;
+
+	void create(size_t capacity)
+	{
+		this->capacity = capacity;
+		persistent = GLAD_GL_VERSION_4_4;
+		glGenBuffers(1, &ID);
+		glBindBuffer(GL_ARRAY_BUFFER, ID);
+		if (persistent)
+		{
+			// coherent mapping, writes become visible to the GPU without explicit flushes
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, REGION_COUNT * capacity, NULL, flags);
+			mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, REGION_COUNT * capacity, flags);
+		}
+		else
+		{
+			glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+			staging.resize(capacity);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void destroy()
+	{
+		if (ID == 0)
+			return;
+		for (GLsync& fence : fences)
+		{
+			if (fence != 0)
+				glDeleteSync(fence);
+			fence = 0;
+		}
+		if (mapped != NULL)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, ID);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			mapped = NULL;
+		}
+		glDeleteBuffers(1, &ID);
+		ID = 0;
+	}
+
+	size_t getCapacity() const
+	{
+		return capacity;
+	}
+
+	bool isPersistent() const
+	{
+		return persistent;
+	}
+
+	// capacity writable bytes, valid until end()
+	void* begin()
+	{
+		if (!persistent)
+			return staging.data();
+		// the region was last used REGION_COUNT frames ago, wait until the GPU is done with it
+		GLsync& fence = fences[region];
+		if (fence != 0)
+		{
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+			glDeleteSync(fence);
+			fence = 0;
+		}
+		return mapped + region * capacity;
+	}
+
+	// makes the first size bytes written since begin() available to draws and returns their
+	// offset in the buffer
+	size_t end(size_t size)
+	{
+		if (persistent)
+		{
+			// no GL call sees these bytes, count them here
+			RenderStats::counters().bufferUploadBytes += size;
+			return region * capacity;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, ID);
+		glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+		if (size > 0)
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, staging.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return 0;
+	}
+
+	// after the draws reading the data, the region is reused once the GPU has passed them
+	void fence()
+	{
+		if (!persistent)
+			return;
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region = (region + 1) % REGION_COUNT;
+	}
+
+private:
+	static constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+
+	size_t capacity = 0;
+	bool persistent = false;
+	unsigned char* mapped = NULL;
+	std::vector<unsigned char> staging;
+	GLsync fences[REGION_COUNT] = {};
+	unsigned int region = 0;
+};
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <camera_path.h>
+#include <regression_benchmark.h>
+#include <transform.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Parameters of a generated benchmark scene, parsed from "key=value,key=value,...":
+    count         objects, from 100 up to 10^7
+    distribution  uniform | clustered | grid | city
+    meshes        distinct meshes, see BenchmarkScene
+    textures      distinct textures
+    shaders       distinct shader programs
+    materials     distinct (program, texture) pairs the objects pick from, 0 lets every
+                  object pick its program and texture on its own
+    animated      fraction of the objects spinning every frame
+    depth         depth complexity: how many objects a ray through the scene crosses on
+                  average, which sets the object size
+    instanced     1 draws each mesh with one instanced draw
+    sort          1 sorts the visible objects by state every frame
+    seed, name    the name defaults to stress_<distribution>_<count> */
+struct StressSceneConfig
+{
+	enum Distribution { DISTRIBUTION_UNIFORM, DISTRIBUTION_CLUSTERED, DISTRIBUTION_GRID, DISTRIBUTION_CITY };
+
+	static constexpr double MIN_COUNT = 100.0;
+	static constexpr double MAX_COUNT = 1e7;
+
+	std::string name;
+	size_t count = 10000;
+	Distribution distribution = DISTRIBUTION_UNIFORM;
+	unsigned int meshCount = 1;
+	unsigned int textureCount = 1;
+	unsigned int shaderCount = 1;
+	unsigned int materialCount = 0;
+	float animatedFraction = 0.1f;
+	float depthComplexity = 2.0f;
+	bool instanced = false;
+	bool sortDraws = false;
+	unsigned int seed = 1234;
+
+	bool parse(const std::string& spec)
+	{
+		std::istringstream options(spec);
+		std::string option;
+		while (std::getline(options, option, ','))
+		{
+			size_t separator = option.find('=');
+			if (separator == std::string::npos)
+			{
+				std::cout << "ERROR::STRESS_SCENE::INVALID_OPTION " << option << std::endl;
+				return false;
+			}
+			std::string key = option.substr(0, separator);
+			std::string value = option.substr(separator + 1);
+			if (key == "count")
+			{
+				// parsed as a double to accept 1e6, and checked before the conversion, which is
+				// undefined for values a size_t cannot hold. NaN fails both comparisons
+				double parsed = std::strtod(value.c_str(), NULL);
+				if (!(parsed >= MIN_COUNT && parsed <= MAX_COUNT))
+				{
+					std::cout << "ERROR::STRESS_SCENE::COUNT_OUT_OF_RANGE " << option << ", must be from 100 up to 10^7" << std::endl;
+					return false;
+				}
+				count = (size_t)parsed;
+			}
+			else if (key == "distribution" && value == "uniform")
+				distribution = DISTRIBUTION_UNIFORM;
+			else if (key == "distribution" && value == "clustered")
+				distribution = DISTRIBUTION_CLUSTERED;
+			else if (key == "distribution" && value == "grid")
+				distribution = DISTRIBUTION_GRID;
+			else if (key == "distribution" && value == "city")
+				distribution = DISTRIBUTION_CITY;
+			else if (key == "meshes")
+				meshCount = (unsigned int)std::max(std::atoi(value.c_str()), 1);
+			else if (key == "textures")
+				textureCount = (unsigned int)std::max(std::atoi(value.c_str()), 1);
+			else if (key == "shaders")
+				shaderCount = (unsigned int)std::max(std::atoi(value.c_str()), 1);
+			else if (key == "materials")
+				materialCount = (unsigned int)std::max(std::atoi(value.c_str()), 0);
+			else if (key == "animated")
+				animatedFraction = std::min(std::max((float)std::atof(value.c_str()), 0.0f), 1.0f);
+			else if (key == "depth")
+				depthComplexity = std::max((float)std::atof(value.c_str()), 0.01f);
+			else if (key == "instanced")
+				instanced = value == "1";
+			else if (key == "sort")
+				sortDraws = value == "1";
+			else if (key == "seed")
+				seed = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+			else if (key == "name")
+				name = value;
+			else
+			{
+				std::cout << "ERROR::STRESS_SCENE::INVALID_OPTION " << option << std::endl;
+				return false;
+			}
+		}
+		if (name.empty())
+		{
+			const char* distributions[] = { "uniform", "clustered", "grid", "city" };
+			name = std::string("stress_") + distributions[distribution] + "_" + std::to_string(count);
+		}
+		return true;
+	}
+};
+
+/* Builds benchmark scenes from a StressSceneConfig. The volume distributions fill a cube
+   whose size grows with the cube root of the count, so the density stays the same from
+   10^2 to 10^7 objects, and size the objects so that a ray crosses depthComplexity of them
+   on average: count objects with a projected area a in a volume of side L are crossed
+   count * a / L^2 times. a is s^2 for the axis aligned cubes of the grid and 1.5 s^2 for
+   randomly rotated ones (a quarter of the surface, by Cauchy's formula). The city is a grid
+   of lots on the ground with buildings of stacked floors, whose footprint sets how many
+   buildings a ray along a street row crosses. Everything comes from one
+   seeded generator, the same config always gives the same scene. */
+class StressSceneGenerator
+{
+public:
+	static BenchmarkScene generate(const StressSceneConfig& config)
+	{
+		std::mt19937 random(config.seed);
+		BenchmarkScene scene;
+		scene.name = config.name;
+		scene.instanced = config.instanced;
+		scene.sortDraws = config.sortDraws;
+		scene.meshCount = config.meshCount;
+		scene.textureCount = config.textureCount;
+		scene.shaderCount = config.shaderCount;
+
+		float extent; // half the size of the scene
+		glm::vec3 center(0.0f);
+		if (config.distribution == StressSceneConfig::DISTRIBUTION_CITY)
+			extent = generateCity(config, random, scene.objects, center);
+		else
+			extent = generateVolume(config, random, scene.objects);
+		// the spinning objects are the first ones, spread them over the scene
+		std::shuffle(scene.objects.begin(), scene.objects.end(), random);
+		scene.animatedCount = (size_t)(config.animatedFraction * scene.objects.size());
+
+		assignStates(config, random, scene);
+		scene.path = CameraPath::orbit(center, 1.6f * extent, 0.4f * extent, 90.0f, RegressionBenchmark::PATH_DURATION);
+		scene.farPlane = 5.0f * extent;
+		return scene;
+	}
+
+private:
+	// returns the half extent of the scene
+	static float generateVolume(const StressSceneConfig& config, std::mt19937& random, std::vector<Transform>& objects)
+	{
+		size_t count = config.count;
+		float extent = 2.0f * std::cbrt((float)count);
+		bool rotated = config.distribution != StressSceneConfig::DISTRIBUTION_GRID;
+		float size = 2.0f * extent * std::sqrt(config.depthComplexity / ((rotated ? 1.5f : 1.0f) * (float)count));
+		std::uniform_real_distribution<float> coordinate(-extent, extent);
+		std::normal_distribution<float> component(0.0f, 1.0f);
+		objects.resize(count);
+
+		if (config.distribution == StressSceneConfig::DISTRIBUTION_GRID)
+		{
+			size_t side = (size_t)std::ceil(std::cbrt((double)count));
+			float spacing = 2.0f * extent / (float)side;
+			for (size_t i = 0; i < count; i++)
+			{
+				glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / (side * side)));
+				objects[i].position = (cell + 0.5f) * spacing - extent;
+				objects[i].scale = glm::vec3(size);
+			}
+			return extent;
+		}
+
+		// a cluster per cube root of the count, each a gaussian around a uniform center
+		std::vector<glm::vec3> clusters;
+		float spread = 0.0f;
+		if (config.distribution == StressSceneConfig::DISTRIBUTION_CLUSTERED)
+		{
+			clusters.resize(std::max((size_t)std::cbrt((double)count), (size_t)1));
+			for (glm::vec3& cluster : clusters)
+				cluster = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+			spread = 0.25f * extent / std::cbrt((float)clusters.size());
+		}
+		std::uniform_int_distribution<size_t> pickCluster(0, clusters.empty() ? 0 : clusters.size() - 1);
+		for (Transform& object : objects)
+		{
+			if (clusters.empty())
+				object.position = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+			else
+				object.position = clusters[pickCluster(random)] + spread * glm::vec3(component(random), component(random), component(random));
+			object.rotation = glm::normalize(glm::quat(component(random), component(random), component(random), component(random)));
+			object.scale = glm::vec3(size);
+		}
+		return extent;
+	}
+
+	// buildings on a square grid of lots, floors drawn from a geometric distribution
+	static float generateCity(const StressSceneConfig& config, std::mt19937& random, std::vector<Transform>& objects, glm::vec3& center)
+	{
+		const float MEAN_FLOORS = 8.0f;
+		const unsigned int MAX_FLOORS = 60;
+		const float SPACING = 4.0f; // lot to lot, the rest of a lot is street
+		const float FLOOR_HEIGHT = 1.0f;
+		size_t lots = std::max((size_t)((float)config.count / MEAN_FLOORS), (size_t)1);
+		size_t side = (size_t)std::ceil(std::sqrt((double)lots));
+		// a ray along a row of lots crosses side * size / SPACING buildings
+		float size = std::min(SPACING * config.depthComplexity / (float)side, 0.9f * SPACING);
+		float extent = 0.5f * SPACING * (float)side;
+		std::geometric_distribution<unsigned int> floors(1.0f / MEAN_FLOORS);
+
+		objects.clear();
+		objects.reserve(config.count);
+		std::vector<unsigned int> lotFloors(side * side, 0);
+		unsigned int tallest = 1;
+		for (size_t lot = 0; objects.size() < config.count; lot = (lot + 1) % lotFloors.size())
+		{
+			// when the lots run out before the count, later passes build on top
+			unsigned int height = std::min(floors(random) + 1, MAX_FLOORS);
+			glm::vec3 base(((float)(lot % side) + 0.5f) * SPACING - extent, 0.0f, ((float)(lot / side) + 0.5f) * SPACING - extent);
+			for (unsigned int floor = 0; floor < height && objects.size() < config.count; floor++)
+			{
+				Transform object;
+				object.position = base + glm::vec3(0.0f, (lotFloors[lot] + 0.5f) * FLOOR_HEIGHT, 0.0f);
+				object.scale = glm::vec3(size, FLOOR_HEIGHT, size);
+				objects.push_back(object);
+				lotFloors[lot]++;
+			}
+			tallest = std::max(tallest, lotFloors[lot]);
+		}
+		center = glm::vec3(0.0f, 0.5f * tallest * FLOOR_HEIGHT, 0.0f);
+		return extent;
+	}
+
+	static void assignStates(const StressSceneConfig& config, std::mt19937& random, BenchmarkScene& scene)
+	{
+		size_t count = scene.objects.size();
+		std::uniform_int_distribution<unsigned int> mesh(0, config.meshCount - 1);
+		std::uniform_int_distribution<unsigned int> texture(0, config.textureCount - 1);
+		std::uniform_int_distribution<unsigned int> shader(0, config.shaderCount - 1);
+		if (config.meshCount > 1)
+		{
+			scene.meshes.resize(count);
+			for (unsigned int& value : scene.meshes)
+				value = mesh(random);
+		}
+		if (config.instanced)
+			return;
+
+		// a material fixes the program and texture pair, objects share a few of them
+		std::vector<glm::uvec2> materials(config.materialCount);
+		for (glm::uvec2& material : materials)
+			material = glm::uvec2(shader(random), texture(random));
+		std::uniform_int_distribution<unsigned int> material(0, std::max(config.materialCount, 1u) - 1);
+		scene.shaders.resize(count);
+		scene.textures.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::uvec2 state = materials.empty() ? glm::uvec2(shader(random), texture(random)) : materials[material(random)];
+			scene.shaders[i] = state.x;
+			scene.textures[i] = state.y;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sdf_font.h>
+#include <shader.h>
+#include <stream_buffer.h>
+#include <vertex_layout.h>
+#include <vertex_quantizer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/* Per instance attributes of a glyph quad, 28 bytes */
+struct GlyphInstance
+{
+	glm::vec2 position; // center in pixels
+	glm::vec2 scale; // size in pixels
+	Unorm16x4 uvRect;
+	Unorm8x4 color;
+};
+
+using GlyphInstanceLayout = VertexLayout<GlyphInstance,
+	VERTEX_ATTRIBUTE(GlyphInstance, position),
+	VERTEX_ATTRIBUTE(GlyphInstance, scale),
+	VERTEX_ATTRIBUTE(GlyphInstance, uvRect),
+	VERTEX_ATTRIBUTE(GlyphInstance, color)>;
+
+// first location after the plane quad's position, color and texture coordinates
+const unsigned int GLYPH_ATTRIBUTE_LOCATION = 3;
+
+/* Glyphs of a string laid out once. Drawing a run copies its instances without looking at
+   the text again, for labels that stay the same from frame to frame */
+struct TextRun
+{
+	const SdfFont* font = NULL;
+	std::vector<GlyphInstance> glyphs;
+};
+
+/* Signed distance field text in screen pixels, origin at the bottom left. Glyphs are
+   instances of the plane quad like sprites, collected per font and drawn with one instanced
+   draw per font from a StreamBuffer on top of everything else.
+   Single threaded, submit and flush on the render thread. */
+class TextRenderer
+{
+public:
+	static const size_t MAX_GLYPHS = 1 << 16; // per frame over all fonts
+
+	void create(unsigned int planeVAO, const char* vertexPath, const char* fragmentPath)
+	{
+		VAO = planeVAO;
+		shader.reset(new Shader(vertexPath, fragmentPath));
+		shader->use();
+		shader->setInt("fontAtlas", 0);
+		buffer.create(MAX_GLYPHS * sizeof(GlyphInstance));
+
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.ID);
+		GlyphInstanceLayout::apply(GLYPH_ATTRIBUTE_LOCATION, 1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	// the plane quad's vertex array object stays with its creator
+	void destroy()
+	{
+		if (VAO == 0)
+			return;
+		buffer.destroy();
+		glDeleteProgram(shader->ID);
+		VAO = 0;
+	}
+
+	/* Appends the glyphs of text with the first baseline starting at position. size is the
+	   text height in pixels, '\n' starts a new line below */
+	static void layoutText(const SdfFont& font, const char* text, const glm::vec2& position, float size, const glm::vec4& color,
+		std::vector<GlyphInstance>& glyphs)
+	{
+		float scale = size / font.getPixelHeight();
+		Unorm8x4 packedColor = packUnorm8x4(color);
+		glm::vec2 pen = position;
+		for (const char* character = text; *character != '\0'; character++)
+		{
+			if (*character == '\n')
+			{
+				pen.x = position.x;
+				pen.y -= font.getLineHeight() * scale;
+				continue;
+			}
+			const SdfFont::Glyph& glyph = font.getGlyph((unsigned char)*character);
+			if (glyph.size.x > 0.0f)
+			{
+				GlyphInstance instance;
+				instance.scale = glyph.size * scale;
+				instance.position = pen + glyph.offset * scale + instance.scale * 0.5f;
+				instance.uvRect = glyph.uvRect;
+				instance.color = packedColor;
+				glyphs.push_back(instance);
+			}
+			pen.x += glyph.advance * scale;
+		}
+	}
+
+	static TextRun layoutRun(const SdfFont& font, const char* text, const glm::vec2& position, float size, const glm::vec4& color)
+	{
+		TextRun run;
+		run.font = &font;
+		layoutText(font, text, position, size, color, run.glyphs);
+		return run;
+	}
+
+	// text that changes every frame, laid out on the spot
+	void drawText(const SdfFont& font, const char* text, const glm::vec2& position, float size, const glm::vec4& color)
+	{
+		layoutText(font, text, position, size, color, batchFor(font));
+	}
+
+	void drawRun(const TextRun& run)
+	{
+		if (run.font == NULL || run.glyphs.empty())
+			return;
+		std::vector<GlyphInstance>& glyphs = batchFor(*run.font);
+		glyphs.insert(glyphs.end(), run.glyphs.begin(), run.glyphs.end());
+	}
+
+	/* Draws and clears everything submitted since the last flush over the bound framebuffer */
+	void flush(int viewportWidth, int viewportHeight)
+	{
+		GlyphInstance* destination = (GlyphInstance*)buffer.begin();
+		size_t glyphCount = 0;
+		size_t dropped = 0;
+		for (FontBatch& batch : batches)
+		{
+			size_t count = std::min(batch.glyphs.size(), MAX_GLYPHS - glyphCount);
+			std::memcpy(destination + glyphCount, batch.glyphs.data(), count * sizeof(GlyphInstance));
+			batch.first = glyphCount;
+			batch.count = count;
+			glyphCount += count;
+			dropped += batch.glyphs.size() - count;
+			batch.glyphs.clear();
+		}
+		if (dropped > 0)
+			std::cout << "ERROR::TEXT_RENDERER::BUFFER_FULL dropped " << dropped << " glyphs" << std::endl;
+		if (glyphCount == 0)
+			return;
+		size_t baseOffset = buffer.end(glyphCount * sizeof(GlyphInstance));
+
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		shader->use();
+		glUniform2f(glGetUniformLocation(shader->ID, "viewportSize"), (float)viewportWidth, (float)viewportHeight);
+		glActiveTexture(GL_TEXTURE0);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.ID);
+		for (const FontBatch& batch : batches)
+		{
+			if (batch.count == 0)
+				continue;
+			glBindTexture(GL_TEXTURE_2D, batch.font->Texture);
+			GlyphInstanceLayout::apply(GLYPH_ATTRIBUTE_LOCATION, 1, baseOffset + batch.first * sizeof(GlyphInstance));
+			glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)batch.count);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+		buffer.fence();
+	}
+
+private:
+	struct FontBatch
+	{
+		const SdfFont* font;
+		std::vector<GlyphInstance> glyphs; // cleared by every flush, keeps its capacity
+		size_t first;
+		size_t count;
+	};
+
+	std::unique_ptr<Shader> shader;
+	StreamBuffer buffer;
+	unsigned int VAO = 0;
+	std::vector<FontBatch> batches; // one per font ever drawn with
+
+	std::vector<GlyphInstance>& batchFor(const SdfFont& font)
+	{
+		for (FontBatch& batch : batches)
+			if (batch.font == &font)
+				return batch.glyphs;
+		batches.push_back({ &font, {}, 0, 0 });
+		return batches.back().glyphs;
+	}
+};
+
+#endif
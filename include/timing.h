@@ -0,0 +1,14 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+
+/* Seconds since the first call as a double on a monotonic clock. Replaces float
+   glfwGetTime() differences, which lose precision after hours of uptime. */
+inline double getSteadyTime()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/* Position, rotation and scale of a scene object. Kept separate from the model matrix so two
+   simulation states can be blended: positions and scales lerp, rotations slerp. */
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+
+	// order of operations is inverse, first scale, then rotate, then translate
+	glm::mat4 toMatrix() const
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		model *= glm::mat4_cast(rotation);
+		return glm::scale(model, scale);
+	}
+
+	static Transform interpolate(const Transform& from, const Transform& to, float alpha)
+	{
+		Transform result;
+		result.position = glm::mix(from.position, to.position, alpha);
+		result.rotation = glm::slerp(from.rotation, to.rotation, alpha);
+		result.scale = glm::mix(from.scale, to.scale, alpha);
+		return result;
+	}
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/* Compressed attribute storage types, filled by the functions in vertex_quantizer.h */
+struct Half2 { uint16_t x, y; };
+struct Half4 { uint16_t x, y, z, w; };
+struct Snorm8x4 { int8_t x, y, z, w; };
+struct Unorm8x4 { uint8_t x, y, z, w; };
+struct Snorm16x2 { int16_t x, y; };
+struct Unorm16x4 { uint16_t x, y, z, w; };
+// four signed normalized components in 10, 10, 10 and 2 bits, x in the lowest bits
+struct Int2_10_10_10 { uint32_t bits; };
+// the same with unsigned normalized components
+struct Uint2_10_10_10 { uint32_t bits; };
+
+/* How the vertex fetch reads a C++ attribute type. Types without a specialization do not
+   compile when used in a layout */
+template <typename Type> struct VertexFormat;
+
+template <GLint Components, GLenum Type, GLboolean Normalized, bool Integer = false>
+struct VertexFormatTraits
+{
+	static constexpr GLint COMPONENTS = Components;
+	static constexpr GLenum TYPE = Type;
+	static constexpr GLboolean NORMALIZED = Normalized;
+	// integer attributes reach the shader as ints instead of being converted to float
+	static constexpr bool INTEGER = Integer;
+};
+
+template <> struct VertexFormat<float> : VertexFormatTraits<1, GL_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<glm::vec2> : VertexFormatTraits<2, GL_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<glm::vec3> : VertexFormatTraits<3, GL_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<glm::vec4> : VertexFormatTraits<4, GL_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<Half2> : VertexFormatTraits<2, GL_HALF_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<Half4> : VertexFormatTraits<4, GL_HALF_FLOAT, GL_FALSE> {};
+template <> struct VertexFormat<Snorm8x4> : VertexFormatTraits<4, GL_BYTE, GL_TRUE> {};
+template <> struct VertexFormat<Unorm8x4> : VertexFormatTraits<4, GL_UNSIGNED_BYTE, GL_TRUE> {};
+template <> struct VertexFormat<Snorm16x2> : VertexFormatTraits<2, GL_SHORT, GL_TRUE> {};
+template <> struct VertexFormat<Unorm16x4> : VertexFormatTraits<4, GL_UNSIGNED_SHORT, GL_TRUE> {};
+template <> struct VertexFormat<Int2_10_10_10> : VertexFormatTraits<4, GL_INT_2_10_10_10_REV, GL_TRUE> {};
+template <> struct VertexFormat<Uint2_10_10_10> : VertexFormatTraits<4, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE> {};
+template <> struct VertexFormat<uint32_t> : VertexFormatTraits<1, GL_UNSIGNED_INT, GL_FALSE, true> {};
+
+/* One member of a vertex struct, use the VERTEX_ATTRIBUTE macro to declare it */
+template <typename Type, size_t Offset>
+struct VertexAttribute
+{
+	using Format = VertexFormat<Type>;
+	static constexpr size_t OFFSET = Offset;
+	static constexpr size_t SIZE = sizeof(Type);
+	static_assert(Offset % 4 == 0, "vertex attributes must start on a 4 byte boundary");
+
+	static void apply(GLuint location, GLsizei stride, GLuint divisor, size_t baseOffset)
+	{
+		if (Format::INTEGER)
+			glVertexAttribIPointer(location, Format::COMPONENTS, Format::TYPE, stride, (void*)(baseOffset + OFFSET));
+		else
+			glVertexAttribPointer(location, Format::COMPONENTS, Format::TYPE, Format::NORMALIZED, stride, (void*)(baseOffset + OFFSET));
+		glEnableVertexAttribArray(location);
+		if (divisor != 0)
+			glVertexAttribDivisor(location, divisor);
+	}
+};
+
+#define VERTEX_ATTRIBUTE(Vertex, member) VertexAttribute<decltype(Vertex::member), offsetof(Vertex, member)>
+
+// true if no two attributes overlap and all lie inside the vertex
+template <typename Vertex, typename... Attributes>
+constexpr bool vertexAttributesFit()
+{
+	size_t offsets[] = { Attributes::OFFSET... };
+	size_t sizes[] = { Attributes::SIZE... };
+	for (size_t i = 0; i < sizeof...(Attributes); i++)
+	{
+		if (offsets[i] + sizes[i] > sizeof(Vertex))
+			return false;
+		for (size_t j = 0; j < sizeof...(Attributes); j++)
+			if (i != j && offsets[i] < offsets[j] + sizes[j] && offsets[j] < offsets[i] + sizes[i])
+				return false;
+	}
+	return true;
+}
+
+/* Attribute formats, offsets and stride of a vertex struct, all derived at compile time.
+   Attributes are listed in shader location order, e.g.
+
+     struct Vertex { glm::vec3 position; Half2 texCoord; };
+     using VertexLayout_ = VertexLayout<Vertex, VERTEX_ATTRIBUTE(Vertex, position), VERTEX_ATTRIBUTE(Vertex, texCoord)>;
+
+   Overlapping attributes or attributes reaching past the end of the struct fail to compile. */
+template <typename VertexType, typename... Attributes>
+struct VertexLayout
+{
+	using Vertex = VertexType;
+	static constexpr GLsizei STRIDE = (GLsizei)sizeof(Vertex);
+	static constexpr unsigned int ATTRIBUTE_COUNT = sizeof...(Attributes);
+
+	static_assert(ATTRIBUTE_COUNT > 0, "a vertex layout needs at least one attribute");
+	static_assert(STRIDE % 4 == 0, "the vertex stride must be a multiple of 4 bytes");
+	static_assert(vertexAttributesFit<Vertex, Attributes...>(), "vertex attributes overlap or do not fit in the vertex");
+
+	// configures the bound vertex array object to read the bound GL_ARRAY_BUFFER, one
+	// attribute per location starting at firstLocation. a divisor makes them per instance,
+	// baseOffset is where the first vertex starts in the buffer
+	static void apply(GLuint firstLocation = 0, GLuint divisor = 0, size_t baseOffset = 0)
+	{
+		GLuint location = firstLocation;
+		(Attributes::apply(location++, STRIDE, divisor, baseOffset), ...);
+	}
+};
+
+/* Uploads vertices (and indices when given) into new buffers and returns a vertex array
+   object reading them with the layout */
+template <typename Layout>
+unsigned int createVertexArrayObject(const typename Layout::Vertex* vertices, size_t vertexCount,
+	const unsigned int* indices = NULL, size_t indexCount = 0)
+{
+	unsigned int VBO, VAO;
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(typename Layout::Vertex), vertices, GL_STATIC_DRAW);
+	if (indices != NULL)
+	{
+		unsigned int EBO;
+		glGenBuffers(1, &EBO);
+		// the element buffer binding is stored in the vertex array object
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	}
+	Layout::apply();
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind, the attributes keep their buffer
+	glBindVertexArray(0);
+	return VAO;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef VERTEX_QUANTIZER_H
+#define VERTEX_QUANTIZER_H
+
+#include <vertex_layout.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* Conversions from float vertex data to the compressed formats of vertex_layout.h.
+   Shaders decode octahedral normals with octDecode from src/shaders/vertex_decode.glsl,
+   every other format is expanded by the vertex fetch. */
+
+// IEEE half precision with round to nearest even. overflow becomes infinity
+inline uint16_t packHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000u;
+	bits &= 0x7FFFFFFFu;
+
+	uint16_t half;
+	if (bits >= 0x47800000u) // 65536 and above, infinity or NaN
+		half = (uint16_t)(bits > 0x7F800000u ? 0x7E00u : 0x7C00u);
+	else if (bits < 0x38800000u) // below the smallest normal half, 2^-14
+	{
+		// adding a magic number lets the float unit do the denormal rounding
+		const uint32_t magicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+		float magic, absolute;
+		std::memcpy(&magic, &magicBits, sizeof(magic));
+		std::memcpy(&absolute, &bits, sizeof(absolute));
+		absolute += magic;
+		std::memcpy(&bits, &absolute, sizeof(bits));
+		half = (uint16_t)(bits - magicBits);
+	}
+	else
+	{
+		uint32_t mantissaOdd = (bits >> 13) & 1u;
+		bits += ((uint32_t)(15 - 127) << 23) + 0xFFFu; // rebias the exponent and round
+		bits += mantissaOdd;
+		half = (uint16_t)(bits >> 13);
+	}
+	return (uint16_t)(half | sign);
+}
+
+inline float unpackHalf(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+	uint32_t exponent = (half >> 10) & 0x1Fu;
+	uint32_t mantissa = half & 0x3FFu;
+	float value;
+	if (exponent == 0)
+		value = std::ldexp((float)mantissa, -24);
+	else if (exponent == 31)
+		value = mantissa == 0 ? INFINITY : NAN;
+	else
+		value = std::ldexp((float)(mantissa | 0x400u), (int)exponent - 25);
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	bits |= sign;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+inline Half2 packHalf2(const glm::vec2& value)
+{
+	return { packHalf(value.x), packHalf(value.y) };
+}
+
+inline Half4 packHalf4(const glm::vec4& value)
+{
+	return { packHalf(value.x), packHalf(value.y), packHalf(value.z), packHalf(value.w) };
+}
+
+// value in [-1, 1] to a signed normalized integer with bits bits
+inline int32_t quantizeSnorm(float value, int bits)
+{
+	float maximum = (float)((1 << (bits - 1)) - 1);
+	return (int32_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * maximum);
+}
+
+inline Snorm8x4 packSnorm8x4(const glm::vec4& value)
+{
+	return { (int8_t)quantizeSnorm(value.x, 8), (int8_t)quantizeSnorm(value.y, 8),
+		(int8_t)quantizeSnorm(value.z, 8), (int8_t)quantizeSnorm(value.w, 8) };
+}
+
+// colors and other [0, 1] values
+inline Unorm8x4 packUnorm8x4(const glm::vec4& value)
+{
+	glm::vec4 scaled = glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return { (uint8_t)scaled.x, (uint8_t)scaled.y, (uint8_t)scaled.z, (uint8_t)scaled.w };
+}
+
+// texture coordinate rectangles and other [0, 1] values needing more than 8 bits
+inline Unorm16x4 packUnorm16x4(const glm::vec4& value)
+{
+	glm::vec4 scaled = glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f;
+	return { (uint16_t)scaled.x, (uint16_t)scaled.y, (uint16_t)scaled.z, (uint16_t)scaled.w };
+}
+
+// w only has the values -1, 0 and 1, enough for a tangent's handedness
+inline Int2_10_10_10 packInt2_10_10_10(const glm::vec4& value)
+{
+	uint32_t x = (uint32_t)quantizeSnorm(value.x, 10) & 0x3FFu;
+	uint32_t y = (uint32_t)quantizeSnorm(value.y, 10) & 0x3FFu;
+	uint32_t z = (uint32_t)quantizeSnorm(value.z, 10) & 0x3FFu;
+	uint32_t w = (uint32_t)quantizeSnorm(value.w, 2) & 0x3u;
+	return { x | (y << 10) | (z << 20) | (w << 30) };
+}
+
+/* Octahedral encoding of a unit vector: the octahedron |x| + |y| + |z| = 1 is unfolded onto
+   the [-1, 1] square, which spreads the precision evenly over the sphere. Two 16 bit
+   components give an error far below what lighting can show */
+inline glm::vec2 octEncode(const glm::vec3& normal)
+{
+	glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+	glm::vec2 encoded(n.x, n.y);
+	if (n.z < 0.0f)
+	{
+		// fold the lower half over the diagonals
+		encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return encoded;
+}
+
+// CPU mirror of octDecode in vertex_decode.glsl
+inline glm::vec3 octDecode(const glm::vec2& encoded)
+{
+	glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+	float fold = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -fold : fold;
+	n.y += n.y >= 0.0f ? -fold : fold;
+	return glm::normalize(n);
+}
+
+inline Snorm16x2 packOctahedral(const glm::vec3& normal)
+{
+	glm::vec2 encoded = octEncode(normal);
+	return { (int16_t)quantizeSnorm(encoded.x, 16), (int16_t)quantizeSnorm(encoded.y, 16) };
+}
+
+/* Full precision vertex as produced by a mesh loader, 48 bytes */
+struct MeshVertex
+{
+	glm::vec3 position;
+	glm::vec2 texCoord;
+	glm::vec3 normal;
+	glm::vec4 tangent; // w is the bitangent sign
+};
+
+/* The same vertex in 20 bytes:
+    - half float position, w is always 1. Precision is 1/1024 of the coordinate's magnitude,
+      so meshes should be authored around their origin
+    - half float texture coordinates, exact for atlases up to 2048 texels
+    - octahedral normal in two 16 bit components
+    - tangent in 10:10:10 with the handedness in the 2 bit field */
+struct QuantizedVertex
+{
+	Half4 position;
+	Half2 texCoord;
+	Snorm16x2 normal;
+	Int2_10_10_10 tangent;
+};
+
+using MeshVertexLayout = VertexLayout<MeshVertex,
+	VERTEX_ATTRIBUTE(MeshVertex, position),
+	VERTEX_ATTRIBUTE(MeshVertex, texCoord),
+	VERTEX_ATTRIBUTE(MeshVertex, normal),
+	VERTEX_ATTRIBUTE(MeshVertex, tangent)>;
+
+using QuantizedVertexLayout = VertexLayout<QuantizedVertex,
+	VERTEX_ATTRIBUTE(QuantizedVertex, position),
+	VERTEX_ATTRIBUTE(QuantizedVertex, texCoord),
+	VERTEX_ATTRIBUTE(QuantizedVertex, normal),
+	VERTEX_ATTRIBUTE(QuantizedVertex, tangent)>;
+
+static_assert(sizeof(QuantizedVertex) * 2 < sizeof(MeshVertex), "quantized vertices should be less than half the size");
+
+inline QuantizedVertex quantizeVertex(const MeshVertex& vertex)
+{
+	QuantizedVertex quantized;
+	quantized.position = packHalf4(glm::vec4(vertex.position, 1.0f));
+	quantized.texCoord = packHalf2(vertex.texCoord);
+	quantized.normal = packOctahedral(vertex.normal);
+	quantized.tangent = packInt2_10_10_10(vertex.tangent);
+	return quantized;
+}
+
+inline std::vector<QuantizedVertex> quantizeVertices(const std::vector<MeshVertex>& vertices)
+{
+	std::vector<QuantizedVertex> quantized(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+		quantized[i] = quantizeVertex(vertices[i]);
+	return quantized;
+}
+
+#endif
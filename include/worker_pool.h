@@ -0,0 +1,193 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Makes threadCount threads wait for each other, as often as needed. Only for tasks of one
+   WorkerPool::run, whose threads are known to run at the same time */
+class WorkerBarrier
+{
+public:
+	explicit WorkerBarrier(size_t threadCount)
+		: threadCount(threadCount)
+	{
+	}
+
+	// returns once every thread has called it for this round
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		uint64_t round = rounds;
+		if (++arrived == threadCount)
+		{
+			arrived = 0;
+			rounds++;
+			lock.unlock();
+			released.notify_all();
+			return;
+		}
+		released.wait(lock, [&]() { return rounds != round; });
+	}
+
+private:
+	size_t threadCount;
+	size_t arrived = 0;
+	uint64_t rounds = 0;
+	std::mutex mutex;
+	std::condition_variable released;
+};
+
+/* Threads started once and reused by every parallel loop, so splitting a frame's work
+   neither starts threads nor allocates. A dispatch writes each worker's thread index into
+   its preallocated job slot and wakes them; the calling thread takes the last index itself.
+   One dispatch runs at a time, and a loop started from inside a job runs inline on that
+   job's thread. */
+class WorkerPool
+{
+public:
+	// shared by the whole application, started by the first call
+	static WorkerPool& shared()
+	{
+		static WorkerPool pool(std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+		return pool;
+	}
+
+	explicit WorkerPool(size_t workerCount)
+		: slots(workerCount, NO_JOB)
+	{
+		workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; i++)
+			workers.emplace_back(&WorkerPool::workerMain, this, i);
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		jobReady.notify_all();
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// the workers and the calling thread
+	size_t getThreadCount() const
+	{
+		return workers.size() + 1;
+	}
+
+	// threads for count items when none gets fewer than minBatchSize, 1 inside a job
+	size_t threadsFor(size_t count, size_t minBatchSize) const
+	{
+		if (insideJob)
+			return 1;
+		return std::min(getThreadCount(), std::max<size_t>(count / std::max<size_t>(minBatchSize, 1), 1));
+	}
+
+	/* Calls task(thread) for every thread in [0, threadCount) and returns once all are done.
+	   With threadCount from threadsFor() the calls run at the same time, so they may wait
+	   for each other */
+	template <typename Task>
+	void run(size_t threadCount, Task task)
+	{
+		threadCount = std::min(threadCount, getThreadCount());
+		if (threadCount <= 1 || insideJob)
+		{
+			for (size_t thread = 0; thread < threadCount; thread++)
+				task(thread);
+			return;
+		}
+
+		std::lock_guard<std::mutex> dispatch(dispatchMutex);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job.function = [](void* context, size_t thread) { (*static_cast<Task*>(context))(thread); };
+			job.context = &task;
+			for (size_t i = 0; i < slots.size(); i++)
+				slots[i] = i + 1 < threadCount ? i : NO_JOB;
+			pending = threadCount - 1;
+			generation++;
+		}
+		jobReady.notify_all();
+
+		insideJob = true;
+		task(threadCount - 1);
+		insideJob = false;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		jobDone.wait(lock, [this]() { return pending == 0; });
+	}
+
+	// splits [0, count) into contiguous ranges and calls body(begin, end) for each. small
+	// loops run inline since waking the workers costs more than the work
+	template <typename Body>
+	void parallelFor(size_t count, size_t minBatchSize, Body body)
+	{
+		size_t threadCount = threadsFor(count, minBatchSize);
+		if (threadCount <= 1)
+		{
+			body(size_t(0), count);
+			return;
+		}
+		size_t batchSize = (count + threadCount - 1) / threadCount;
+		run(threadCount, [&](size_t thread) {
+			body(std::min(count, thread * batchSize), std::min(count, (thread + 1) * batchSize));
+		});
+	}
+
+private:
+	static constexpr size_t NO_JOB = ~size_t(0);
+
+	struct Job
+	{
+		void (*function)(void* context, size_t thread) = nullptr;
+		void* context = nullptr;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<size_t> slots; // per worker, its thread index in the current job or NO_JOB
+	Job job;
+	uint64_t generation = 0; // of the current job, workers run each one once
+	size_t pending = 0; // workers still running the current job
+	bool quit = false;
+	std::mutex mutex;
+	std::mutex dispatchMutex; // held by the thread whose job is running
+	std::condition_variable jobReady;
+	std::condition_variable jobDone;
+	static inline thread_local bool insideJob = false;
+
+	void workerMain(size_t index)
+	{
+		uint64_t finished = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			jobReady.wait(lock, [&]() { return quit || generation != finished; });
+			if (quit)
+				return;
+			finished = generation;
+			if (slots[index] == NO_JOB)
+				continue;
+			Job current = job;
+			size_t thread = slots[index];
+			lock.unlock();
+			insideJob = true;
+			current.function(current.context, thread);
+			insideJob = false;
+			lock.lock();
+			if (--pending == 0)
+				jobDone.notify_one();
+		}
+	}
+};
+
+#endif
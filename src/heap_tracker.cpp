@@ -0,0 +1,268 @@
+#include <heap_tracker.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <dbghelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#elif defined(__GLIBC__)
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+/* Replaces the global operator new and delete with ones that count into HeapTracker. Every
+   block carries a header with its size and tag in front of the memory handed out, so delete
+   knows what it gives back and to which tag. Over-aligned new and delete keep the library's
+   own versions and are not counted */
+struct HeapTrackerHooks
+{
+	// keeps the memory after it aligned like malloc's
+	struct alignas(16) Header
+	{
+		uint64_t size;
+		int tag;
+	};
+
+	static void raisePeak(std::atomic<uint64_t>& peak, uint64_t value)
+	{
+		uint64_t current = peak.load(std::memory_order_relaxed);
+		while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// block is size bytes plus the header
+	static void* track(void* block, size_t size)
+	{
+		int tag = HeapTracker::threadTag;
+		Header* header = (Header*)block;
+		header->size = size;
+		header->tag = tag;
+
+		HeapTracker::TagStats& stats = HeapTracker::tags[tag];
+		stats.allocations.fetch_add(1, std::memory_order_relaxed);
+		stats.bytes.fetch_add(size, std::memory_order_relaxed);
+		raisePeak(stats.peakBytes, stats.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+		raisePeak(HeapTracker::peakBytes, HeapTracker::liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+		if ((stats.flags & HeapTracker::TAG_EXEMPT) == 0)
+		{
+			HeapTracker::threadTotals.allocations++;
+			HeapTracker::threadTotals.bytes += size;
+			if (HeapTracker::captureCallSites)
+				recordCallSite(tag, size);
+		}
+		return header + 1;
+	}
+
+	static void untrack(const Header& header)
+	{
+		HeapTracker::tags[header.tag].liveBytes.fetch_sub(header.size, std::memory_order_relaxed);
+		HeapTracker::liveBytes.fetch_sub(header.size, std::memory_order_relaxed);
+	}
+
+	static Header* getHeader(void* pointer)
+	{
+		return (Header*)pointer - 1;
+	}
+
+	static void* allocateOrThrow(size_t size)
+	{
+		while (true)
+		{
+			void* block = std::malloc(size + sizeof(Header));
+			if (block != NULL)
+				return track(block, size);
+			std::new_handler handler = std::get_new_handler();
+			if (handler == NULL)
+				throw std::bad_alloc();
+			handler();
+		}
+	}
+
+	static void release(void* pointer)
+	{
+		if (pointer == NULL)
+			return;
+		Header* header = getHeader(pointer);
+		untrack(*header);
+		std::free(header);
+	}
+
+	static int captureStack(void** frames, int depth)
+	{
+#if defined(_WIN32)
+		return CaptureStackBackTrace(0, (DWORD)depth, frames, NULL);
+#elif defined(__GLIBC__)
+		return backtrace(frames, depth);
+#else
+		(void)frames;
+		(void)depth;
+		return 0;
+#endif
+	}
+
+	static void recordCallSite(int tag, size_t size)
+	{
+		// capturing the stack may allocate itself
+		HeapTracker::captureCallSites = false;
+		HeapTracker::CallSite site;
+		site.depth = captureStack(site.frames, HeapTracker::CALL_STACK_DEPTH);
+		{
+			std::lock_guard<std::mutex> guard(HeapTracker::callSiteMutex);
+			HeapTracker::CallSite* target = NULL;
+			for (int i = 0; i < HeapTracker::callSiteCount && target == NULL; i++)
+			{
+				HeapTracker::CallSite& existing = HeapTracker::callSites[i];
+				if (existing.depth == site.depth && std::memcmp(existing.frames, site.frames, site.depth * sizeof(void*)) == 0)
+					target = &existing;
+			}
+			if (target == NULL && HeapTracker::callSiteCount < HeapTracker::MAX_CALL_SITES)
+			{
+				target = &HeapTracker::callSites[HeapTracker::callSiteCount++];
+				*target = site;
+				target->tag = tag;
+				target->allocations = 0;
+				target->bytes = 0;
+			}
+			if (target != NULL)
+			{
+				target->allocations++;
+				target->bytes += size;
+			}
+			else
+				HeapTracker::droppedCallSites++;
+		}
+		HeapTracker::captureCallSites = true;
+	}
+
+	static void printFrames(void* const* frames, int depth)
+	{
+#if defined(_WIN32)
+		HANDLE process = GetCurrentProcess();
+		static bool symbolsLoaded = SymInitialize(process, NULL, TRUE) != FALSE;
+		for (int i = 0; i < depth; i++)
+		{
+			char buffer[sizeof(SYMBOL_INFO) + 256] = {};
+			SYMBOL_INFO* symbol = (SYMBOL_INFO*)buffer;
+			symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+			symbol->MaxNameLen = 255;
+			IMAGEHLP_LINE64 line = {};
+			line.SizeOfStruct = sizeof(line);
+			DWORD displacement = 0;
+			DWORD64 address = (DWORD64)frames[i];
+			if (!symbolsLoaded || !SymFromAddr(process, address, NULL, symbol))
+				std::printf("    %p\n", frames[i]);
+			else if (SymGetLineFromAddr64(process, address, &displacement, &line))
+				std::printf("    %s %s:%lu\n", symbol->Name, line.FileName, line.LineNumber);
+			else
+				std::printf("    %s\n", symbol->Name);
+		}
+#elif defined(__GLIBC__)
+		// writes straight to the descriptor without allocating
+		std::fflush(stdout);
+		backtrace_symbols_fd(frames, depth, STDOUT_FILENO);
+#else
+		for (int i = 0; i < depth; i++)
+			std::printf("    %p\n", frames[i]);
+#endif
+	}
+};
+
+void* HeapTracker::allocate(size_t size)
+{
+	void* block = std::malloc(size + sizeof(HeapTrackerHooks::Header));
+	return block != NULL ? HeapTrackerHooks::track(block, size) : NULL;
+}
+
+void* HeapTracker::reallocate(void* pointer, size_t size)
+{
+	if (pointer == NULL)
+		return allocate(size);
+	// the old block stays valid and counted when realloc fails
+	HeapTrackerHooks::Header old = *HeapTrackerHooks::getHeader(pointer);
+	void* block = std::realloc(HeapTrackerHooks::getHeader(pointer), size + sizeof(HeapTrackerHooks::Header));
+	if (block == NULL)
+		return NULL;
+	HeapTrackerHooks::untrack(old);
+	return HeapTrackerHooks::track(block, size);
+}
+
+void HeapTracker::release(void* pointer)
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void HeapTracker::printCallSites()
+{
+	std::lock_guard<std::mutex> guard(callSiteMutex);
+	if (callSiteCount == 0)
+		return;
+	int order[MAX_CALL_SITES];
+	for (int i = 0; i < callSiteCount; i++)
+		order[i] = i;
+	std::sort(order, order + callSiteCount, [](int a, int b) { return callSites[a].allocations > callSites[b].allocations; });
+	std::cout << std::flush;
+	for (int i = 0; i < callSiteCount; i++)
+	{
+		const CallSite& site = callSites[order[i]];
+		std::printf("HEAP_TRACKER call site %d: %llu allocations, %llu bytes, tag %s\n", i,
+			(unsigned long long)site.allocations, (unsigned long long)site.bytes, getTagName(site.tag));
+		HeapTrackerHooks::printFrames(site.frames, site.depth);
+	}
+	if (droppedCallSites > 0)
+		std::printf("HEAP_TRACKER %llu more allocations from other call sites\n", (unsigned long long)droppedCallSites);
+	std::fflush(stdout);
+}
+
+void* operator new(size_t size)
+{
+	return HeapTrackerHooks::allocateOrThrow(size);
+}
+
+void* operator new[](size_t size)
+{
+	return HeapTrackerHooks::allocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return HeapTracker::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return HeapTracker::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	HeapTrackerHooks::release(pointer);
+}
@@ -2,31 +2,173 @@
 #include <glad/glad.h> // must be included before glfw
 #include <GLFW/glfw3.h>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <stb_image.h>
 #include <shader.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <camera.h>
+#include <shader_watcher.h>
+#include <shader_permutations.h>
+#include <render_target.h>
+#include <render_state.h>
+#include <frame_pipeline.h>
+#include <frame_pacer.h>
+#include <timing.h>
+#include <simulation_clock.h>
+#include <transform.h>
+#include <aabb_tree.h>
+#include <occlusion_culler.h>
+#include <hiz_culler.h>
+#include <instancing.h>
+#include <vertex_layout.h>
+#include <vertex_quantizer.h>
+#include <instance_benchmark.h>
+#include <sprite_benchmark.h>
+#include <debug_draw.h>
+#include <sprite_batch.h>
+#include <sdf_font.h>
+#include <text_renderer.h>
+#include <render_stats.h>
+#include <gl_debug_output.h>
+#include <gl_trace_recorder.h>
+#include <null_gl.h>
+#include <stats_hud.h>
+#include <performance_report.h>
+#include <perf_counters.h>
+#include <heap_tracker.h>
+#include <camera_path.h>
+#include <benchmark_baseline.h>
+#include <regression_benchmark.h>
+#include <stress_scene.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
 
 const unsigned int OPENGL_CLIENT_API_VERSION = 3; // minimal version of openGL the client must use.
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 const char* VERTEX_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/shader.vs";
 const char* FRAGMENT_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/shader.fs";
+const char* INSTANCED_MATRIX_VERTEX_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/shader_instanced_matrix.vs";
+const char* OCCLUSION_CULL_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/occlusion_cull.comp";
+const char* HIZ_DOWNSAMPLE_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/hiz_downsample.comp";
+const char* DEBUG_DRAW_VERTEX_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/debug_draw.vs";
+const char* DEBUG_DRAW_FRAGMENT_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/debug_draw.fs";
+const char* SPRITE_VERTEX_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/sprite.vs";
+const char* SPRITE_FRAGMENT_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/sprite.fs";
+const char* SDF_TEXT_VERTEX_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/sdf_text.vs";
+const char* SDF_TEXT_FRAGMENT_SHADER_PATH = "C:/Projects/VS2019/LearnOpenGL_2/src/shaders/sdf_text.fs";
 const char* CONTAINER_IMG_PATH = "C:/Projects/VS2019/LearnOpenGL_2/assets/container.jpg";
 const char* FACE_IMG_PATH = "C:/Projects/VS2019/LearnOpenGL_2/assets/awesomeface.png";
+// DejaVu Sans baked with src/tools/sdf_font_baker.cpp, the HUD shows no text without it
+const char* HUD_FONT_PATH = "C:/Projects/VS2019/LearnOpenGL_2/assets/fonts/hud.sdffont";
+const unsigned int MAX_QUEUED_FRAMES = 1; // finished frames allowed to wait for the render thread
+const unsigned int MAX_FRAMES_IN_FLIGHT = 2; // frames the GPU may lag behind the render thread
+const double TARGET_FRAME_RATE = 0.0; // frames per second, 0 leaves pacing to vsync
+const double SIMULATION_TIMESTEP = 1.0 / 60.0; // seconds, independent of the frame rate
+const unsigned int MAX_SIMULATION_STEPS = 8; // per frame, bounds the catch-up after a stall
+const bool OCCLUSION_CULLING = true; // skip cubes hidden behind other cubes, tested on the CPU
+const size_t MAX_OCCLUDERS = 512; // cubes the CPU test rasterizes per frame, the largest on screen
+const bool GPU_OCCLUSION_CULLING = true; // test on the GPU instead when OpenGL 4.3 is available
+const bool PACKED_INSTANCING = true; // one instanced draw with 20 byte instances instead of a draw per cube
+const bool RENDER_STATS = true; // count draws, binds and uploads for the HUD
+const double PERFORMANCE_REPORT_WINDOW = 5.0; // seconds of frames per --perf-report entry
+const double HITCH_THRESHOLD = 2.0 / 60.0; // a frame longer than two 60 Hz frames is a hitch
+const unsigned int CAPTURE_FRAME = 60; // frames before --capture-frame records one, shaders and caches are warm by then
+const unsigned int ALLOCATION_WARM_UP_FRAMES = 300; // frames allowed to allocate, the HUD graph grows for RenderStats::HISTORY_SIZE of them
+#ifdef _DEBUG
+const bool GL_DEBUG_BUILD = true; // debug context with synchronous KHR_debug messages
+#else
+const bool GL_DEBUG_BUILD = false; // --gl-debug collects the messages asynchronously
+#endif
 
 bool firstMouse = true;
 float lastX = 800.0f / 2.0;  // last X mouse position (scr_height / 2 = middleX)
 float lastY = 800.0f / 2.0;  // last Y mouse position (scr_width / 2 = middleY)
 
 // timing
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+double deltaTime = 0.0;
+double lastFrame = 0.0;
 
 Camera camera;
 
+// the scene is drawn offscreen to get a 32-bit float depth buffer
+RenderTarget sceneTarget;
+bool reverseZ = false;
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+// decided before the render thread starts, read only afterwards
+bool gpuOcclusionCulling = false;
+
+// lines can be added from any thread, the render thread draws them on top of the scene
+DebugDraw debugDraw;
+bool showBounds = false; // B toggles the bounding boxes of the visible cubes
+bool boundsKeyDown = false;
+// HUD and overlay sprites and text, render thread only
+SpriteBatch spriteBatch;
+TextRenderer textRenderer;
+SdfFont hudFont;
+TextRun hudTitle; // laid out once
+RenderStats renderStats;
+StatsHud statsHud;
+// driver errors and performance warnings of the whole run, reported at exit
+GLDebugOutput glDebugOutput;
+
+// timing percentiles written with --perf-report, NULL without. created before the render thread
+std::unique_ptr<PerformanceReport> performanceReport;
+struct PerformanceSeries
+{
+	int frame;
+	int simulation;
+	int pipelineWait; // the simulation thread blocked on a full pipeline
+	int buildState;
+	int renderCpu;
+	int gpu;
+} performanceSeries;
+
+// --perf-counters <file.csv> counts hardware events per frame phase, NULL without. a thread
+// only counts itself, so the simulation and render threads have a PerfCounters each
+const char* perfCountersFile = NULL;
+PerfCounters simulationCounters("simulation");
+PerfCounters renderCounters("render");
+struct CounterPhases
+{
+	int input = -1;
+	int transformUpdate = -1;
+	int culling = -1;
+	int pack = -1;
+	int submission = -1;
+} counterPhases;
+
+// HeapTracker tags of the subsystems, the frame phases above are tags of their own
+struct MemoryTags
+{
+	int shaders;
+	int textures;
+	int meshes;
+	int hud;
+	int debugDraw;
+	int scene;
+	int shaderReload; // exempt, a reload allocates in whichever frame an edit lands
+	int cameraPath; // exempt, a recording grows every frame
+} memoryTags;
+// frames of each thread that allocate after the warm up, reported at exit
+FrameAllocations simulationAllocations("simulation", ALLOCATION_WARM_UP_FRAMES);
+FrameAllocations renderAllocations("render", ALLOCATION_WARM_UP_FRAMES);
+
+// --capture-frame <file> writes the GL calls of frame CAPTURE_FRAME for src/tools/gl_trace_replay.cpp
+const char* traceCaptureFile = NULL;
+
+// --record-path <file> saves the camera of every frame, --play-path <file> flies it again
+CameraPath cameraPath;
+const char* cameraPathRecordFile = NULL;
+bool cameraPathPlaying = false; // live input leaves the camera alone while a path plays
+
 void setupGlfw()
 {
 	// initialize glfw
@@ -38,11 +180,44 @@ void setupGlfw()
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 }
 
-/* Callback that initializes the viewport with correct size on every window resize */
+/* Callback that records the framebuffer size on every window resize. The viewport itself
+   is updated by the render thread, which owns the GL context */
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	int xPos = 0;
-	int yPos = 0;
-	glViewport(xPos, yPos, width, height);
+	// minimized windows report a 0x0 framebuffer
+	if (width > 0 && height > 0)
+	{
+		camera.SetAspectRatio((float)width / (float)height);
+		framebufferWidth = width;
+		framebufferHeight = height;
+	}
+}
+
+// names the scene target's objects for frame captures, it is recreated on every resize
+void labelSceneTarget()
+{
+	GLDebugOutput::label(GL_FRAMEBUFFER, sceneTarget.FBO, "scene target");
+	GLDebugOutput::label(GL_TEXTURE, sceneTarget.ColorTexture, "scene color");
+	GLDebugOutput::label(GL_TEXTURE, sceneTarget.DepthTexture, "scene depth");
+}
+
+/* Switches to a reverse-Z infinite projection with a float depth buffer when glClipControl
+   is available (OpenGL 4.5), otherwise keeps the default depth setup */
+bool setupReverseZ()
+{
+	if (!GLAD_GL_VERSION_4_5)
+	{
+		std::cout << "OpenGL 4.5 not available, using standard depth" << std::endl;
+		return false;
+	}
+	if (!sceneTarget.create(framebufferWidth, framebufferHeight))
+		return false;
+	labelSceneTarget();
+	// map clip space depth to [0, 1] instead of [-1, 1] so no precision is lost around 0
+	glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+	glClearDepth(0.0f); // far away is 0 now
+	glDepthFunc(GL_GREATER);
+	camera.SetProjectionMode(Projection_Mode::REVERSE_Z_INFINITE);
+	return true;
 }
 
 /* Callback that is called every frame with the current mouse position on the window */
@@ -77,62 +252,51 @@ void processInput(GLFWwindow* window)
 	{
 		glfwSetWindowShouldClose(window, true);
 	}
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		camera.ProcessKeyboard(Camera_Movement::FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		camera.ProcessKeyboard(Camera_Movement::BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		camera.ProcessKeyboard(Camera_Movement::LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		camera.ProcessKeyboard(Camera_Movement::RIGHT, deltaTime);
+	if (!cameraPathPlaying)
+	{
+		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+			camera.ProcessKeyboard(Camera_Movement::FORWARD, (float)deltaTime);
+		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+			camera.ProcessKeyboard(Camera_Movement::BACKWARD, (float)deltaTime);
+		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+			camera.ProcessKeyboard(Camera_Movement::LEFT, (float)deltaTime);
+		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+			camera.ProcessKeyboard(Camera_Movement::RIGHT, (float)deltaTime);
+	}
+
+	// toggle once per press, not every frame the key is held
+	bool boundsKey = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+	if (boundsKey && !boundsKeyDown)
+		showBounds = !showBounds;
+	boundsKeyDown = boundsKey;
 }
 
+struct PlaneVertex
+{
+	glm::vec3 position;
+	glm::vec3 color;
+	glm::vec2 texCoord;
+};
+using PlaneVertexLayout = VertexLayout<PlaneVertex,
+	VERTEX_ATTRIBUTE(PlaneVertex, position), // location 0
+	VERTEX_ATTRIBUTE(PlaneVertex, color), // location 1
+	VERTEX_ATTRIBUTE(PlaneVertex, texCoord)>; // location 2
+
 unsigned int createPlaneVertexArrayObject()
 {
-	float vertices[] = {
-	//    x      y		z      r      g      b
-		 0.5f,  0.5f,  0.0f,   1.0f,  0.0f,  0.0f,   1.0f,  1.0f, // 0 top right
-		 0.5f, -0.5f,  0.0f,   0.0f,  1.0f,  0.0f,   1.0f,  0.0f, // 1 bottom right
-		-0.5f, -0.5f,  0.0f,   0.0f,  0.0f,  1.0f,   0.0f,  0.0f, // 2 bottom left
-		-0.5f,  0.5f,  0.0f,   1.0f,  1.0f,  0.0f,   0.0f,  1.0f  // 3 top left
+	PlaneVertex vertices[] = {
+	//    x      y      z          r      g      b          u      v
+		{ {  0.5f,  0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } }, // 0 top right
+		{ {  0.5f, -0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f } }, // 1 bottom right
+		{ { -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } }, // 2 bottom left
+		{ { -0.5f,  0.5f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f } }  // 3 top left
 	};
 	unsigned int indices[] = {
         0, 1, 3, // first triangle
         1, 2, 3  // second triangle
 	};
-	
-	unsigned int VBO, VAO, EBO; // vertex buffer, element buffer and array objects
-	glGenVertexArrays(1, &VAO); // create vertex arrays and assign memory location to VAO
-	glGenBuffers(1, &VBO); // create buffer and assign memory location to VBO
-	glGenBuffers(1, &EBO); // create buffer and assign memory location to VBO
-	glBindVertexArray(VAO); // bind array object
-	glBindBuffer(GL_ARRAY_BUFFER, VBO); // bind buffer to OpenGL Array buffer location
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // copy vertices to bound buffer
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); // bind buffer to OpenGL Element Array buffer location
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-	
-	glVertexAttribPointer(
-		0, // location of the vertex attribute being configured (see vertexShaderSource)
-		3, // this attribute is composed of 3 values
-		GL_FLOAT, // type of data of vertex coordinates
-		GL_FALSE, // no need to normalize the data
-		8 * sizeof(float), // memory space of a vertex (stride)
-		(void*)0 // offset in bytes of where this attribute begins in buffer
-	);
-	// enable vertex attributes at location 0 (disabled by default)
-	glEnableVertexAttribArray(0);
-
-	// set color attributes pointer (location = 1) and enable
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	// set texture attributes pointer (location = 2) and enable
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind, since glVertexAttribPointer registered VBO as the vertex attribute pointer
-	glBindVertexArray(0); // unbind, same as above for VAO
-	return VAO;
+	// strides and offsets come from the PlaneVertex layout
+	return createVertexArrayObject<PlaneVertexLayout>(vertices, 4, indices, 6);
 }
 
 
@@ -183,6 +347,19 @@ unsigned int generateTexture(const char* path, int colorFormat)
 	return texture;
 }
 
+// 1x1 opaque white, lets the sprite batch draw flat colored rectangles
+unsigned int createWhiteTexture()
+{
+	unsigned int texture;
+	unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	return texture;
+}
+
 void rotateContainer(unsigned int shaderId)
 {
 	// order of operations is inverse, first rotate then translate
@@ -195,6 +372,15 @@ void rotateContainer(unsigned int shaderId)
 }
 
 
+struct BoxVertex
+{
+	Half4 position;
+	Half2 texCoord;
+};
+using BoxVertexLayout = VertexLayout<BoxVertex,
+	VERTEX_ATTRIBUTE(BoxVertex, position), // location 0
+	VERTEX_ATTRIBUTE(BoxVertex, texCoord)>; // location 1
+
 unsigned int createBoxVertexArrayObject() 
 {
 	// x y z | u v
@@ -242,157 +428,839 @@ unsigned int createBoxVertexArrayObject()
 		-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
 	};
 
-	unsigned int VBO, VAO;
-	glGenVertexArrays(1, &VAO); // create vertex arrays and assign memory location to VAO
-	glGenBuffers(1, &VBO); // create buffer and assign memory location to VBO
-	glBindVertexArray(VAO); // bind array object
-	glBindBuffer(GL_ARRAY_BUFFER, VBO); // bind buffer to OpenGL Array buffer location
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // copy vertices to bound buffer
-	
-	// position attributes
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	// half floats are exact for these coordinates, 12 bytes per vertex instead of 20
+	BoxVertex boxVertices[36];
+	for (unsigned int i = 0; i < 36; i++)
+	{
+		const float* vertex = vertices + 5 * i;
+		boxVertices[i].position = packHalf4(glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+		boxVertices[i].texCoord = packHalf2(glm::vec2(vertex[3], vertex[4]));
+	}
+	return createVertexArrayObject<BoxVertexLayout>(boxVertices, 36);
+}
 
-	// texture attributes
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3*sizeof(float)));
-	glEnableVertexAttribArray(1);
+void setShaderViewMatrix(unsigned int shaderId, const glm::mat4& view)
+{
+	unsigned int viewLoc = glGetUniformLocation(shaderId, "view");
+	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+}
 
-	return VAO;
+void setShaderProjectionMatrix(unsigned int shaderId, const glm::mat4& projection)
+{
+	// projection matrix to transform vertices into a 3d perspective
+	unsigned int projectionLoc = glGetUniformLocation(shaderId, "projection");
+	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
 }
 
-void setShaderModelMatrix(unsigned int shaderId)
+const glm::vec3 cubePositions[] = {
+	glm::vec3(0.0f,  0.0f,  0.0f),
+	glm::vec3(2.0f,  5.0f, -15.0f),
+	glm::vec3(-1.5f, -2.2f, -2.5f),
+	glm::vec3(-3.8f, -2.0f, -12.3f),
+	glm::vec3(2.4f, -0.4f, -3.5f),
+	glm::vec3(-1.7f,  3.0f, -7.5f),
+	glm::vec3(1.3f, -2.0f, -2.5f),
+	glm::vec3(1.5f,  2.0f, -2.5f),
+	glm::vec3(1.5f,  0.2f, -1.5f),
+	glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+// the two most recent simulation states, rendering blends between them
+std::vector<Transform> previousCubes;
+std::vector<Transform> currentCubes;
+size_t animatedCubeCount = 0; // the first animatedCubeCount cubes spin, the others never move
+
+// spatial index over the cubes for visibility queries
+const AABB CUBE_BOUNDS(glm::vec3(-0.5f), glm::vec3(0.5f));
+AABBTree sceneTree;
+std::vector<int> animatedProxies;
+std::vector<AABB> animatedWorldBounds; // reused by every simulation step
+
+/* Replaces the scene with cubes, of which the first animatedCount spin. Called by the main
+   loop for cubePositions and by the regression benchmark for each of its scenes */
+void loadScene(const std::vector<Transform>& cubes, size_t animatedCount)
+{
+	currentCubes = cubes;
+	previousCubes = cubes;
+	animatedCubeCount = std::min(animatedCount, cubes.size());
+	sceneTree.clear(); // keeps the capacity of the previous scene
+	animatedProxies.clear();
+	for (size_t i = 0; i < cubes.size(); i++)
+	{
+		int proxyId = sceneTree.createProxy(CUBE_BOUNDS.transformed(cubes[i].toMatrix()), (int)i);
+		if (i < animatedCubeCount)
+			animatedProxies.push_back(proxyId);
+	}
+	animatedWorldBounds.resize(animatedCubeCount);
+}
+
+void createMultipleCubes()
+{
+	std::vector<Transform> cubes;
+	for (unsigned int i = 0; i < 10; i++)
+	{
+		Transform cube;
+		cube.position = cubePositions[i];
+		float angle = 20.0f * i;
+		cube.rotation = glm::angleAxis(glm::radians(angle), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+		cubes.push_back(cube);
+	}
+	loadScene(cubes, cubes.size());
+}
+
+/* Advances the scene by one fixed timestep */
+void simulateStep(float timestep)
+{
+	// the cubes that never move are the same in both states
+	std::copy_n(currentCubes.begin(), animatedCubeCount, previousCubes.begin());
+	// rotate every cube by 50 degrees per second around its own axis
+	glm::quat spin = glm::angleAxis(glm::radians(50.0f) * timestep, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f)));
+	for (size_t i = 0; i < animatedCubeCount; i++)
+	{
+		currentCubes[i].rotation = glm::normalize(currentCubes[i].rotation * spin);
+		animatedWorldBounds[i] = CUBE_BOUNDS.transformed(currentCubes[i].toMatrix());
+	}
+	if (animatedCubeCount > 0)
+		sceneTree.refitProxies(animatedProxies, animatedWorldBounds);
+}
+
+// the cubes double as occluders, a closed box only needs its 8 corners
+const float CUBE_OCCLUDER_POSITIONS[] = {
+	-0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,
+	-0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f
+};
+const unsigned int CUBE_OCCLUDER_INDICES[] = {
+	0, 1, 2,  2, 3, 0, // back
+	4, 5, 6,  6, 7, 4, // front
+	0, 4, 7,  7, 3, 0, // left
+	1, 5, 6,  6, 2, 1, // right
+	0, 1, 5,  5, 4, 0, // bottom
+	3, 2, 6,  6, 7, 3  // top
+};
+
+// low resolution on purpose, occlusion only needs to be conservative, not exact
+OcclusionCuller occlusionCuller(256, 128);
+// reused by every frame
+std::vector<Transform> frustumVisibleCubes;
+std::vector<glm::mat4> frustumVisibleModels;
+std::vector<std::pair<float, size_t>> occluderCandidates; // projected size, frustumVisible index
+
+/* Adds a draw and a transform for every cube whose bounds touch the frustum and that is not
+   hidden behind the other cubes */
+void addMultipleCubes(std::vector<DrawCommand>& draws, std::vector<Transform>& transforms, const Frustum& frustum, const glm::mat4& viewProjection, float alpha)
+{
+	frustumVisibleCubes.clear();
+	frustumVisibleModels.clear();
+	sceneTree.queryFrustum(frustum, [&](int proxyId) {
+		int i = sceneTree.getUserData(proxyId);
+		Transform cube = Transform::interpolate(previousCubes[i], currentCubes[i], alpha);
+		frustumVisibleCubes.push_back(cube);
+		frustumVisibleModels.push_back(cube.toMatrix());
+	});
+
+	// the GPU culler receives every cube in the frustum and does its own occlusion tests
+	bool occlusionTest = OCCLUSION_CULLING && !gpuOcclusionCulling;
+	if (occlusionTest)
+	{
+		// the cubes covering the most of the screen hide the most, rasterizing the many small
+		// and distant ones would cost more than it culls. the squared size over the squared
+		// view depth orders them by projected area
+		occluderCandidates.clear();
+		for (size_t i = 0; i < frustumVisibleCubes.size(); i++)
+		{
+			const Transform& cube = frustumVisibleCubes[i];
+			float depth = (viewProjection * glm::vec4(cube.position, 1.0f)).w;
+			occluderCandidates.push_back({ depth > 0.0f ? glm::dot(cube.scale, cube.scale) / (depth * depth) : 0.0f, i });
+		}
+		size_t occluderCount = std::min(occluderCandidates.size(), MAX_OCCLUDERS);
+		std::nth_element(occluderCandidates.begin(), occluderCandidates.begin() + occluderCount, occluderCandidates.end(), std::greater<>());
+
+		// a cube never hides itself: its bounds are nearer than or level with its own faces
+		occlusionCuller.clear();
+		occlusionCuller.setViewProjection(viewProjection);
+		for (size_t i = 0; i < occluderCount; i++)
+			occlusionCuller.addOccluder(CUBE_OCCLUDER_POSITIONS, CUBE_OCCLUDER_INDICES, 12, frustumVisibleModels[occluderCandidates[i].second]);
+		occlusionCuller.rasterizeOccluders();
+	}
+	for (size_t i = 0; i < frustumVisibleCubes.size(); i++)
+	{
+		if (occlusionTest && !occlusionCuller.isVisible(CUBE_BOUNDS.transformed(frustumVisibleModels[i])))
+			continue;
+		draws.push_back({ frustumVisibleModels[i] });
+		transforms.push_back(frustumVisibleCubes[i]);
+		if (showBounds)
+			debugDraw.box(CUBE_BOUNDS.transformed(frustumVisibleModels[i]), glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+	}
+}
+
+/* Draws every cube with a single instanced draw call */
+void drawCubesInstanced(Shader& shader, unsigned int instanceVBO, const std::vector<PackedInstance>& instances)
+{
+	uploadInstances(instanceVBO, instances.data(), instances.size());
+	shader.use();
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)instances.size());
+}
+
+void drawMultipleCubes(unsigned int shaderId, const std::vector<DrawCommand>& draws)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	// rotate model by t*50 degrees.
-	model = glm::rotate(model, (float)glfwGetTime() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
 	unsigned int modelLoc = glGetUniformLocation(shaderId, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	for (const DrawCommand& draw : draws)
+	{
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(draw.model));
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+	}
 }
 
+std::vector<CullObject> cullObjects; // render thread only, reused by every frame
 
-void setShaderViewMatrix(unsigned int shaderId)
+/* Draws the cubes in the two phases of the GPU occlusion culler. Expects the scene target
+   bound and leaves it bound */
+void drawCubesOcclusionCulled(HiZCuller& culler, Shader& shader, const std::vector<DrawCommand>& draws, const glm::mat4& viewProjection)
 {
-	glm::mat4 view;
-	view = glm::lookAt(
-		camera.Position,
-		camera.Position + camera.Front, // camera target (origin)
-		camera.Up
-	);
-	unsigned int viewLoc = glGetUniformLocation(shaderId, "view");
-	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+	cullObjects.resize(draws.size());
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		AABB bounds = CUBE_BOUNDS.transformed(draws[i].model);
+		cullObjects[i].model = draws[i].model;
+		cullObjects[i].boundsMin = glm::vec4(bounds.min, 1.0f);
+		cullObjects[i].boundsMax = glm::vec4(bounds.max, 1.0f);
+	}
+	culler.beginFrame(cullObjects.data(), cullObjects.size(), 36);
+
+	// cubes visible against last frame's depth
+	GLDebugOutput::pushGroup("occlusion first phase");
+	culler.cull(HiZCuller::PHASE_FIRST, viewProjection);
+	shader.use();
+	culler.draw(HiZCuller::PHASE_FIRST);
+	GLDebugOutput::popGroup();
+
+	// cubes that were hidden last frame but are not behind what was just drawn
+	GLDebugOutput::pushGroup("occlusion second phase");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0); // the pyramid reads the depth attachment
+	culler.buildPyramid(sceneTarget.DepthTexture);
+	culler.cull(HiZCuller::PHASE_SECOND, viewProjection);
+	sceneTarget.bind();
+	shader.use();
+	culler.draw(HiZCuller::PHASE_SECOND);
+	GLDebugOutput::popGroup();
+
+	// the complete depth becomes next frame's first phase occluders
+	GLDebugOutput::pushGroup("hi-z pyramid");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	culler.buildPyramid(sceneTarget.DepthTexture);
+	culler.endFrame(viewProjection);
+	sceneTarget.bind();
+	GLDebugOutput::popGroup();
 }
 
-void setShaderProjectionMatrix(unsigned int shaderId)
+std::vector<Transform> visibleCubes; // simulation thread only, reused by every frame
+
+/* Runs on the simulation thread: copies everything the renderer needs out of the camera
+   and scene so both threads can work on different frames at the same time. alpha is the
+   fraction of a timestep the real time is ahead of the previous simulation state */
+void buildRenderState(RenderState& state, Camera& camera, int width, int height, float alpha)
 {
-	// create a projection matrix to transform vertices into a 3d perspective
-	glm::mat4 projection;
-	float aspectRatio = (float)SCR_WIDTH / (float)SCR_HEIGHT; // ratio of the window
-	float nearPlaneCoord = 0.1f; // view area starting z coord
-	float farPlaneCoord = 100.0f; // view area ending z coord
-	projection = glm::perspective(glm::radians(camera.Zoom), aspectRatio, nearPlaneCoord, farPlaneCoord);
-	unsigned int projectionLoc = glGetUniformLocation(shaderId, "projection");
-	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+	state.view = camera.GetViewMatrix();
+	state.projection = camera.GetProjectionMatrix();
+	state.cameraVersion = camera.GetVersion();
+	state.framebufferWidth = width;
+	state.framebufferHeight = height;
+	state.draws.clear(); // keeps the capacity of the slot's previous frame
+	visibleCubes.clear();
+	simulationCounters.begin(counterPhases.culling);
+	addMultipleCubes(state.draws, visibleCubes, camera.GetFrustum(), camera.GetViewProjectionMatrix(), alpha);
+	simulationCounters.end(counterPhases.culling);
+
+	// packed here so the render thread only has to copy the instances into a buffer
+	PerfCounters::Scope scope(simulationCounters, counterPhases.pack);
+	state.instances.resize(PACKED_INSTANCING && !gpuOcclusionCulling ? visibleCubes.size() : 0);
+	packInstances(visibleCubes.data(), state.instances.size(), state.instances.data());
+}
+
+/* Overlay drawn over the finished frame, in pixels from the bottom left corner */
+void drawHud(unsigned int iconTexture, unsigned int whiteTexture, int viewportHeight)
+{
+	spriteBatch.draw(iconTexture, glm::vec2(40.0f, 40.0f), glm::vec2(48.0f, 48.0f));
+	textRenderer.drawRun(hudTitle);
+	statsHud.draw(renderStats, spriteBatch, whiteTexture, textRenderer, hudFont, glm::vec2(16.0f, viewportHeight - 16.0f));
+}
+
+// texture units and debug name of a cube program, set again whenever a reload replaces it
+void setupCubeShader(Shader& shader, const char* label)
+{
+	shader.use(); // must use shader before setting uniforms
+	shader.setInt("texture1", 0); // set texture1 as texture unit 0
+	shader.setInt("texture2", 1); // set texture2 as texture unit 1
+	GLDebugOutput::label(GL_PROGRAM, shader.ID, label);
+}
+
+/* GL objects owned by the render thread */
+struct RenderResources
+{
+	Shader& shader;
+	ShaderPermutations& cubeShaders; // every variant is rebuilt when a watched file changes
+	ShaderWatcher& shaderWatcher;
+	unsigned int VAO;
+	unsigned int texture1;
+	unsigned int texture2;
+	unsigned int whiteTexture;
+	Shader& instancedShader;
+	unsigned int instanceVBO;
+	Shader* culledShader; // NULL unless the GPU occlusion culler is used
+	HiZCuller* hizCuller;
+};
+
+/* What renderFrame keeps from one frame to the next */
+struct RenderView
+{
+	unsigned int uploadedCameraVersion = 0; // camera version last written to the shader uniforms
+	int viewportWidth = 0; // the first frame sets the viewport
+	int viewportHeight = 0;
+};
+
+/* Records the GL commands of one frame: the cubes into the scene target, the debug lines and
+   the HUD over the default framebuffer. Called by the render thread for every state it
+   consumes and by the regression benchmark for its scenes */
+void renderFrame(const RenderState& state, RenderResources& resources, RenderView& view)
+{
+	Shader& ourShader = resources.shader;
+
+	// resizes are detected here because GL calls are only allowed on this thread
+	if (state.framebufferWidth != view.viewportWidth || state.framebufferHeight != view.viewportHeight)
+	{
+		view.viewportWidth = state.framebufferWidth;
+		view.viewportHeight = state.framebufferHeight;
+		glViewport(0, 0, view.viewportWidth, view.viewportHeight);
+		if (reverseZ)
+		{
+			sceneTarget.create(view.viewportWidth, view.viewportHeight);
+			labelSceneTarget();
+		}
+		if (gpuOcclusionCulling)
+			resources.hizCuller->resize(view.viewportWidth, view.viewportHeight, reverseZ);
+	}
+
+	GLDebugOutput::pushGroup("scene");
+	if (reverseZ)
+		sceneTarget.bind();
+	// set clear color buffer
+	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+	// clear buffer bit with color and depth test buffer bit
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glActiveTexture(GL_TEXTURE0); // set texture unit 0 as active before bind 
+	glBindTexture(GL_TEXTURE_2D, resources.texture1);
+	glActiveTexture(GL_TEXTURE1); // set texture unit 1 as active before bind 
+	glBindTexture(GL_TEXTURE_2D, resources.texture2);
+
+	// recompile edited shaders in the background and swap them in once linked
+	{
+		HeapTracker::TagScope tag(memoryTags.shaderReload);
+		if (resources.shaderWatcher.pollChanged())
+			resources.cubeShaders.reload();
+		if (resources.cubeShaders.pollReload())
+		{
+			setupCubeShader(ourShader, "cube shader");
+			setupCubeShader(resources.instancedShader, "instanced cube shader");
+			if (resources.culledShader != NULL)
+				setupCubeShader(*resources.culledShader, "culled cube shader");
+			view.uploadedCameraVersion = 0; // the new programs have no matrices set yet
+		}
+	}
+
+	ourShader.use();
+	// uniforms keep their value between frames, so skip the upload while the camera is still
+	if (state.cameraVersion != view.uploadedCameraVersion)
+	{
+		setShaderViewMatrix(ourShader.ID, state.view);
+		setShaderProjectionMatrix(ourShader.ID, state.projection);
+		resources.instancedShader.use();
+		setShaderViewMatrix(resources.instancedShader.ID, state.view);
+		setShaderProjectionMatrix(resources.instancedShader.ID, state.projection);
+		if (gpuOcclusionCulling)
+		{
+			resources.culledShader->use();
+			setShaderViewMatrix(resources.culledShader->ID, state.view);
+			setShaderProjectionMatrix(resources.culledShader->ID, state.projection);
+			ourShader.use();
+		}
+		view.uploadedCameraVersion = state.cameraVersion;
+	}
+	glBindVertexArray(resources.VAO);
+	if (gpuOcclusionCulling)
+		drawCubesOcclusionCulled(*resources.hizCuller, *resources.culledShader, state.draws, state.projection * state.view);
+	else if (PACKED_INSTANCING)
+		drawCubesInstanced(resources.instancedShader, resources.instanceVBO, state.instances);
+	else
+		drawMultipleCubes(ourShader.ID, state.draws);
+	GLDebugOutput::popGroup();
+	// lines added while this state was built may wait for the next frame, which is fine for debugging
+	GLDebugOutput::pushGroup("debug draw");
+	debugDraw.flush(state.projection * state.view, reverseZ);
+	GLDebugOutput::popGroup();
+
+	if (reverseZ)
+		sceneTarget.blitToDefault(view.viewportWidth, view.viewportHeight);
+	GLDebugOutput::pushGroup("hud");
+	drawHud(resources.texture2, resources.whiteTexture, view.viewportHeight);
+	spriteBatch.flush(view.viewportWidth, view.viewportHeight, reverseZ);
+	textRenderer.flush(view.viewportWidth, view.viewportHeight);
+	GLDebugOutput::popGroup();
 }
 
-void drawMultipleCubes(unsigned int shaderId)
+// everything main created for rendering, on the thread that owns the context
+void destroyRenderer(RenderResources& resources)
 {
-	glm::vec3 cubePositions[] = {
-		glm::vec3(0.0f,  0.0f,  0.0f),
-		glm::vec3(2.0f,  5.0f, -15.0f),
-		glm::vec3(-1.5f, -2.2f, -2.5f),
-		glm::vec3(-3.8f, -2.0f, -12.3f),
-		glm::vec3(2.4f, -0.4f, -3.5f),
-		glm::vec3(-1.7f,  3.0f, -7.5f),
-		glm::vec3(1.3f, -2.0f, -2.5f),
-		glm::vec3(1.5f,  2.0f, -2.5f),
-		glm::vec3(1.5f,  0.2f, -1.5f),
-		glm::vec3(-1.3f,  1.0f, -1.5f)
+	if (resources.hizCuller != NULL)
+		resources.hizCuller->destroy();
+	debugDraw.destroy();
+	spriteBatch.destroy();
+	textRenderer.destroy();
+	renderStats.destroy();
+	hudFont.destroy();
+}
+
+/* Owns the GL context: consumes render states until the pipeline is closed */
+void renderThreadMain(GLFWwindow* window, FramePipeline<RenderState>& pipeline, RenderResources resources)
+{
+	glfwMakeContextCurrent(window);
+
+	RenderView view;
+	unsigned int frameIndex = 0;
+	if (perfCountersFile != NULL)
+		renderCounters.open();
+
+	{
+		FramePacer pacer(MAX_FRAMES_IN_FLIGHT, TARGET_FRAME_RATE);
+
+		const RenderState* state;
+		while (true)
+		{
+			// wait for the GPU before taking the next snapshot, so it is as fresh as possible
+			pacer.beginFrame();
+			if ((state = pipeline.beginRead()) == NULL)
+				break;
+			renderAllocations.beginFrame();
+			renderStats.beginFrame();
+			glDebugOutput.beginFrame();
+			bool capturing = traceCaptureFile != NULL && frameIndex == CAPTURE_FRAME;
+			if (capturing)
+				GLTraceRecorder::beginCapture(state->framebufferWidth, state->framebufferHeight);
+			// one frame's queries come back per beginFrame once the latency is filled
+			if (performanceReport && renderStats.getFrameCount() >= RenderStats::QUERY_LATENCY)
+				performanceReport->record(performanceSeries.gpu, renderStats.getLastGpuTime());
+			// every GL call of the frame, up to the end of the HUD
+			renderCounters.begin(counterPhases.submission);
+			renderFrame(*state, resources, view);
+			renderCounters.end(counterPhases.submission);
+			if (capturing)
+				GLTraceRecorder::endCapture(traceCaptureFile);
+			renderStats.endFrame();
+			glDebugOutput.pollErrors();
+			if (performanceReport)
+				performanceReport->record(performanceSeries.renderCpu, renderStats.getFrame(0).cpuTime);
+
+			// the snapshot is no longer needed once the commands are recorded
+			renderAllocations.endFrame();
+			pipeline.endRead();
+			glfwSwapBuffers(window); // show buffered pixels
+			pacer.endFrame();
+			renderCounters.endFrame(frameIndex);
+			frameIndex++;
+		}
+
+		pacer.printReport();
+		renderCounters.printReport();
+		renderAllocations.printReport();
+		destroyRenderer(resources);
+	} // fences are deleted while the context is still current
+	glfwMakeContextCurrent(NULL);
+}
+
+/* Renders the regression scenes offscreen and compares them with the baseline file, or
+   replaces it with updateBaseline. Every --stress-scene <options> on the command line adds a
+   generated scene (see StressSceneConfig) and replaces the default ones. The scenes main can
+   draw go through renderFrame with the resources main set up, paced like the render thread.
+   Returns the exit code: 0 when nothing regressed, 1 on a regression or an error */
+int runRegressionBenchmark(int argc, char** argv, const char* baselinePath, bool updateBaseline, const char* cameraPathFile,
+	RenderResources& resources)
+{
+	RegressionBenchmark benchmark;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--stress-scene") != 0)
+			continue;
+		StressSceneConfig config;
+		if (!config.parse(argv[i + 1]))
+			return 1;
+		benchmark.scenes.push_back(StressSceneGenerator::generate(config));
+	}
+	if (benchmark.scenes.empty())
+		benchmark.addDefaultScenes(cubePositions, sizeof(cubePositions) / sizeof(cubePositions[0]));
+	if (cameraPathFile != NULL)
+	{
+		CameraPath path;
+		if (!path.load(cameraPathFile))
+			return 1;
+		benchmark.setCameraPath(path);
+	}
+	if (perfCountersFile != NULL)
+		benchmark.enablePerfCounters();
+
+	RenderView view;
+	FramePacer pacer(MAX_FRAMES_IN_FLIGHT); // no frame rate target, the benchmark runs flat out
+	RegressionBenchmark::AppFrame frame;
+	frame.loadScene = [&](const std::vector<Transform>& cubes, size_t animatedCount) {
+		loadScene(cubes, animatedCount);
+		view.uploadedCameraVersion = 0; // every scene has a camera of its own
 	};
+	frame.simulate = simulateStep;
+	frame.buildState = buildRenderState;
+	frame.render = [&](const RenderState& state) {
+		pacer.beginFrame();
+		renderStats.beginFrame();
+		renderFrame(state, resources, view);
+		renderStats.endFrame();
+		pacer.endFrame();
+	};
+	frame.projectionMode = camera.GetProjectionMode();
+	benchmark.setAppFrame(frame);
 
-	for (unsigned int i = 0; i < 10; i++)
+	std::vector<BenchmarkMetric> metrics = benchmark.run({ createBoxVertexArrayObject, 36,
+		VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH });
+	// a steady frame that allocates fails whatever the timings say
+	bool allocated = benchmark.getAllocatingFrames() > 0;
+	if (allocated)
+		HeapTracker::printCallSites();
+	if (updateBaseline)
 	{
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, cubePositions[i]);
-		float angle = 20.0f * i;
-		model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-		unsigned int modelLoc = glGetUniformLocation(shaderId, "model");
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		std::cout << "REGRESSION_BENCHMARK baseline written to " << baselinePath << std::endl;
+		return BenchmarkBaseline::save(baselinePath, metrics) && !allocated ? 0 : 1;
 	}
+
+	BenchmarkBaseline baseline;
+	if (!baseline.load(baselinePath))
+		return 1;
+	std::cout << "REGRESSION_BENCHMARK against " << baselinePath << std::endl;
+	unsigned int regressions = baseline.compare(metrics);
+	bool passed = regressions == 0 && !allocated;
+	std::cout << "REGRESSION_BENCHMARK " << (passed ? "passed" : "FAILED") << ", regressions: " << regressions
+		<< ", allocating frames: " << benchmark.getAllocatingFrames() << std::endl;
+	return passed ? 0 : 1;
 }
 
-int main()
+// the value following name on the command line, NULL when it is not there
+const char* getArgument(int argc, char** argv, const char* name)
+{
+	for (int i = 1; i + 1 < argc; i++)
+		if (std::strcmp(argv[i], name) == 0)
+			return argv[i + 1];
+	return NULL;
+}
+
+bool hasArgument(int argc, char** argv, const char* name)
+{
+	for (int i = 1; i < argc; i++)
+		if (std::strcmp(argv[i], name) == 0)
+			return true;
+	return false;
+}
+
+int main(int argc, char** argv)
 {
 	std::cout << "Hello Camera" << std::endl;
 	setupGlfw();
 
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (window == NULL)
+	// --benchmark <baseline> [--update-baseline] [--benchmark-path <camera path>]
+	// [--stress-scene <options>]... renders the regression scenes offscreen and exits with 1
+	// when they got slower than the baseline
+	const char* benchmarkBaseline = getArgument(argc, argv, "--benchmark");
+	glfwWindowHint(GLFW_VISIBLE, benchmarkBaseline != NULL ? GLFW_FALSE : GLFW_TRUE);
+	// debug builds stop on the GL call that went wrong. --gl-debug also reports driver
+	// warnings in release builds, asynchronously so the timings stay meaningful
+	bool glDebug = GL_DEBUG_BUILD || hasArgument(argc, argv, "--gl-debug");
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, glDebug ? GLFW_TRUE : GLFW_FALSE);
+	// --null-gl runs the benchmarks on NullGL instead of a driver: the renderer's own CPU
+	// time, its call counts and redundant state, even on a machine without any GL
+	bool instanceBenchmark = argc > 1 && std::strcmp(argv[1], "--instance-benchmark") == 0;
+	bool spriteBenchmark = hasArgument(argc, argv, "--sprite-benchmark");
+	bool nullGL = hasArgument(argc, argv, "--null-gl");
+	if (nullGL && benchmarkBaseline == NULL && !instanceBenchmark && !spriteBenchmark)
 	{
-		std::cout << "Failed to create GLFW window" << std::endl;
+		std::cout << "ERROR::NULL_GL::NOT_A_BENCHMARK --null-gl needs --benchmark, --instance-benchmark or --sprite-benchmark" << std::endl;
 		glfwTerminate();
 		return -1;
 	}
-	// make window context the main context on the current thread
-	glfwMakeContextCurrent(window);
-	// get OS specific address of OpenGL function pointers and load into GLAD
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	GLFWwindow* window = NULL;
+	if (nullGL)
+		NullGL::install();
+	else
 	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		return -1;
-	};
-	// register callback that initializes viewport matching window size 
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+		if (window == NULL)
+		{
+			std::cout << "Failed to create GLFW window" << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		// make window context the main context on the current thread
+		glfwMakeContextCurrent(window);
+		// get OS specific address of OpenGL function pointers and load into GLAD
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return -1;
+		};
+	}
+	Shader::initParallelCompile((GLADloadproc)glfwGetProcAddress);
+	if (glDebug)
+		glDebugOutput.enable(GL_DEBUG_BUILD ? GLDebugOutput::MODE_SYNCHRONOUS : GLDebugOutput::MODE_ASYNCHRONOUS);
+	if (RENDER_STATS)
+		RenderStats::installHooks();
+	perfCountersFile = getArgument(argc, argv, "--perf-counters");
+	if (perfCountersFile != NULL && !PerfCounters::openLog(perfCountersFile))
+		perfCountersFile = NULL;
+	traceCaptureFile = getArgument(argc, argv, "--capture-frame");
+	if (traceCaptureFile != NULL)
+		GLTraceRecorder::installHooks();
 
 	// Enable OpenGL to test depth so vertices behind faces don't get rendered
 	glEnable(GL_DEPTH_TEST); 
 
-	Shader ourShader(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+	// measures packed against mat4 instancing and exits
+	if (instanceBenchmark)
+	{
+		InstanceBenchmark::run(createBoxVertexArrayObject, 36,
+			VERTEX_SHADER_PATH, INSTANCED_MATRIX_VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+		if (nullGL)
+			NullGL::printReport();
+		glfwTerminate();
+		return 0;
+	}
+	// draws half a million sprites per frame through the HUD's sprite batch and exits
+	if (spriteBenchmark)
+	{
+		SpriteBenchmark::run(createPlaneVertexArrayObject, SPRITE_VERTEX_SHADER_PATH, SPRITE_FRAGMENT_SHADER_PATH);
+		if (nullGL)
+			NullGL::printReport();
+		glfwTerminate();
+		return 0;
+	}
+
+	// register callback that tracks the framebuffer size, the render thread applies it
+	if (window != NULL)
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+	memoryTags.shaders = HeapTracker::registerTag("shaders");
+	memoryTags.textures = HeapTracker::registerTag("textures");
+	memoryTags.meshes = HeapTracker::registerTag("meshes");
+	memoryTags.hud = HeapTracker::registerTag("hud");
+	memoryTags.debugDraw = HeapTracker::registerTag("debug_draw");
+	memoryTags.scene = HeapTracker::registerTag("scene");
+	memoryTags.shaderReload = HeapTracker::registerTag("shader_reload", HeapTracker::TAG_EXEMPT);
+	memoryTags.cameraPath = HeapTracker::registerTag("camera_path", HeapTracker::TAG_EXEMPT);
+	// the frame phases are tags too, whether or not their counters are opened
+	counterPhases.input = simulationCounters.addPhase("input");
+	counterPhases.transformUpdate = simulationCounters.addPhase("transform_update");
+	counterPhases.culling = simulationCounters.addPhase("culling");
+	counterPhases.pack = simulationCounters.addPhase("pack");
+	counterPhases.submission = renderCounters.addPhase("submission");
+
 	camera = Camera();
+	if (window != NULL)
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	camera.SetAspectRatio((float)framebufferWidth / (float)framebufferHeight);
+	reverseZ = setupReverseZ();
+
+	// every cube program is a variant of shader.vs, the ones this run can draw with are built
+	// together up front so the driver compiles them in parallel
+	HeapTracker::setThreadTag(memoryTags.shaders);
+	ShaderPermutations cubeShaders(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, { "PACKED_INSTANCING", "OCCLUSION_CULLED" });
+	cubeShaders.setFeatureVersion("OCCLUSION_CULLED", "430 core");
+	const uint64_t instancedKey = cubeShaders.featureBit("PACKED_INSTANCING");
+	// the Hi-Z pyramid is built from the scene target's depth texture, so it needs reverse-Z too
+	const uint64_t culledKey = GPU_OCCLUSION_CULLING && reverseZ && GLAD_GL_VERSION_4_3
+		? cubeShaders.featureBit("OCCLUSION_CULLED")
+		: 0;
+	std::vector<uint64_t> cubeShaderKeys = { 0, instancedKey };
+	if (culledKey != 0)
+		cubeShaderKeys.push_back(culledKey);
+	cubeShaders.precompile(cubeShaderKeys);
+	for (uint64_t key : cubeShaderKeys)
+	{
+		if (cubeShaders.get(key) == NULL)
+		{
+			std::cout << "ERROR::SHADER::CUBE_VARIANT_NOT_BUILT " << key << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+	}
+	Shader& ourShader = *cubeShaders.get(0);
+	Shader& instancedShader = *cubeShaders.get(instancedKey);
+	setupCubeShader(ourShader, "cube shader");
+	setupCubeShader(instancedShader, "instanced cube shader");
+	ShaderWatcher shaderWatcher(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
 
-	unsigned int VAO, texture1, texture2;
+	unsigned int VAO, texture1, texture2, whiteTexture;
+	HeapTracker::setThreadTag(memoryTags.meshes);
 	VAO = createBoxVertexArrayObject();
+	HeapTracker::setThreadTag(memoryTags.textures);
 	texture1 = generateTexture(CONTAINER_IMG_PATH, GL_RGB);
 	texture2 = generateTexture(FACE_IMG_PATH, GL_RGBA);
-	ourShader.use(); // must use shader before setting uniforms
-	ourShader.setInt("texture1", 0); // set texture1 as texture unit 0
-	ourShader.setInt("texture2", 1); // set texture2 as texture unit 1
+	whiteTexture = createWhiteTexture();
+	GLDebugOutput::label(GL_VERTEX_ARRAY, VAO, "box");
+	GLDebugOutput::label(GL_TEXTURE, texture1, "container");
+	GLDebugOutput::label(GL_TEXTURE, texture2, "awesomeface");
+	GLDebugOutput::label(GL_TEXTURE, whiteTexture, "white");
+
+	HeapTracker::setThreadTag(memoryTags.meshes);
+	unsigned int instanceVBO = createPackedInstanceBuffer(VAO);
+	GLDebugOutput::label(GL_BUFFER, instanceVBO, "cube instances");
+
+	Shader* culledShader = NULL;
+	HiZCuller hizCuller;
+	if (culledKey != 0)
+	{
+		culledShader = cubeShaders.get(culledKey);
+		setupCubeShader(*culledShader, "culled cube shader");
+		HeapTracker::setThreadTag(memoryTags.shaders);
+		gpuOcclusionCulling = hizCuller.create(OCCLUSION_CULL_SHADER_PATH, HIZ_DOWNSAMPLE_SHADER_PATH);
+	}
+
+	HeapTracker::setThreadTag(memoryTags.debugDraw);
+	debugDraw.create(DEBUG_DRAW_VERTEX_SHADER_PATH, DEBUG_DRAW_FRAGMENT_SHADER_PATH);
+	HeapTracker::setThreadTag(memoryTags.hud);
+	spriteBatch.create(createPlaneVertexArrayObject(), SPRITE_VERTEX_SHADER_PATH, SPRITE_FRAGMENT_SHADER_PATH);
+	textRenderer.create(createPlaneVertexArrayObject(), SDF_TEXT_VERTEX_SHADER_PATH, SDF_TEXT_FRAGMENT_SHADER_PATH);
+	if (hudFont.load(HUD_FONT_PATH))
+		hudTitle = TextRenderer::layoutRun(hudFont, "LearnOpenGL", glm::vec2(72.0f, 42.0f), 24.0f, glm::vec4(1.0f));
+	renderStats.create();
+	HeapTracker::setThreadTag(HeapTracker::UNTAGGED);
+	RenderResources resources{ ourShader, cubeShaders, shaderWatcher, VAO, texture1, texture2, whiteTexture,
+		instancedShader, instanceVBO, culledShader, gpuOcclusionCulling ? &hizCuller : NULL };
+
+	// the benchmark draws with everything set up above, then exits
+	if (benchmarkBaseline != NULL)
+	{
+		int result = runRegressionBenchmark(argc, argv, benchmarkBaseline, hasArgument(argc, argv, "--update-baseline"),
+			getArgument(argc, argv, "--benchmark-path"), resources);
+		destroyRenderer(resources);
+		glDebugOutput.printReport();
+		if (nullGL)
+			NullGL::printReport();
+		PerfCounters::closeLog();
+		glfwTerminate();
+		return result;
+	}
+
+	cameraPathRecordFile = getArgument(argc, argv, "--record-path");
+	const char* cameraPathPlayFile = getArgument(argc, argv, "--play-path");
+	if (cameraPathPlayFile != NULL)
+		cameraPathPlaying = cameraPath.load(cameraPathPlayFile);
 
 	// hide mouse cursor and capture it
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	if (!cameraPathPlaying)
+	{
+		glfwSetCursorPosCallback(window, mouse_callback);
+		glfwSetScrollCallback(window, scroll_callback);
+	}
+
+	// --perf-report <file.json|file.csv> writes frame and phase time percentiles while running
+	const char* reportPath = getArgument(argc, argv, "--perf-report");
+	if (reportPath != NULL)
+	{
+		performanceReport.reset(new PerformanceReport(reportPath, PERFORMANCE_REPORT_WINDOW));
+		performanceSeries.frame = performanceReport->addSeries("frame", HITCH_THRESHOLD);
+		performanceSeries.simulation = performanceReport->addSeries("simulation");
+		performanceSeries.pipelineWait = performanceReport->addSeries("pipeline_wait");
+		performanceSeries.buildState = performanceReport->addSeries("build_state");
+		performanceSeries.renderCpu = performanceReport->addSeries("render_cpu");
+		performanceSeries.gpu = performanceReport->addSeries("gpu", HITCH_THRESHOLD);
+	}
+	// the simulation loop has no sort, its instances are packed for the render thread instead
+	if (perfCountersFile != NULL)
+		simulationCounters.open();
+
+	// hand the context over to the render thread, this thread keeps input and simulation
+	glfwMakeContextCurrent(NULL);
+	FramePipeline<RenderState> pipeline(MAX_QUEUED_FRAMES);
+	std::thread renderThread(renderThreadMain, window, std::ref(pipeline), resources);
 
-	// setup render loop
+	HeapTracker::setThreadTag(memoryTags.scene);
+	createMultipleCubes();
+	HeapTracker::setThreadTag(HeapTracker::UNTAGGED);
+	SimulationClock simulationClock(SIMULATION_TIMESTEP, MAX_SIMULATION_STEPS);
+	double startTime = getSteadyTime();
+	uint64_t simulationFrame = 0;
+
+	// setup simulation loop
 	while (!glfwWindowShouldClose(window))
 	{
-		float currentFrame = glfwGetTime();
+		double currentFrame = getSteadyTime();
 		deltaTime = currentFrame - lastFrame;
+		if (performanceReport && lastFrame > 0.0)
+		{
+			performanceReport->record(performanceSeries.frame, deltaTime);
+			performanceReport->update(currentFrame - startTime);
+		}
 		lastFrame = currentFrame;
+		// a played path advances exactly one simulation step per frame, so every run renders
+		// the same frames whatever the real frame time
+		if (cameraPathPlaying)
+			deltaTime = SIMULATION_TIMESTEP;
 
+		simulationAllocations.beginFrame();
+		simulationCounters.begin(counterPhases.input);
+		glfwPollEvents(); // check keyboard, mouse and other events, must run on the main thread
 		processInput(window);
-		
-		// set clear color buffer
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		// clear buffer bit with color and depth test buffer bit
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glActiveTexture(GL_TEXTURE0); // set texture unit 0 as active before bind 
-		glBindTexture(GL_TEXTURE_2D, texture1);
-		glActiveTexture(GL_TEXTURE1); // set texture unit 1 as active before bind 
-		glBindTexture(GL_TEXTURE_2D, texture2);
-
-		ourShader.use();
-		setShaderModelMatrix(ourShader.ID);
-		setShaderViewMatrix(ourShader.ID);
-		setShaderProjectionMatrix(ourShader.ID);
-		glBindVertexArray(VAO);
-		drawMultipleCubes(ourShader.ID);
-
-		glfwSwapBuffers(window); // show buffered pixels
-		glfwPollEvents(); // check keyboard, mouse and other events
+		simulationCounters.end(counterPhases.input);
+
+		double simulationStart = getSteadyTime();
+		simulationCounters.begin(counterPhases.transformUpdate);
+		unsigned int steps = simulationClock.advance(deltaTime);
+		for (unsigned int i = 0; i < steps; i++)
+			simulateStep((float)simulationClock.getTimestep());
+		simulationCounters.end(counterPhases.transformUpdate);
+		// simulated time comes from the step count, it is the same on every run
+		if (cameraPathPlaying && !cameraPath.apply((float)simulationClock.getSimulationTime(), camera))
+			glfwSetWindowShouldClose(window, true);
+		if (cameraPathRecordFile != NULL)
+		{
+			HeapTracker::TagScope tag(memoryTags.cameraPath);
+			cameraPath.record((float)(currentFrame - startTime), camera);
+		}
+
+		double simulationEnd = getSteadyTime();
+
+		// blocks while the render thread is MAX_QUEUED_FRAMES behind
+		RenderState& state = pipeline.beginWrite();
+		double buildStart = getSteadyTime();
+		buildRenderState(state, camera, framebufferWidth, framebufferHeight, simulationClock.getAlpha());
+		pipeline.endWrite();
+		if (performanceReport)
+		{
+			performanceReport->record(performanceSeries.simulation, simulationEnd - simulationStart);
+			performanceReport->record(performanceSeries.pipelineWait, buildStart - simulationEnd);
+			performanceReport->record(performanceSeries.buildState, getSteadyTime() - buildStart);
+		}
+		simulationAllocations.endFrame();
+		simulationCounters.endFrame(simulationFrame++);
 	}
+	pipeline.close();
+	renderThread.join();
+	glDebugOutput.printReport();
+	simulationCounters.printReport();
+	simulationAllocations.printReport();
+	HeapTracker::printReport();
+	if (simulationAllocations.getAllocatingFrames() > 0 || renderAllocations.getAllocatingFrames() > 0)
+		HeapTracker::printCallSites();
+	PerfCounters::closeLog();
+	if (performanceReport)
+		performanceReport->close();
+	if (cameraPathRecordFile != NULL)
+		cameraPath.save(cameraPathRecordFile);
 	glfwTerminate(); // clear resources 
 
 	return 0;
-}
\ No newline at end of file
+}
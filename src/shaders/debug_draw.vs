@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+out vec4 Color;
+uniform mat4 viewProjection;
+uniform int overlayStart; // vertices from here on are drawn on top of the scene
+uniform bool reverseZ;
+void main()
+{
+   gl_Position = viewProjection * vec4(aPos, 1.0);
+   // the near plane passes the depth test against anything drawn before
+   if (gl_VertexID >= overlayStart)
+      gl_Position.z = reverseZ ? gl_Position.w : -gl_Position.w;
+   Color = aColor;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec4 Color;
+uniform sampler2D fontAtlas;
+void main()
+{
+    // the outline is at 0.5, fading over about one screen pixel keeps edges sharp at any size
+    float distance = texture(fontAtlas, TexCoord).r;
+    float smoothing = 0.7 * fwidth(distance);
+    float coverage = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+    FragColor = vec4(Color.rgb, Color.a * coverage);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // plane quad corner, -0.5 to 0.5
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec2 aCenter;
+layout (location = 4) in vec2 aScale;
+layout (location = 5) in vec4 aUvRect;
+layout (location = 6) in vec4 aColor;
+out vec2 TexCoord;
+out vec4 Color;
+uniform vec2 viewportSize;
+void main()
+{
+   vec2 position = aCenter + aPos.xy * aScale;
+   gl_Position = vec4(position / viewportSize * 2.0 - 1.0, 0.0, 1.0);
+   TexCoord = mix(aUvRect.xy, aUvRect.zw, aTexCoord);
+   Color = aColor;
+}
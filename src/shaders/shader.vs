@@ -1,12 +1,61 @@
 #version 330 core
+// the cube shader, ShaderPermutations builds its variants from these defines:
+//  - PACKED_INSTANCING: one instance per cube from PackedInstance attributes
+//  - OCCLUSION_CULLED: the objects the GPU culler kept, needs #version 430
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
-out vec2 TexCoord;
+#if defined(OCCLUSION_CULLED)
+struct Object
+{
+    mat4 model;
+    vec4 boundsMin;
+    vec4 boundsMax;
+};
+// filled by the CPU every frame
+layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };
+// indices of the objects that passed occlusion culling, one instance each
+layout (std430, binding = 2) readonly buffer VisibleObjects { uint visibleObjects[]; };
+#elif defined(PACKED_INSTANCING)
+// per instance, see PackedInstance
+layout (location = 2) in vec4 aPositionScale;
+layout (location = 3) in vec4 aOrientation; // smallest three quaternion, normalized 2_10_10_10
+#else
 uniform mat4 model;
+#endif
+out vec2 TexCoord;
 uniform mat4 view;
 uniform mat4 projection;
+
+#if defined(PACKED_INSTANCING) && !defined(OCCLUSION_CULLED)
+vec4 unpackOrientation(vec4 encoded)
+{
+    int largest = int(encoded.w * 3.0 + 0.5);
+    vec3 kept = (encoded.xyz * 2.0 - 1.0) * 0.70710678;
+    float dropped = sqrt(max(1.0 - dot(kept, kept), 0.0));
+    if (largest == 0)
+        return vec4(dropped, kept);
+    if (largest == 1)
+        return vec4(kept.x, dropped, kept.yz);
+    if (largest == 2)
+        return vec4(kept.xy, dropped, kept.z);
+    return vec4(kept, dropped);
+}
+#endif
+
 void main()
 {
-   gl_Position = projection * view * model * vec4(aPos, 1.0);
+#if defined(OCCLUSION_CULLED)
+   mat4 model = objects[visibleObjects[gl_InstanceID]].model;
+   vec4 worldPosition = model * vec4(aPos, 1.0);
+#elif defined(PACKED_INSTANCING)
+   vec4 q = unpackOrientation(aOrientation);
+   // rotating by a unit quaternion, cheaper than building the matrix
+   vec3 scaled = aPos * aPositionScale.w;
+   vec3 rotated = scaled + 2.0 * cross(q.xyz, cross(q.xyz, scaled) + q.w * scaled);
+   vec4 worldPosition = vec4(rotated + aPositionScale.xyz, 1.0);
+#else
+   vec4 worldPosition = model * vec4(aPos, 1.0);
+#endif
+   gl_Position = projection * view * worldPosition;
    TexCoord = aTexCoord;
-};
\ No newline at end of file
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+// per instance model matrix, one column per attribute location
+layout (location = 2) in mat4 aModel;
+out vec2 TexCoord;
+uniform mat4 view;
+uniform mat4 projection;
+void main()
+{
+   gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+   TexCoord = aTexCoord;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec4 Color;
+uniform sampler2D spriteTexture;
+void main()
+{
+    vec4 color = texture(spriteTexture, TexCoord) * Color;
+    // transparent texels must not write depth, they would hide sprites of later batches
+    if (color.a < 1.0 / 255.0)
+        discard;
+    FragColor = color;
+}
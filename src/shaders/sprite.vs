@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // plane quad corner, -0.5 to 0.5
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec2 aCenter;
+layout (location = 4) in vec2 aScale;
+layout (location = 5) in float aRotation;
+layout (location = 6) in float aLayer;
+layout (location = 7) in vec4 aUvRect;
+layout (location = 8) in vec4 aColor;
+out vec2 TexCoord;
+out vec4 Color;
+uniform vec2 viewportSize;
+uniform bool reverseZ;
+void main()
+{
+   vec2 corner = aPos.xy * aScale;
+   float c = cos(aRotation);
+   float s = sin(aRotation);
+   vec2 position = aCenter + vec2(c * corner.x - s * corner.y, s * corner.x + c * corner.y);
+   // higher layers are nearer, so the depth test keeps them on top of later texture batches
+   float nearness = aLayer / 65535.0;
+   gl_Position = vec4(position / viewportSize * 2.0 - 1.0, reverseZ ? nearness : 1.0 - 2.0 * nearness, 1.0);
+   TexCoord = mix(aUvRect.xy, aUvRect.zw, aTexCoord);
+   Color = aColor;
+}
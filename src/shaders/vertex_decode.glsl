@@ -0,0 +1,11 @@
+#pragma once
+// decoders for the vertex formats of vertex_quantizer.h that the vertex fetch cannot expand
+
+// octahedral unit vector, the two components of a normalized Snorm16x2 attribute
+vec3 octDecode(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
@@ -1,3 +1,9 @@
+#include <heap_tracker.h>
+
+// image loads count into the heap tracker like every operator new
+#define STBI_MALLOC(size) HeapTracker::allocate(size)
+#define STBI_REALLOC(pointer, size) HeapTracker::reallocate(pointer, size)
+#define STBI_FREE(pointer) HeapTracker::release(pointer)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
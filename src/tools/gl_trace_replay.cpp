@@ -0,0 +1,692 @@
+/* Offline tool that replays a frame captured with --capture-frame (see
+   include/gl_trace_format.h) in a hidden window and times it, to see what the driver does
+   with the frame's calls without the engine around them. Not part of the Visual Studio
+   project, build it on its own with GLFW, e.g.
+
+     cl /EHsc /std:c++17 /I include src/tools/gl_trace_replay.cpp src/glad.c glfw3.lib opengl32.lib
+     g++ -std=c++17 -I include src/tools/gl_trace_replay.cpp src/glad.c -lglfw -ldl -o gl_trace_replay
+
+   Usage: gl_trace_replay <trace> [--repeat N] [--skip <class>]... [--sort-state]
+     --repeat N    times N replays of the frame after a warm up replay, 100 by default
+     --skip class  leaves out every call of a class: state, clear, bind, uniform, upload,
+                   draw, compute or marker. The image is wrong then, the time is the point
+     --sort-state  sorts the draws between two other calls by program, vertex array and
+                   textures and drops the binds that became redundant, to measure what the
+                   frame's state changes cost. A uniform set for one draw now also reaches
+                   the draws sorted after it, so the image may differ */
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <gl_trace_format.h>
+#include <timing.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+const int DEFAULT_REPEAT = 100;
+const unsigned int SORT_TEXTURE_UNITS = 8; // units whose bindings --sort-state sorts by
+
+struct Command
+{
+	uint16_t call;
+	uint8_t wordCount;
+	uint32_t words[GL_TRACE_MAX_WORDS];
+	const void* data; // 4 byte aligned copy
+	uint32_t dataSize;
+};
+
+// the capture's object names and uniform locations to the replay's
+struct ReplayNames
+{
+	std::map<uint32_t, GLuint> buffers, textures, programs, vertexArrays, framebuffers;
+	std::map<std::pair<uint32_t, GLint>, GLint> locations; // (program, captured location)
+	uint32_t program = 0; // captured name of the program in use
+	unsigned int missing = 0; // objects used but never captured
+};
+
+// splits a section into commands, the data is copied into storage so every blob is aligned
+bool parseCommands(const unsigned char* bytes, size_t size, std::vector<Command>& commands, std::vector<std::vector<uint32_t>>& storage)
+{
+	size_t position = 0;
+	while (position < size)
+	{
+		GLTraceCommand header;
+		if (position + sizeof(header) > size)
+			return false;
+		std::memcpy(&header, bytes + position, sizeof(header));
+		position += sizeof(header);
+		if (header.call >= GL_TRACE_CALL_COUNT || header.wordCount > GL_TRACE_MAX_WORDS
+			|| position + header.wordCount * sizeof(uint32_t) + header.dataSize > size)
+			return false;
+		Command command = {};
+		command.call = header.call;
+		command.wordCount = header.wordCount;
+		std::memcpy(command.words, bytes + position, header.wordCount * sizeof(uint32_t));
+		position += header.wordCount * sizeof(uint32_t);
+		command.dataSize = header.dataSize;
+		if (header.dataSize > 0)
+		{
+			storage.emplace_back((header.dataSize + 3) / 4);
+			std::memcpy(storage.back().data(), bytes + position, header.dataSize);
+			command.data = storage.back().data();
+		}
+		position += header.dataSize;
+		commands.push_back(command);
+	}
+	return true;
+}
+
+float toFloat(uint32_t bits)
+{
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+const void* toPointer(uint32_t offset)
+{
+	return (const void*)(uintptr_t)offset;
+}
+
+GLuint findName(ReplayNames& names, std::map<uint32_t, GLuint>& kind, uint32_t name)
+{
+	if (name == 0)
+		return 0;
+	auto found = kind.find(name);
+	if (found != kind.end())
+		return found->second;
+	names.missing++;
+	return 0;
+}
+
+// locations of the same source on the same driver rarely differ, the captured one is the fallback
+GLint findLocation(const ReplayNames& names, uint32_t program, uint32_t location)
+{
+	auto found = names.locations.find({ program, (GLint)location });
+	return found != names.locations.end() ? found->second : (GLint)location;
+}
+
+void setUniformValue(GLint location, GLenum type, const void* data)
+{
+	GLTraceUniformKind kind;
+	unsigned int components = getTraceUniformLayout(type, kind);
+	const GLfloat* floats = (const GLfloat*)data;
+	const GLint* ints = (const GLint*)data;
+	const GLuint* uints = (const GLuint*)data;
+	if (kind == GL_TRACE_UNIFORM_MATRIX)
+	{
+		if (components == 4)
+			glUniformMatrix2fv(location, 1, GL_FALSE, floats);
+		else if (components == 9)
+			glUniformMatrix3fv(location, 1, GL_FALSE, floats);
+		else if (components == 16)
+			glUniformMatrix4fv(location, 1, GL_FALSE, floats);
+		return;
+	}
+	switch (components * 4 + kind)
+	{
+	case 4 + GL_TRACE_UNIFORM_FLOAT: glUniform1fv(location, 1, floats); break;
+	case 8 + GL_TRACE_UNIFORM_FLOAT: glUniform2fv(location, 1, floats); break;
+	case 12 + GL_TRACE_UNIFORM_FLOAT: glUniform3fv(location, 1, floats); break;
+	case 16 + GL_TRACE_UNIFORM_FLOAT: glUniform4fv(location, 1, floats); break;
+	case 4 + GL_TRACE_UNIFORM_INT: glUniform1iv(location, 1, ints); break;
+	case 8 + GL_TRACE_UNIFORM_INT: glUniform2iv(location, 1, ints); break;
+	case 12 + GL_TRACE_UNIFORM_INT: glUniform3iv(location, 1, ints); break;
+	case 16 + GL_TRACE_UNIFORM_INT: glUniform4iv(location, 1, ints); break;
+	case 4 + GL_TRACE_UNIFORM_UNSIGNED_INT: glUniform1uiv(location, 1, uints); break;
+	case 8 + GL_TRACE_UNIFORM_UNSIGNED_INT: glUniform2uiv(location, 1, uints); break;
+	case 12 + GL_TRACE_UNIFORM_UNSIGNED_INT: glUniform3uiv(location, 1, uints); break;
+	case 16 + GL_TRACE_UNIFORM_UNSIGNED_INT: glUniform4uiv(location, 1, uints); break;
+	}
+}
+
+GLuint createProgram(const Command& command)
+{
+	GLuint program = glCreateProgram();
+	const unsigned char* data = (const unsigned char*)command.data;
+	size_t position = 0;
+	for (uint32_t i = 0; i < command.words[1]; i++)
+	{
+		uint32_t header[2];
+		std::memcpy(header, data + position, sizeof(header));
+		position += sizeof(header);
+		const char* source = (const char*)data + position;
+		GLint length = (GLint)header[1];
+		position += header[1];
+
+		GLuint shader = glCreateShader(header[0]);
+		glShaderSource(shader, 1, &source, &length);
+		glCompileShader(shader);
+		GLint success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[512];
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::GL_TRACE_REPLAY::SHADER_COMPILATION_FAILED program " << command.words[0] << "\n" << infoLog << std::endl;
+		}
+		glAttachShader(program, shader);
+		glDeleteShader(shader);
+	}
+	glLinkProgram(program);
+	GLint success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[512];
+		glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::GL_TRACE_REPLAY::PROGRAM_LINK_FAILED program " << command.words[0] << "\n" << infoLog << std::endl;
+	}
+	return program;
+}
+
+void createTexture(const Command& command, ReplayNames& names)
+{
+	const uint32_t* w = command.words;
+	GLuint texture;
+	glGenTextures(1, &texture);
+	names.textures[w[0]] = texture;
+	GLsizei width = (GLsizei)w[2], height = (GLsizei)w[3], levels = std::max((GLsizei)w[4], 1);
+	if (width == 0)
+		return; // the frame's bind creates it
+	GLint internalFormat = (GLint)w[1];
+	GLenum format = w[10], type = w[11];
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // the capture is tightly packed
+	if (w[5] != 0 && GLAD_GL_VERSION_4_2)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+		if (command.dataSize > 0)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, command.data);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, command.dataSize > 0 ? command.data : NULL);
+		for (GLint level = 1; level < levels && command.dataSize == 0; level++)
+			glTexImage2D(GL_TEXTURE_2D, level, internalFormat, std::max(width >> level, 1), std::max(height >> level, 1), 0, format, type, NULL);
+		if (levels > 1 && command.dataSize > 0)
+			glGenerateMipmap(GL_TEXTURE_2D); // only level 0 is captured
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLint)w[6]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLint)w[7]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLint)w[8]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLint)w[9]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void execute(const Command& command, ReplayNames& names)
+{
+	const uint32_t* w = command.words;
+	switch (command.call)
+	{
+	case GL_TRACE_CREATE_BUFFER:
+	{
+		GLuint buffer;
+		glGenBuffers(1, &buffer);
+		names.buffers[w[0]] = buffer;
+		if (w[1] == 0)
+			break;
+		// storage is always mutable, mapped writes are replayed as sub data uploads
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, w[1], command.dataSize > 0 ? command.data : NULL, w[2]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		break;
+	}
+	case GL_TRACE_CREATE_TEXTURE_2D: createTexture(command, names); break;
+	case GL_TRACE_CREATE_PROGRAM: names.programs[w[0]] = createProgram(command); break;
+	case GL_TRACE_UNIFORM_LOCATION:
+	{
+		std::string name((const char*)command.data, command.dataSize);
+		names.locations[{ w[0], (GLint)w[1] }] = glGetUniformLocation(findName(names, names.programs, w[0]), name.c_str());
+		break;
+	}
+	case GL_TRACE_UNIFORM_VALUE:
+		glUseProgram(findName(names, names.programs, w[0]));
+		setUniformValue(findLocation(names, w[0], w[1]), w[2], command.data);
+		break;
+	case GL_TRACE_CREATE_VERTEX_ARRAY:
+	{
+		GLuint vertexArray;
+		glGenVertexArrays(1, &vertexArray);
+		names.vertexArrays[w[0]] = vertexArray;
+		glBindVertexArray(vertexArray);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, findName(names, names.buffers, w[1]));
+		break;
+	}
+	case GL_TRACE_VERTEX_ATTRIBUTE:
+		glBindVertexArray(findName(names, names.vertexArrays, w[0]));
+		glBindBuffer(GL_ARRAY_BUFFER, findName(names, names.buffers, w[3]));
+		if (w[3] != 0 && w[7] != 0)
+			glVertexAttribIPointer(w[1], (GLint)w[4], w[5], (GLsizei)w[8], toPointer(w[9]));
+		else if (w[3] != 0)
+			glVertexAttribPointer(w[1], (GLint)w[4], w[5], (GLboolean)w[6], (GLsizei)w[8], toPointer(w[9]));
+		if (w[2] != 0)
+			glEnableVertexAttribArray(w[1]);
+		else
+			glDisableVertexAttribArray(w[1]);
+		glVertexAttribDivisor(w[1], w[10]);
+		break;
+	case GL_TRACE_CREATE_FRAMEBUFFER:
+	{
+		GLuint framebuffer;
+		glGenFramebuffers(1, &framebuffer);
+		names.framebuffers[w[0]] = framebuffer;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		if (w[1] != 0)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, findName(names, names.textures, w[1]), 0);
+		if (w[2] != 0)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, findName(names, names.textures, w[2]), 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::GL_TRACE_REPLAY::FRAMEBUFFER_INCOMPLETE framebuffer " << w[0] << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		break;
+	}
+
+	case GL_TRACE_ENABLE: glEnable(w[0]); break;
+	case GL_TRACE_DISABLE: glDisable(w[0]); break;
+	case GL_TRACE_DEPTH_FUNC: glDepthFunc(w[0]); break;
+	case GL_TRACE_DEPTH_MASK: glDepthMask((GLboolean)w[0]); break;
+	case GL_TRACE_BLEND_FUNC: glBlendFunc(w[0], w[1]); break;
+	case GL_TRACE_CLIP_CONTROL:
+		if (glad_glClipControl != NULL)
+			glClipControl(w[0], w[1]);
+		break;
+	case GL_TRACE_CLEAR_DEPTH: glClearDepth(toFloat(w[0])); break;
+	case GL_TRACE_CLEAR_COLOR: glClearColor(toFloat(w[0]), toFloat(w[1]), toFloat(w[2]), toFloat(w[3])); break;
+	case GL_TRACE_VIEWPORT: glViewport((GLint)w[0], (GLint)w[1], (GLsizei)w[2], (GLsizei)w[3]); break;
+	case GL_TRACE_PIXEL_STORE: glPixelStorei(w[0], (GLint)w[1]); break;
+	case GL_TRACE_CLEAR: glClear(w[0]); break;
+
+	case GL_TRACE_USE_PROGRAM:
+		names.program = w[0];
+		glUseProgram(findName(names, names.programs, w[0]));
+		break;
+	case GL_TRACE_BIND_VERTEX_ARRAY: glBindVertexArray(findName(names, names.vertexArrays, w[0])); break;
+	case GL_TRACE_ACTIVE_TEXTURE: glActiveTexture(w[0]); break;
+	case GL_TRACE_BIND_TEXTURE: glBindTexture(w[0], findName(names, names.textures, w[1])); break;
+	case GL_TRACE_BIND_BUFFER: glBindBuffer(w[0], findName(names, names.buffers, w[1])); break;
+	case GL_TRACE_BIND_BUFFER_BASE: glBindBufferBase(w[0], w[1], findName(names, names.buffers, w[2])); break;
+	case GL_TRACE_BIND_FRAMEBUFFER: glBindFramebuffer(w[0], findName(names, names.framebuffers, w[1])); break;
+	case GL_TRACE_BIND_IMAGE_TEXTURE:
+		glBindImageTexture(w[0], findName(names, names.textures, w[1]), (GLint)w[2], (GLboolean)w[3], (GLint)w[4], w[5], w[6]);
+		break;
+
+	case GL_TRACE_UNIFORM_1I: glUniform1i(findLocation(names, names.program, w[0]), (GLint)w[1]); break;
+	case GL_TRACE_UNIFORM_1UI: glUniform1ui(findLocation(names, names.program, w[0]), w[1]); break;
+	case GL_TRACE_UNIFORM_1F: glUniform1f(findLocation(names, names.program, w[0]), toFloat(w[1])); break;
+	case GL_TRACE_UNIFORM_2F: glUniform2f(findLocation(names, names.program, w[0]), toFloat(w[1]), toFloat(w[2])); break;
+	case GL_TRACE_UNIFORM_4FV:
+		glUniform4fv(findLocation(names, names.program, w[0]), (GLsizei)w[1], (const GLfloat*)command.data);
+		break;
+	case GL_TRACE_UNIFORM_MATRIX_4FV:
+		glUniformMatrix4fv(findLocation(names, names.program, w[0]), (GLsizei)w[1], (GLboolean)w[2], (const GLfloat*)command.data);
+		break;
+
+	case GL_TRACE_BUFFER_DATA: glBufferData(w[0], w[1], command.dataSize > 0 ? command.data : NULL, w[2]); break;
+	case GL_TRACE_BUFFER_SUB_DATA: glBufferSubData(w[0], w[1], command.dataSize, command.data); break;
+	case GL_TRACE_TEX_IMAGE_2D:
+		glTexImage2D(w[0], (GLint)w[1], (GLint)w[2], (GLsizei)w[3], (GLsizei)w[4], 0, w[5], w[6], command.dataSize > 0 ? command.data : NULL);
+		break;
+	case GL_TRACE_TEX_SUB_IMAGE_2D:
+		glTexSubImage2D(w[0], (GLint)w[1], (GLint)w[2], (GLint)w[3], (GLsizei)w[4], (GLsizei)w[5], w[6], w[7], command.data);
+		break;
+	case GL_TRACE_MAPPED_WRITE:
+		glBindBuffer(GL_COPY_WRITE_BUFFER, findName(names, names.buffers, w[0]));
+		glBufferSubData(GL_COPY_WRITE_BUFFER, w[1], command.dataSize, command.data);
+		break;
+
+	case GL_TRACE_DRAW_ARRAYS: glDrawArrays(w[0], (GLint)w[1], (GLsizei)w[2]); break;
+	case GL_TRACE_DRAW_ELEMENTS: glDrawElements(w[0], (GLsizei)w[1], w[2], toPointer(w[3])); break;
+	case GL_TRACE_DRAW_ARRAYS_INSTANCED: glDrawArraysInstanced(w[0], (GLint)w[1], (GLsizei)w[2], (GLsizei)w[3]); break;
+	case GL_TRACE_DRAW_ELEMENTS_INSTANCED: glDrawElementsInstanced(w[0], (GLsizei)w[1], w[2], toPointer(w[3]), (GLsizei)w[4]); break;
+	case GL_TRACE_DRAW_ARRAYS_INDIRECT: glDrawArraysIndirect(w[0], toPointer(w[1])); break;
+	case GL_TRACE_DRAW_ELEMENTS_INDIRECT: glDrawElementsIndirect(w[0], w[1], toPointer(w[2])); break;
+	case GL_TRACE_BLIT_FRAMEBUFFER:
+		glBlitFramebuffer((GLint)w[0], (GLint)w[1], (GLint)w[2], (GLint)w[3], (GLint)w[4], (GLint)w[5], (GLint)w[6], (GLint)w[7], w[8], w[9]);
+		break;
+
+	case GL_TRACE_DISPATCH_COMPUTE: glDispatchCompute(w[0], w[1], w[2]); break;
+	case GL_TRACE_MEMORY_BARRIER: glMemoryBarrier(w[0]); break;
+
+	case GL_TRACE_PUSH_GROUP:
+		if (glad_glPushDebugGroup != NULL)
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, (GLsizei)command.dataSize, (const GLchar*)command.data);
+		break;
+	case GL_TRACE_POP_GROUP:
+		if (glad_glPopDebugGroup != NULL)
+			glPopDebugGroup();
+		break;
+	}
+}
+
+/* The bindings --sort-state sorts draws by */
+struct BindState
+{
+	uint32_t program = 0;
+	uint32_t vertexArray = 0;
+	uint32_t activeTexture = GL_TEXTURE0;
+	uint32_t textures[SORT_TEXTURE_UNITS] = {};
+
+	bool operator<(const BindState& other) const
+	{
+		if (program != other.program)
+			return program < other.program;
+		if (vertexArray != other.vertexArray)
+			return vertexArray < other.vertexArray;
+		return std::lexicographical_compare(textures, textures + SORT_TEXTURE_UNITS, other.textures, other.textures + SORT_TEXTURE_UNITS);
+	}
+};
+
+bool isTrackedBind(const Command& command)
+{
+	return command.call == GL_TRACE_USE_PROGRAM || command.call == GL_TRACE_BIND_VERTEX_ARRAY
+		|| command.call == GL_TRACE_ACTIVE_TEXTURE || (command.call == GL_TRACE_BIND_TEXTURE && command.words[0] == GL_TEXTURE_2D);
+}
+
+// true when the bind changes nothing
+bool applyBind(BindState& state, const Command& command)
+{
+	uint32_t* value = NULL;
+	uint32_t unit = state.activeTexture - GL_TEXTURE0;
+	if (command.call == GL_TRACE_USE_PROGRAM)
+		value = &state.program;
+	else if (command.call == GL_TRACE_BIND_VERTEX_ARRAY)
+		value = &state.vertexArray;
+	else if (command.call == GL_TRACE_ACTIVE_TEXTURE)
+		value = &state.activeTexture;
+	else if (command.call == GL_TRACE_BIND_TEXTURE && command.words[0] == GL_TEXTURE_2D && unit < SORT_TEXTURE_UNITS)
+		value = &state.textures[unit];
+	if (value == NULL)
+		return false;
+	uint32_t bound = command.call == GL_TRACE_BIND_TEXTURE ? command.words[1] : command.words[0];
+	bool redundant = *value == bound;
+	*value = bound;
+	return redundant;
+}
+
+Command makeCommand(uint16_t call, uint32_t first, uint32_t second = 0)
+{
+	Command command = {};
+	command.call = call;
+	command.wordCount = 2;
+	command.words[0] = first;
+	command.words[1] = second;
+	return command;
+}
+
+// appends the binds that turn the emitted state into target
+void emitTransition(std::vector<Command>& out, BindState& emitted, const BindState& target)
+{
+	if (emitted.program != target.program)
+		out.push_back(makeCommand(GL_TRACE_USE_PROGRAM, target.program));
+	if (emitted.vertexArray != target.vertexArray)
+		out.push_back(makeCommand(GL_TRACE_BIND_VERTEX_ARRAY, target.vertexArray));
+	for (uint32_t unit = 0; unit < SORT_TEXTURE_UNITS; unit++)
+	{
+		if (emitted.textures[unit] == target.textures[unit])
+			continue;
+		if (emitted.activeTexture != GL_TEXTURE0 + unit)
+			out.push_back(makeCommand(GL_TRACE_ACTIVE_TEXTURE, GL_TEXTURE0 + unit));
+		emitted.activeTexture = GL_TEXTURE0 + unit;
+		out.push_back(makeCommand(GL_TRACE_BIND_TEXTURE, GL_TEXTURE_2D, target.textures[unit]));
+	}
+	if (emitted.activeTexture != target.activeTexture)
+		out.push_back(makeCommand(GL_TRACE_ACTIVE_TEXTURE, target.activeTexture));
+	emitted = target;
+}
+
+// calls that may move with the draw they lead up to
+bool isSortable(const Command& command)
+{
+	GLTraceClass traceClass = getTraceClass(command.call);
+	return isTrackedBind(command) || command.call == GL_TRACE_BIND_BUFFER || traceClass == GL_TRACE_CLASS_UNIFORM
+		|| command.call == GL_TRACE_BUFFER_DATA || command.call == GL_TRACE_BUFFER_SUB_DATA || command.call == GL_TRACE_MAPPED_WRITE
+		|| (traceClass == GL_TRACE_CLASS_DRAW && command.call != GL_TRACE_BLIT_FRAMEBUFFER);
+}
+
+/* A draw and the calls since the previous one. Uniforms set for another program than the
+   draw's come first with their program, then the draw's bindings, then the rest in order */
+struct Batch
+{
+	BindState entry; // in capture order
+	BindState draw;
+	std::vector<Command> commands;
+};
+
+void emitBatch(std::vector<Command>& out, BindState& emitted, const Batch& batch)
+{
+	BindState state = batch.entry;
+	for (const Command& command : batch.commands)
+	{
+		applyBind(state, command);
+		if (getTraceClass(command.call) == GL_TRACE_CLASS_UNIFORM && state.program != batch.draw.program)
+		{
+			if (emitted.program != state.program)
+				out.push_back(makeCommand(GL_TRACE_USE_PROGRAM, state.program));
+			emitted.program = state.program;
+			out.push_back(command);
+		}
+	}
+	emitTransition(out, emitted, batch.draw);
+	state = batch.entry;
+	for (const Command& command : batch.commands)
+	{
+		applyBind(state, command);
+		bool otherProgram = getTraceClass(command.call) == GL_TRACE_CLASS_UNIFORM && state.program != batch.draw.program;
+		if (!isTrackedBind(command) && !otherProgram)
+			out.push_back(command);
+	}
+}
+
+// the frame with the draws of every run of sortable calls sorted by their bindings
+std::vector<Command> sortByState(const std::vector<Command>& frame, const BindState& start)
+{
+	std::vector<Command> out;
+	BindState captured = start; // as the capture had it
+	BindState emitted = start; // as the sorted frame has it
+	std::vector<Batch> batches;
+	Batch current;
+	current.entry = captured;
+
+	auto flush = [&]() {
+		std::stable_sort(batches.begin(), batches.end(), [](const Batch& a, const Batch& b) { return a.draw < b.draw; });
+		for (const Batch& batch : batches)
+			emitBatch(out, emitted, batch);
+		batches.clear();
+		// calls after the last draw run as captured, from the state they were captured in
+		emitTransition(out, emitted, current.entry);
+		for (const Command& command : current.commands)
+			if (!applyBind(emitted, command))
+				out.push_back(command);
+		current.commands.clear();
+		current.entry = captured;
+	};
+
+	for (const Command& command : frame)
+	{
+		if (!isSortable(command))
+		{
+			flush();
+			out.push_back(command);
+			continue;
+		}
+		applyBind(captured, command);
+		current.commands.push_back(command);
+		if (getTraceClass(command.call) == GL_TRACE_CLASS_DRAW)
+		{
+			current.draw = captured;
+			batches.push_back(current);
+			current.commands.clear();
+			current.entry = captured;
+		}
+	}
+	flush();
+	return out;
+}
+
+// the bindings the reset section leaves, where the frame starts
+BindState getStartState(const std::vector<Command>& reset)
+{
+	BindState state;
+	for (const Command& command : reset)
+		applyBind(state, command);
+	return state;
+}
+
+double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	return values.empty() ? 0.0 : values[values.size() / 2];
+}
+
+void printCounts(const char* label, const std::vector<Command>& commands)
+{
+	unsigned int counts[GL_TRACE_CLASS_COUNT] = {};
+	for (const Command& command : commands)
+		counts[getTraceClass(command.call)]++;
+	std::cout << label << " " << commands.size() << " calls:";
+	for (int i = GL_TRACE_CLASS_STATE; i < GL_TRACE_CLASS_COUNT; i++)
+		std::cout << " " << getTraceClassName((GLTraceClass)i) << " " << counts[i];
+	std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "usage: gl_trace_replay <trace> [--repeat N] [--skip <class>]... [--sort-state]" << std::endl;
+		return 1;
+	}
+	int repeat = DEFAULT_REPEAT;
+	bool skip[GL_TRACE_CLASS_COUNT] = {};
+	bool sortState = false;
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(std::atoi(argv[++i]), 1);
+		else if (std::strcmp(argv[i], "--sort-state") == 0)
+			sortState = true;
+		else if (std::strcmp(argv[i], "--skip") == 0 && i + 1 < argc)
+		{
+			const char* name = argv[++i];
+			bool known = false;
+			for (int c = GL_TRACE_CLASS_STATE; c < GL_TRACE_CLASS_COUNT; c++)
+				if (std::strcmp(name, getTraceClassName((GLTraceClass)c)) == 0)
+					known = skip[c] = true;
+			if (!known)
+			{
+				std::cout << "ERROR::GL_TRACE_REPLAY::UNKNOWN_CLASS " << name << std::endl;
+				return 1;
+			}
+		}
+		else
+		{
+			std::cout << "ERROR::GL_TRACE_REPLAY::UNKNOWN_OPTION " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	GLTraceHeader header;
+	if (bytes.size() < sizeof(header))
+	{
+		std::cout << "ERROR::GL_TRACE_REPLAY::FILE_NOT_SUCCESFULLY_READ " << argv[1] << std::endl;
+		return 1;
+	}
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	std::vector<Command> setup, reset, frame;
+	std::vector<std::vector<uint32_t>> storage;
+	const unsigned char* section = bytes.data() + sizeof(header);
+	if (header.magic != GL_TRACE_MAGIC || header.version != GL_TRACE_VERSION
+		|| sizeof(header) + (size_t)header.setupBytes + header.resetBytes + header.frameBytes > bytes.size()
+		|| !parseCommands(section, header.setupBytes, setup, storage)
+		|| !parseCommands(section + header.setupBytes, header.resetBytes, reset, storage)
+		|| !parseCommands(section + header.setupBytes + header.resetBytes, header.frameBytes, frame, storage))
+	{
+		std::cout << "ERROR::GL_TRACE_REPLAY::INVALID_TRACE " << argv[1] << std::endl;
+		return 1;
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(std::max((int)header.width, 1), std::max((int)header.height, 1), "gl_trace_replay", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	ReplayNames names;
+	for (const Command& command : setup)
+		execute(command, names);
+	glUseProgram(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	printCounts("captured", frame);
+	std::vector<Command> replayed;
+	for (const Command& command : frame)
+		if (!skip[getTraceClass(command.call)])
+			replayed.push_back(command);
+	if (sortState)
+		replayed = sortByState(replayed, getStartState(reset));
+	printCounts("replayed", replayed);
+
+	GLuint query;
+	glGenQueries(1, &query);
+	std::vector<double> cpuTimes, gpuTimes;
+	for (int run = 0; run <= repeat; run++)
+	{
+		for (const Command& command : reset)
+			execute(command, names);
+		glFinish(); // every replay starts on an idle GPU
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		double start = getSteadyTime();
+		for (const Command& command : replayed)
+			execute(command, names);
+		double cpuTime = getSteadyTime() - start;
+		glEndQuery(GL_TIME_ELAPSED);
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+		// the first replay compiles driver state and fills caches
+		if (run == 0)
+			continue;
+		cpuTimes.push_back(cpuTime * 1000.0);
+		gpuTimes.push_back((double)nanoseconds * 1e-6);
+	}
+
+	char line[256];
+	std::snprintf(line, sizeof(line), "%d replays  cpu ms: median %.3f min %.3f max %.3f  gpu ms: median %.3f min %.3f max %.3f",
+		repeat, median(cpuTimes), *std::min_element(cpuTimes.begin(), cpuTimes.end()), *std::max_element(cpuTimes.begin(), cpuTimes.end()),
+		median(gpuTimes), *std::min_element(gpuTimes.begin(), gpuTimes.end()), *std::max_element(gpuTimes.begin(), gpuTimes.end()));
+	std::cout << line << std::endl;
+	if (names.missing > 0)
+		std::cout << "ERROR::GL_TRACE_REPLAY::MISSING_OBJECTS " << names.missing << " uses of objects the trace does not create" << std::endl;
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+		std::cout << "ERROR::GL_TRACE_REPLAY::GL_ERROR 0x" << std::hex << error << std::dec << std::endl;
+
+	glDeleteQueries(1, &query);
+	glfwTerminate();
+	return 0;
+}
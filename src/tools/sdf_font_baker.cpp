@@ -0,0 +1,530 @@
+/* Offline tool that bakes a TrueType font into the signed distance field atlas read by
+   SdfFont, see include/sdf_font_format.h. Reads the glyph outlines itself (glyf fonts with
+   a format 4 cmap, which covers the usual .ttf files but not CFF based .otf ones) and is
+   not part of the Visual Studio project, build it on its own, e.g.
+
+     cl /EHsc /std:c++17 /I include src/tools/sdf_font_baker.cpp
+     g++ -std=c++17 -I include src/tools/sdf_font_baker.cpp -o sdf_font_baker
+
+   Usage: sdf_font_baker <font.ttf> <output.sdffont> [pixel height] */
+#include <sdf_font_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+const int FIRST_CODEPOINT = 32; // printable ASCII
+const int LAST_CODEPOINT = 126;
+const int ATLAS_WIDTH = 512;
+const int SPREAD = 6; // pixels of distance on each side of the outline
+const int GLYPH_GAP = 1; // keeps bilinear filtering from bleeding between glyphs
+const int CURVE_STEPS = 8; // line segments per quadratic curve
+const int MAX_COMPONENT_DEPTH = 8; // composite glyphs nest, a broken font must not recurse forever
+
+struct Point
+{
+	float x, y;
+};
+
+// a closed outline is a list of edges, in font units with y pointing up
+struct Edge
+{
+	Point from, to;
+};
+
+/* The tables of a TrueType font needed for the outlines and horizontal metrics.
+   Everything in the file is big endian */
+class TrueTypeFont
+{
+public:
+	int ascent = 0, descent = 0, lineGap = 0;
+
+	bool load(const std::vector<unsigned char>& fontData)
+	{
+		data = &fontData;
+		if (data->size() < 12)
+			return false;
+		uint32_t head = findTable("head"), hhea = findTable("hhea"), maxp = findTable("maxp");
+		cmap = findTable("cmap");
+		hmtx = findTable("hmtx");
+		loca = findTable("loca");
+		glyf = findTable("glyf");
+		if (head == 0 || hhea == 0 || maxp == 0 || cmap == 0 || hmtx == 0 || loca == 0 || glyf == 0)
+			return false;
+		longLocations = s16(head + 50) != 0;
+		ascent = s16(hhea + 4);
+		descent = s16(hhea + 6);
+		lineGap = s16(hhea + 8);
+		horizontalMetrics = u16(hhea + 34);
+		glyphCount = u16(maxp + 4);
+		characterMap = findCharacterMap();
+		return characterMap != 0;
+	}
+
+	// stbtt_ScaleForPixelHeight: ascent to descent spans pixelHeight
+	float scaleForPixelHeight(float pixelHeight) const
+	{
+		return pixelHeight / (float)(ascent - descent);
+	}
+
+	// 0, the missing glyph, for codepoints the font does not have
+	int glyphIndex(int codepoint) const
+	{
+		if (codepoint > 0xFFFF)
+			return 0;
+		int segments = u16(characterMap + 6) / 2;
+		uint32_t endCodes = characterMap + 14;
+		uint32_t startCodes = endCodes + segments * 2 + 2;
+		uint32_t deltas = startCodes + segments * 2;
+		uint32_t rangeOffsets = deltas + segments * 2;
+		for (int i = 0; i < segments; i++)
+		{
+			if (codepoint > u16(endCodes + i * 2))
+				continue;
+			int start = u16(startCodes + i * 2);
+			if (codepoint < start)
+				return 0;
+			int delta = s16(deltas + i * 2);
+			int rangeOffset = u16(rangeOffsets + i * 2);
+			if (rangeOffset == 0)
+				return (codepoint + delta) & 0xFFFF;
+			// the offset is relative to where it is stored
+			int glyph = u16(rangeOffsets + i * 2 + rangeOffset + (codepoint - start) * 2);
+			return glyph == 0 ? 0 : (glyph + delta) & 0xFFFF;
+		}
+		return 0;
+	}
+
+	int advance(int glyph) const
+	{
+		// glyphs past the last metric share its advance
+		int metric = std::min(glyph, horizontalMetrics - 1);
+		return u16(hmtx + metric * 4);
+	}
+
+	// false for glyphs without an outline such as space
+	bool boundingBox(int glyph, int& xMin, int& yMin, int& xMax, int& yMax) const
+	{
+		uint32_t offset = glyphOffset(glyph);
+		if (offset == 0)
+			return false;
+		xMin = s16(offset + 2);
+		yMin = s16(offset + 4);
+		xMax = s16(offset + 6);
+		yMax = s16(offset + 8);
+		return true;
+	}
+
+	void outline(int glyph, std::vector<Edge>& edges) const
+	{
+		addOutline(glyph, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, edges, 0);
+	}
+
+private:
+	const std::vector<unsigned char>* data = NULL;
+	uint32_t cmap = 0, hmtx = 0, loca = 0, glyf = 0;
+	uint32_t characterMap = 0; // the format 4 subtable
+	bool longLocations = false;
+	int horizontalMetrics = 0;
+	int glyphCount = 0;
+
+	// reads past the end return 0 instead of crashing on a broken file
+	unsigned char byte(uint32_t offset) const
+	{
+		return offset < data->size() ? (*data)[offset] : 0;
+	}
+
+	int u16(uint32_t offset) const
+	{
+		return byte(offset) << 8 | byte(offset + 1);
+	}
+
+	int s16(uint32_t offset) const
+	{
+		return (int16_t)u16(offset);
+	}
+
+	uint32_t u32(uint32_t offset) const
+	{
+		return (uint32_t)u16(offset) << 16 | (uint32_t)u16(offset + 2);
+	}
+
+	uint32_t findTable(const char* tag) const
+	{
+		int tableCount = u16(4);
+		for (int i = 0; i < tableCount; i++)
+		{
+			uint32_t record = 12 + i * 16;
+			if (record + 16 <= data->size() && std::memcmp(data->data() + record, tag, 4) == 0)
+				return u32(record + 8);
+		}
+		return 0;
+	}
+
+	// the Unicode BMP subtable, Windows or Unicode platform
+	uint32_t findCharacterMap() const
+	{
+		int subtableCount = u16(cmap + 2);
+		for (int i = 0; i < subtableCount; i++)
+		{
+			uint32_t record = cmap + 4 + i * 8;
+			int platform = u16(record), encoding = u16(record + 2);
+			uint32_t subtable = cmap + u32(record + 4);
+			bool unicode = (platform == 3 && encoding == 1) || platform == 0;
+			if (unicode && u16(subtable) == 4)
+				return subtable;
+		}
+		return 0;
+	}
+
+	// 0 for glyphs without an outline
+	uint32_t glyphOffset(int glyph) const
+	{
+		if (glyph >= glyphCount)
+			return 0;
+		uint32_t start, end;
+		if (longLocations)
+		{
+			start = u32(loca + glyph * 4);
+			end = u32(loca + glyph * 4 + 4);
+		}
+		else
+		{
+			start = u16(loca + glyph * 2) * 2;
+			end = u16(loca + glyph * 2 + 2) * 2;
+		}
+		return start == end ? 0 : glyf + start;
+	}
+
+	// edges of the glyph transformed by the 2x2 matrix (a b, c d) and offset (dx, dy)
+	void addOutline(int glyph, float a, float b, float c, float d, float dx, float dy, std::vector<Edge>& edges, int depth) const
+	{
+		uint32_t offset = glyphOffset(glyph);
+		if (offset == 0 || depth > MAX_COMPONENT_DEPTH)
+			return;
+		int contourCount = s16(offset);
+		auto transform = [&](float x, float y) { return Point{ a * x + c * y + dx, b * x + d * y + dy }; };
+		if (contourCount < 0)
+		{
+			addComponents(offset + 10, a, b, c, d, dx, dy, edges, depth);
+			return;
+		}
+
+		uint32_t endPoints = offset + 10;
+		int pointCount = contourCount == 0 ? 0 : u16(endPoints + (contourCount - 1) * 2) + 1;
+		uint32_t cursor = endPoints + contourCount * 2;
+		cursor += 2 + u16(cursor); // skips the instructions
+
+		// flags are run length encoded, the coordinates are deltas of 1 or 2 bytes
+		std::vector<unsigned char> flags(pointCount);
+		for (int i = 0; i < pointCount;)
+		{
+			unsigned char flag = byte(cursor++);
+			int repeat = (flag & 8) ? byte(cursor++) : 0;
+			for (int r = 0; r <= repeat && i < pointCount; r++)
+				flags[i++] = flag;
+		}
+		std::vector<Point> points(pointCount);
+		int value = 0;
+		for (int i = 0; i < pointCount; i++)
+		{
+			if (flags[i] & 2)
+				value += (flags[i] & 16) ? byte(cursor++) : -byte(cursor++);
+			else if (!(flags[i] & 16))
+			{
+				value += s16(cursor);
+				cursor += 2;
+			}
+			points[i].x = (float)value;
+		}
+		value = 0;
+		for (int i = 0; i < pointCount; i++)
+		{
+			if (flags[i] & 4)
+				value += (flags[i] & 32) ? byte(cursor++) : -byte(cursor++);
+			else if (!(flags[i] & 32))
+			{
+				value += s16(cursor);
+				cursor += 2;
+			}
+			points[i].y = (float)value;
+		}
+		for (int i = 0; i < pointCount; i++)
+			points[i] = transform(points[i].x, points[i].y);
+
+		int first = 0;
+		for (int contour = 0; contour < contourCount; contour++)
+		{
+			int last = std::min(u16(endPoints + contour * 2), pointCount - 1);
+			addContour(points, flags, first, last, edges);
+			first = last + 1;
+		}
+	}
+
+	void addComponents(uint32_t cursor, float a, float b, float c, float d, float dx, float dy, std::vector<Edge>& edges, int depth) const
+	{
+		const int ARGS_ARE_WORDS = 1, ARGS_ARE_XY = 2, HAS_SCALE = 8, MORE_COMPONENTS = 32, HAS_XY_SCALE = 64, HAS_2X2 = 128;
+		int flags;
+		do
+		{
+			flags = u16(cursor);
+			int component = u16(cursor + 2);
+			cursor += 4;
+			float offsetX = 0.0f, offsetY = 0.0f;
+			if (flags & ARGS_ARE_WORDS)
+			{
+				offsetX = (float)s16(cursor);
+				offsetY = (float)s16(cursor + 2);
+				cursor += 4;
+			}
+			else
+			{
+				offsetX = (float)(int8_t)byte(cursor);
+				offsetY = (float)(int8_t)byte(cursor + 1);
+				cursor += 2;
+			}
+			// point matching components are rare in Latin fonts, they are placed at the origin
+			if (!(flags & ARGS_ARE_XY))
+				offsetX = offsetY = 0.0f;
+			float ca = 1.0f, cb = 0.0f, cc = 0.0f, cd = 1.0f; // 2.14 fixed point in the file
+			if (flags & HAS_SCALE)
+			{
+				ca = cd = s16(cursor) / 16384.0f;
+				cursor += 2;
+			}
+			else if (flags & HAS_XY_SCALE)
+			{
+				ca = s16(cursor) / 16384.0f;
+				cd = s16(cursor + 2) / 16384.0f;
+				cursor += 4;
+			}
+			else if (flags & HAS_2X2)
+			{
+				ca = s16(cursor) / 16384.0f;
+				cb = s16(cursor + 2) / 16384.0f;
+				cc = s16(cursor + 4) / 16384.0f;
+				cd = s16(cursor + 6) / 16384.0f;
+				cursor += 8;
+			}
+			// the component's transform first, then the parent's
+			addOutline(component, a * ca + c * cb, b * ca + d * cb, a * cc + c * cd, b * cc + d * cd,
+				a * offsetX + c * offsetY + dx, b * offsetX + d * offsetY + dy, edges, depth + 1);
+		} while (flags & MORE_COMPONENTS);
+	}
+
+	/* A contour of on curve points joined by lines and off curve control points of quadratic
+	   curves. Two control points in a row have an implied on curve point halfway between */
+	static void addContour(const std::vector<Point>& points, const std::vector<unsigned char>& flags, int first, int last, std::vector<Edge>& edges)
+	{
+		int count = last - first + 1;
+		if (count < 2)
+			return;
+		auto onCurve = [&](int i) { return (flags[first + i % count] & 1) != 0; };
+		auto point = [&](int i) { return points[first + i % count]; };
+		auto midpoint = [](Point p, Point q) { return Point{ 0.5f * (p.x + q.x), 0.5f * (p.y + q.y) }; };
+
+		// start on a point that is on the curve, implied if there is none
+		int start = 0;
+		while (start < count && !onCurve(start))
+			start++;
+		Point startPoint = start < count ? point(start) : midpoint(point(0), point(1));
+		if (start == count)
+			start = 0;
+
+		Point current = startPoint;
+		for (int i = 1; i <= count; i++)
+		{
+			int index = start + i;
+			if (onCurve(index))
+			{
+				Point next = i == count ? startPoint : point(index);
+				edges.push_back({ current, next });
+				current = next;
+				continue;
+			}
+			Point control = point(index);
+			Point end;
+			if (i == count)
+				end = startPoint;
+			else if (onCurve(index + 1))
+			{
+				end = i + 1 == count ? startPoint : point(index + 1);
+				i++;
+			}
+			else
+				end = midpoint(control, point(index + 1));
+			for (int step = 1; step <= CURVE_STEPS; step++)
+			{
+				float t = (float)step / CURVE_STEPS;
+				float u = 1.0f - t;
+				Point next = { u * u * current.x + 2.0f * u * t * control.x + t * t * end.x,
+					u * u * current.y + 2.0f * u * t * control.y + t * t * end.y };
+				edges.push_back({ step == 1 ? current : edges.back().to, next });
+			}
+			current = end;
+		}
+	}
+};
+
+struct BakedGlyph
+{
+	SdfGlyph glyph;
+	std::vector<unsigned char> field;
+	int width, height;
+	int x, y; // top left in the atlas
+};
+
+/* Distance field of an outline in pixels, rows from the top. A texel is 128 on the outline
+   and moves 128 / SPREAD per pixel of distance, up inside and down outside */
+std::vector<unsigned char> distanceField(const std::vector<Edge>& edges, int left, int top, int width, int height)
+{
+	std::vector<unsigned char> field((size_t)width * height);
+	for (int row = 0; row < height; row++)
+	{
+		for (int column = 0; column < width; column++)
+		{
+			// the texel center, y pointing up like the edges
+			float x = left + column + 0.5f;
+			float y = -(top + row + 0.5f);
+			float closest = 1e30f;
+			int winding = 0;
+			for (const Edge& edge : edges)
+			{
+				float ex = edge.to.x - edge.from.x, ey = edge.to.y - edge.from.y;
+				float lengthSquared = ex * ex + ey * ey;
+				float t = lengthSquared > 0.0f ? ((x - edge.from.x) * ex + (y - edge.from.y) * ey) / lengthSquared : 0.0f;
+				t = std::min(std::max(t, 0.0f), 1.0f);
+				float dx = edge.from.x + t * ex - x, dy = edge.from.y + t * ey - y;
+				closest = std::min(closest, dx * dx + dy * dy);
+
+				// non-zero winding of a ray towards +x
+				if ((edge.from.y <= y) != (edge.to.y <= y))
+				{
+					float crossing = edge.from.x + (y - edge.from.y) / ey * ex;
+					if (crossing > x)
+						winding += edge.to.y > edge.from.y ? 1 : -1;
+				}
+			}
+			float distance = std::sqrt(closest) * (winding != 0 ? 1.0f : -1.0f);
+			float value = 128.0f + distance * 128.0f / SPREAD;
+			field[(size_t)row * width + column] = (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+		}
+	}
+	return field;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "usage: sdf_font_baker <font.ttf> <output.sdffont> [pixel height]" << std::endl;
+		return 1;
+	}
+	float pixelHeight = argc > 3 ? (float)std::atof(argv[3]) : 48.0f;
+
+	std::ifstream fontFile(argv[1], std::ios::binary);
+	std::vector<unsigned char> fontData((std::istreambuf_iterator<char>(fontFile)), std::istreambuf_iterator<char>());
+	TrueTypeFont font;
+	if (fontData.empty() || !font.load(fontData))
+	{
+		std::cout << "ERROR::FONT_BAKER::FONT_NOT_LOADED " << argv[1] << std::endl;
+		return 1;
+	}
+	float scale = font.scaleForPixelHeight(pixelHeight);
+
+	// rasterize every glyph and pack them into shelves from the top of the atlas
+	std::vector<BakedGlyph> glyphs;
+	std::vector<Edge> edges;
+	int shelfX = 0, shelfY = 0, shelfHeight = 0;
+	for (int codepoint = FIRST_CODEPOINT; codepoint <= LAST_CODEPOINT; codepoint++)
+	{
+		BakedGlyph baked = {};
+		int glyph = font.glyphIndex(codepoint);
+		baked.glyph.codepoint = (uint32_t)codepoint;
+		baked.glyph.advance = font.advance(glyph) * scale;
+
+		// the pixel box of the outline plus the spread, in pixels with y pointing down
+		int xMin, yMin, xMax, yMax;
+		if (!font.boundingBox(glyph, xMin, yMin, xMax, yMax))
+		{
+			glyphs.push_back(baked); // no outline, only an advance
+			continue;
+		}
+		int left = (int)std::floor(xMin * scale) - SPREAD;
+		int top = (int)std::floor(-yMax * scale) - SPREAD;
+		baked.width = (int)std::ceil(xMax * scale) + SPREAD - left;
+		baked.height = (int)std::ceil(-yMin * scale) + SPREAD - top;
+
+		edges.clear();
+		font.outline(glyph, edges);
+		for (Edge& edge : edges)
+		{
+			edge.from = { edge.from.x * scale, edge.from.y * scale };
+			edge.to = { edge.to.x * scale, edge.to.y * scale };
+		}
+		baked.field = distanceField(edges, left, top, baked.width, baked.height);
+
+		if (shelfX + baked.width > ATLAS_WIDTH)
+		{
+			shelfX = 0;
+			shelfY += shelfHeight + GLYPH_GAP;
+			shelfHeight = 0;
+		}
+		baked.x = shelfX;
+		baked.y = shelfY;
+		shelfX += baked.width + GLYPH_GAP;
+		shelfHeight = std::max(shelfHeight, baked.height);
+
+		// the box was measured from the top left with y pointing down
+		baked.glyph.offsetX = (float)left;
+		baked.glyph.offsetY = (float)-(top + baked.height);
+		baked.glyph.width = (float)baked.width;
+		baked.glyph.height = (float)baked.height;
+		glyphs.push_back(baked);
+	}
+	int atlasHeight = 1;
+	while (atlasHeight < shelfY + shelfHeight)
+		atlasHeight *= 2;
+
+	// atlas row r is texture row r, so a glyph's top row has the smaller v
+	std::vector<unsigned char> atlas((size_t)ATLAS_WIDTH * atlasHeight, 0);
+	for (BakedGlyph& baked : glyphs)
+	{
+		for (int row = 0; row < baked.height; row++)
+			std::copy_n(baked.field.data() + row * baked.width, baked.width, atlas.data() + (size_t)(baked.y + row) * ATLAS_WIDTH + baked.x);
+		baked.glyph.uvRect[0] = (float)baked.x / ATLAS_WIDTH;
+		baked.glyph.uvRect[1] = (float)(baked.y + baked.height) / atlasHeight;
+		baked.glyph.uvRect[2] = (float)(baked.x + baked.width) / ATLAS_WIDTH;
+		baked.glyph.uvRect[3] = (float)baked.y / atlasHeight;
+	}
+
+	SdfFontHeader header;
+	header.magic = SDF_FONT_MAGIC;
+	header.version = SDF_FONT_VERSION;
+	header.atlasWidth = ATLAS_WIDTH;
+	header.atlasHeight = (uint32_t)atlasHeight;
+	header.pixelHeight = pixelHeight;
+	header.lineHeight = (font.ascent - font.descent + font.lineGap) * scale;
+	header.ascent = font.ascent * scale;
+	header.spread = (float)SPREAD;
+	header.glyphCount = (uint32_t)glyphs.size();
+
+	std::ofstream output(argv[2], std::ios::binary);
+	output.write((const char*)&header, sizeof(header));
+	for (const BakedGlyph& baked : glyphs)
+		output.write((const char*)&baked.glyph, sizeof(baked.glyph));
+	output.write((const char*)atlas.data(), atlas.size());
+	if (!output)
+	{
+		std::cout << "ERROR::FONT_BAKER::FILE_NOT_WRITTEN " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << "baked " << glyphs.size() << " glyphs into a " << ATLAS_WIDTH << "x" << atlasHeight << " atlas" << std::endl;
+	return 0;
+}